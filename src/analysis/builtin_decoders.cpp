@@ -0,0 +1,761 @@
+#include "builtin_decoders.h"
+#include "protocol_analyzer.h"
+#include "checksum.h"
+#include "../common/byte_order.h"
+#include <cstring>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr uint32_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint32_t ETHERTYPE_ARP = 0x0806;
+constexpr uint32_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint32_t ETHERTYPE_IPV6 = 0x86DD;
+constexpr uint32_t ETHERTYPE_QINQ = 0x88A8;
+constexpr uint32_t ETHERTYPE_QINQ_LEGACY = 0x9100;
+
+// Ethertype values up to this are 802.3 length fields
+constexpr uint16_t ETHERNET_MAX_LENGTH = 1500;
+
+constexpr uint32_t IP_PROTO_ICMP = 1;
+constexpr uint32_t IP_PROTO_TCP = 6;
+constexpr uint32_t IP_PROTO_UDP = 17;
+constexpr uint32_t IP_PROTO_ICMPV6 = 58;
+
+constexpr uint8_t IPV6_HOP_BY_HOP = 0;
+constexpr uint8_t IPV6_ROUTING = 43;
+constexpr uint8_t IPV6_FRAGMENT = 44;
+constexpr uint8_t IPV6_AUTHENTICATION = 51;
+constexpr uint8_t IPV6_DEST_OPTIONS = 60;
+constexpr int IPV6_MAX_EXTENSIONS = 8;
+
+// Header layouts: field offsets and the size checked before any field is read
+struct EthernetLayout {
+    static constexpr size_t DESTINATION = 0;
+    static constexpr size_t SOURCE = 6;
+    static constexpr size_t ETHERTYPE = 12;
+    static constexpr size_t SIZE = 14;
+};
+
+struct VlanLayout {
+    static constexpr size_t TCI = 0;
+    static constexpr size_t ETHERTYPE = 2;
+    static constexpr size_t SIZE = 4;
+};
+
+struct ArpLayout {
+    static constexpr size_t HARDWARE_TYPE = 0;
+    static constexpr size_t PROTOCOL_TYPE = 2;
+    static constexpr size_t HARDWARE_SIZE = 4;
+    static constexpr size_t PROTOCOL_SIZE = 5;
+    static constexpr size_t OPCODE = 6;
+    static constexpr size_t SIZE = 8;                  // Addresses follow
+    static constexpr size_t ETHERNET_IPV4_SIZE = 28;
+};
+
+struct Ipv4Layout {
+    static constexpr size_t VERSION_IHL = 0;
+    static constexpr size_t DSFIELD = 1;
+    static constexpr size_t TOTAL_LENGTH = 2;
+    static constexpr size_t ID = 4;
+    static constexpr size_t FLAGS_FRAGMENT = 6;
+    static constexpr size_t TTL = 8;
+    static constexpr size_t PROTOCOL = 9;
+    static constexpr size_t CHECKSUM = 10;
+    static constexpr size_t SOURCE = 12;
+    static constexpr size_t DESTINATION = 16;
+    static constexpr size_t SIZE = 20;
+};
+
+struct Ipv6Layout {
+    static constexpr size_t VERSION_CLASS_FLOW = 0;
+    static constexpr size_t PAYLOAD_LENGTH = 4;
+    static constexpr size_t NEXT_HEADER = 6;
+    static constexpr size_t HOP_LIMIT = 7;
+    static constexpr size_t SOURCE = 8;
+    static constexpr size_t DESTINATION = 24;
+    static constexpr size_t SIZE = 40;
+};
+
+struct IcmpLayout {
+    static constexpr size_t TYPE = 0;
+    static constexpr size_t CODE = 1;
+    static constexpr size_t CHECKSUM = 2;
+    static constexpr size_t IDENTIFIER = 4;            // Echo messages
+    static constexpr size_t SEQUENCE = 6;
+    static constexpr size_t SIZE = 8;
+};
+
+struct TcpLayout {
+    static constexpr size_t SOURCE_PORT = 0;
+    static constexpr size_t DESTINATION_PORT = 2;
+    static constexpr size_t SEQUENCE = 4;
+    static constexpr size_t ACKNOWLEDGMENT = 8;
+    static constexpr size_t OFFSET_FLAGS = 12;
+    static constexpr size_t WINDOW = 14;
+    static constexpr size_t CHECKSUM = 16;
+    static constexpr size_t URGENT_POINTER = 18;
+    static constexpr size_t SIZE = 20;
+};
+
+struct UdpLayout {
+    static constexpr size_t SOURCE_PORT = 0;
+    static constexpr size_t DESTINATION_PORT = 2;
+    static constexpr size_t LENGTH = 4;
+    static constexpr size_t CHECKSUM = 6;
+    static constexpr size_t SIZE = 8;
+};
+
+FieldId intern(const char* name, FieldType type, const char* description) {
+    return FieldRegistry::instance().intern(name, type, description);
+}
+
+// Both ports of a TCP or UDP segment, the lower (usually the well-known
+// service) first
+void push_ports(DecodedPacket& decoded, DispatchTable table, uint16_t source, uint16_t destination) {
+    uint16_t low = source < destination ? source : destination;
+    uint16_t high = source < destination ? destination : source;
+    
+    decoded.next_protocols.push_back({table, low});
+    if (high != low) {
+        decoded.next_protocols.push_back({table, high});
+    }
+}
+
+uint64_t checksum_status(bool good) {
+    return static_cast<uint64_t>(good ? ChecksumStatus::GOOD : ChecksumStatus::BAD);
+}
+
+// Verify the checksum of the transport message at span (not yet consumed)
+// over the length the IP layer below declares, with the pseudo-header for
+// TCP, UDP and ICMPv6. Unverified when the message is one fragment of a
+// datagram or was cut short by the snapshot length.
+uint64_t verify_transport_checksum(const LayerSpan& span, const DecodedPacket& decoded,
+                                   uint8_t protocol, bool pseudo_header) {
+    static const FieldId ipv6_more_fragments =
+        intern("ipv6.fragment.more", FieldType::BOOLEAN, "More fragments");
+    
+    const uint64_t unverified = static_cast<uint64_t>(ChecksumStatus::UNVERIFIED);
+    if (decoded.layers.empty()) {
+        return unverified;
+    }
+    
+    const ProtocolLayer& ip = decoded.layers.back();
+    const uint8_t* header = span.data - (span.offset - ip.offset);
+    size_t length;
+    uint32_t sum = 0;
+    
+    if (ip.protocol == "ip") {
+        using L = Ipv4Layout;
+        size_t total_length = load_be16(header + L::TOTAL_LENGTH);
+        
+        // More fragments or a fragment offset
+        if ((load_be16(header + L::FLAGS_FRAGMENT) & 0x3FFF) != 0 || total_length < ip.length) {
+            return unverified;
+        }
+        
+        length = total_length - ip.length;
+        if (pseudo_header) {
+            sum = checksum_sum(header + L::SOURCE, 8, protocol + static_cast<uint32_t>(length));
+        }
+    } else if (ip.protocol == "ipv6") {
+        using L = Ipv6Layout;
+        size_t payload_length = load_be16(header + L::PAYLOAD_LENGTH);
+        
+        // Jumbograms and first fragments
+        const PacketField* more = decoded.find_field(ipv6_more_fragments);
+        if (payload_length == 0 || payload_length + L::SIZE < ip.length || (more && more->value)) {
+            return unverified;
+        }
+        
+        length = payload_length + L::SIZE - ip.length;
+        if (pseudo_header) {
+            sum = checksum_sum(header + L::SOURCE, 32,
+                               protocol + static_cast<uint32_t>(length >> 16) +
+                                   static_cast<uint32_t>(length & 0xFFFF));
+        }
+    } else {
+        return unverified;
+    }
+    
+    if (span.length < length) {
+        return unverified;
+    }
+    
+    return checksum_status(checksum_sum(span.data, length, sum) == 0xFFFF);
+}
+
+// Base for decoders reached by key only
+class KeyedDecoder : public ProtocolDecoder {
+public:
+    bool can_decode(const LayerSpan&, const DecodedPacket&) const override {
+        return false;
+    }
+    
+    void set_checksum_verification(bool enabled) override {
+        m_verify_checksums = enabled;
+    }
+
+protected:
+    bool m_verify_checksums = false;
+};
+
+class EthernetDecoder : public KeyedDecoder {
+public:
+    EthernetDecoder()
+        : m_destination(intern("eth.dst", FieldType::MAC, "Destination")),
+          m_source(intern("eth.src", FieldType::MAC, "Source")),
+          m_type(intern("eth.type", FieldType::HEX, "Type")),
+          m_length(intern("eth.len", FieldType::UNSIGNED, "Length")) {}
+    
+    std::string get_protocol_name() const override { return "eth"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::LINK_TYPE, DLT_EN10MB}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = EthernetLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint16_t type = load_be16(header + L::ETHERTYPE);
+        
+        decoded.add_field(m_destination, span.offset + L::DESTINATION, 6);
+        decoded.add_field(m_source, span.offset + L::SOURCE, 6);
+        
+        if (type <= ETHERNET_MAX_LENGTH) {
+            // 802.3 with LLC, which is not decoded further
+            decoded.add_field(m_length, span.offset + L::ETHERTYPE, 2, type);
+        } else {
+            decoded.add_field(m_type, span.offset + L::ETHERTYPE, 2, type);
+            decoded.next_protocols.push_back({DispatchTable::ETHERTYPE, type});
+        }
+        
+        span.consume(L::SIZE);
+        return true;
+    }
+
+private:
+    FieldId m_destination;
+    FieldId m_source;
+    FieldId m_type;
+    FieldId m_length;
+};
+
+class VlanDecoder : public KeyedDecoder {
+public:
+    VlanDecoder()
+        : m_priority(intern("vlan.priority", FieldType::UNSIGNED, "Priority")),
+          m_dei(intern("vlan.dei", FieldType::BOOLEAN, "Drop eligible")),
+          m_id(intern("vlan.id", FieldType::UNSIGNED, "VLAN identifier")),
+          m_type(intern("vlan.etype", FieldType::HEX, "Type")) {}
+    
+    std::string get_protocol_name() const override { return "vlan"; }
+    
+    // Outer QinQ tags dispatch back here for the inner tag
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::ETHERTYPE, ETHERTYPE_VLAN},
+                {DispatchTable::ETHERTYPE, ETHERTYPE_QINQ},
+                {DispatchTable::ETHERTYPE, ETHERTYPE_QINQ_LEGACY}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = VlanLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        uint16_t tci = load_be16(span.data + L::TCI);
+        uint16_t type = load_be16(span.data + L::ETHERTYPE);
+        
+        decoded.add_field(m_priority, span.offset + L::TCI, 2, tci >> 13);
+        decoded.add_field(m_dei, span.offset + L::TCI, 2, (tci >> 12) & 0x1);
+        decoded.add_field(m_id, span.offset + L::TCI, 2, tci & 0x0FFF);
+        decoded.add_field(m_type, span.offset + L::ETHERTYPE, 2, type);
+        decoded.next_protocols.push_back({DispatchTable::ETHERTYPE, type});
+        
+        span.consume(L::SIZE);
+        return true;
+    }
+
+private:
+    FieldId m_priority;
+    FieldId m_dei;
+    FieldId m_id;
+    FieldId m_type;
+};
+
+class ArpDecoder : public KeyedDecoder {
+public:
+    ArpDecoder()
+        : m_hardware_type(intern("arp.hw.type", FieldType::UNSIGNED, "Hardware type")),
+          m_protocol_type(intern("arp.proto.type", FieldType::HEX, "Protocol type")),
+          m_opcode(intern("arp.opcode", FieldType::UNSIGNED, "Opcode")),
+          m_sender_mac(intern("arp.src.hw_mac", FieldType::MAC, "Sender MAC address")),
+          m_sender_ip(intern("arp.src.proto_ipv4", FieldType::IPV4, "Sender IP address")),
+          m_target_mac(intern("arp.dst.hw_mac", FieldType::MAC, "Target MAC address")),
+          m_target_ip(intern("arp.dst.proto_ipv4", FieldType::IPV4, "Target IP address")) {}
+    
+    std::string get_protocol_name() const override { return "arp"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::ETHERTYPE, ETHERTYPE_ARP}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = ArpLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        size_t hardware_size = header[L::HARDWARE_SIZE];
+        size_t protocol_size = header[L::PROTOCOL_SIZE];
+        size_t size = L::SIZE + 2 * (hardware_size + protocol_size);
+        
+        if (span.length < size) {
+            return false;
+        }
+        
+        decoded.add_field(m_hardware_type, span.offset + L::HARDWARE_TYPE, 2,
+                          load_be16(header + L::HARDWARE_TYPE));
+        decoded.add_field(m_protocol_type, span.offset + L::PROTOCOL_TYPE, 2,
+                          load_be16(header + L::PROTOCOL_TYPE));
+        decoded.add_field(m_opcode, span.offset + L::OPCODE, 2, load_be16(header + L::OPCODE));
+        
+        // Addresses are only named for the Ethernet/IPv4 case
+        if (size == L::ETHERNET_IPV4_SIZE && hardware_size == 6) {
+            decoded.add_field(m_sender_mac, span.offset + 8, 6);
+            decoded.add_field(m_sender_ip, span.offset + 14, 4);
+            decoded.add_field(m_target_mac, span.offset + 18, 6);
+            decoded.add_field(m_target_ip, span.offset + 24, 4);
+        }
+        
+        span.consume(size);
+        return true;
+    }
+
+private:
+    FieldId m_hardware_type;
+    FieldId m_protocol_type;
+    FieldId m_opcode;
+    FieldId m_sender_mac;
+    FieldId m_sender_ip;
+    FieldId m_target_mac;
+    FieldId m_target_ip;
+};
+
+class Ipv4Decoder : public KeyedDecoder {
+public:
+    Ipv4Decoder()
+        : m_header_length(intern("ip.hdr_len", FieldType::UNSIGNED, "Header length")),
+          m_dsfield(intern("ip.dsfield", FieldType::HEX, "Differentiated services")),
+          m_total_length(intern("ip.len", FieldType::UNSIGNED, "Total length")),
+          m_id(intern("ip.id", FieldType::HEX, "Identification")),
+          m_flags(intern("ip.flags", FieldType::HEX, "Flags")),
+          m_fragment_offset(intern("ip.frag_offset", FieldType::UNSIGNED, "Fragment offset")),
+          m_ttl(intern("ip.ttl", FieldType::UNSIGNED, "Time to live")),
+          m_protocol(intern("ip.proto", FieldType::UNSIGNED, "Protocol")),
+          m_checksum(intern("ip.checksum", FieldType::HEX, "Header checksum")),
+          m_checksum_status(intern("ip.checksum.status", FieldType::CHECKSUM_STATUS, "Header checksum status")),
+          m_source(intern("ip.src", FieldType::IPV4, "Source address")),
+          m_destination(intern("ip.dst", FieldType::IPV4, "Destination address")) {}
+    
+    std::string get_protocol_name() const override { return "ip"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::ETHERTYPE, ETHERTYPE_IPV4}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = Ipv4Layout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint8_t version_ihl = header[L::VERSION_IHL];
+        size_t header_length = static_cast<size_t>(version_ihl & 0x0F) * 4;
+        
+        if ((version_ihl >> 4) != 4 || header_length < L::SIZE || span.length < header_length) {
+            return false;
+        }
+        
+        uint16_t total_length = load_be16(header + L::TOTAL_LENGTH);
+        uint16_t flags_fragment = load_be16(header + L::FLAGS_FRAGMENT);
+        uint8_t protocol = header[L::PROTOCOL];
+        
+        size_t base = span.offset;
+        decoded.add_field(m_header_length, base + L::VERSION_IHL, 1, header_length);
+        decoded.add_field(m_dsfield, base + L::DSFIELD, 1, header[L::DSFIELD]);
+        decoded.add_field(m_total_length, base + L::TOTAL_LENGTH, 2, total_length);
+        decoded.add_field(m_id, base + L::ID, 2, load_be16(header + L::ID));
+        decoded.add_field(m_flags, base + L::FLAGS_FRAGMENT, 2, flags_fragment >> 13);
+        decoded.add_field(m_fragment_offset, base + L::FLAGS_FRAGMENT, 2, (flags_fragment & 0x1FFF) * 8);
+        decoded.add_field(m_ttl, base + L::TTL, 1, header[L::TTL]);
+        decoded.add_field(m_protocol, base + L::PROTOCOL, 1, protocol);
+        decoded.add_field(m_checksum, base + L::CHECKSUM, 2, load_be16(header + L::CHECKSUM));
+        if (m_verify_checksums) {
+            decoded.add_field(m_checksum_status, base + L::CHECKSUM, 2,
+                              checksum_status(checksum_sum(header, header_length) == 0xFFFF));
+        }
+        decoded.add_field(m_source, base + L::SOURCE, 4);
+        decoded.add_field(m_destination, base + L::DESTINATION, 4);
+        
+        span.consume(header_length);
+        
+        // Drop link-layer padding; a bogus total length leaves the span alone
+        if (total_length >= header_length) {
+            span.truncate(total_length - header_length);
+        }
+        
+        // Only the first fragment starts with the transport header
+        if ((flags_fragment & 0x1FFF) == 0) {
+            decoded.next_protocols.push_back({DispatchTable::IP_PROTOCOL, protocol});
+        }
+        
+        return true;
+    }
+
+private:
+    FieldId m_header_length;
+    FieldId m_dsfield;
+    FieldId m_total_length;
+    FieldId m_id;
+    FieldId m_flags;
+    FieldId m_fragment_offset;
+    FieldId m_ttl;
+    FieldId m_protocol;
+    FieldId m_checksum;
+    FieldId m_checksum_status;
+    FieldId m_source;
+    FieldId m_destination;
+};
+
+class Ipv6Decoder : public KeyedDecoder {
+public:
+    Ipv6Decoder()
+        : m_traffic_class(intern("ipv6.tclass", FieldType::HEX, "Traffic class")),
+          m_flow_label(intern("ipv6.flow", FieldType::HEX, "Flow label")),
+          m_payload_length(intern("ipv6.plen", FieldType::UNSIGNED, "Payload length")),
+          m_next_header(intern("ipv6.nxt", FieldType::UNSIGNED, "Next header")),
+          m_hop_limit(intern("ipv6.hlim", FieldType::UNSIGNED, "Hop limit")),
+          m_source(intern("ipv6.src", FieldType::IPV6, "Source address")),
+          m_destination(intern("ipv6.dst", FieldType::IPV6, "Destination address")),
+          m_extension(intern("ipv6.ext", FieldType::UNSIGNED, "Extension header")),
+          m_fragment_offset(intern("ipv6.fragment.offset", FieldType::UNSIGNED, "Fragment offset")),
+          m_more_fragments(intern("ipv6.fragment.more", FieldType::BOOLEAN, "More fragments")) {}
+    
+    std::string get_protocol_name() const override { return "ipv6"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::ETHERTYPE, ETHERTYPE_IPV6}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = Ipv6Layout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint32_t version_class_flow = load_be32(header + L::VERSION_CLASS_FLOW);
+        
+        if ((version_class_flow >> 28) != 6) {
+            return false;
+        }
+        
+        uint16_t payload_length = load_be16(header + L::PAYLOAD_LENGTH);
+        uint8_t next_header = header[L::NEXT_HEADER];
+        
+        size_t base = span.offset;
+        decoded.add_field(m_traffic_class, base, 2, (version_class_flow >> 20) & 0xFF);
+        decoded.add_field(m_flow_label, base + 1, 3, version_class_flow & 0xFFFFF);
+        decoded.add_field(m_payload_length, base + L::PAYLOAD_LENGTH, 2, payload_length);
+        decoded.add_field(m_next_header, base + L::NEXT_HEADER, 1, next_header);
+        decoded.add_field(m_hop_limit, base + L::HOP_LIMIT, 1, header[L::HOP_LIMIT]);
+        decoded.add_field(m_source, base + L::SOURCE, 16);
+        decoded.add_field(m_destination, base + L::DESTINATION, 16);
+        
+        span.consume(L::SIZE);
+        
+        // A zero payload length means a jumbogram; keep the captured bytes
+        if (payload_length > 0) {
+            span.truncate(payload_length);
+        }
+        
+        // Extension headers belong to this layer; the transport follows them
+        bool first_fragment = true;
+        
+        for (int i = 0; i < IPV6_MAX_EXTENSIONS; ++i) {
+            size_t length;
+            
+            if (next_header == IPV6_HOP_BY_HOP || next_header == IPV6_ROUTING ||
+                next_header == IPV6_DEST_OPTIONS) {
+                if (span.length < 2) {
+                    return false;
+                }
+                length = (static_cast<size_t>(span.data[1]) + 1) * 8;
+            } else if (next_header == IPV6_FRAGMENT) {
+                length = 8;
+                if (span.length >= length) {
+                    uint16_t fragment = load_be16(span.data + 2);
+                    decoded.add_field(m_fragment_offset, span.offset + 2, 2, fragment & 0xFFF8);
+                    decoded.add_field(m_more_fragments, span.offset + 3, 1, fragment & 0x1);
+                    first_fragment = (fragment & 0xFFF8) == 0;
+                }
+            } else if (next_header == IPV6_AUTHENTICATION) {
+                if (span.length < 2) {
+                    return false;
+                }
+                length = (static_cast<size_t>(span.data[1]) + 2) * 4;
+            } else {
+                break;
+            }
+            
+            if (span.length < length) {
+                return false;
+            }
+            
+            decoded.add_field(m_extension, span.offset, length, next_header);
+            next_header = span.data[0];
+            span.consume(length);
+        }
+        
+        if (first_fragment) {
+            decoded.next_protocols.push_back({DispatchTable::IP_PROTOCOL, next_header});
+        }
+        
+        return true;
+    }
+
+private:
+    FieldId m_traffic_class;
+    FieldId m_flow_label;
+    FieldId m_payload_length;
+    FieldId m_next_header;
+    FieldId m_hop_limit;
+    FieldId m_source;
+    FieldId m_destination;
+    FieldId m_extension;
+    FieldId m_fragment_offset;
+    FieldId m_more_fragments;
+};
+
+// ICMP and ICMPv6 share the header layout and the echo fields
+class IcmpDecoder : public KeyedDecoder {
+public:
+    explicit IcmpDecoder(bool ipv6)
+        : m_name(ipv6 ? "icmpv6" : "icmp"),
+          m_protocol(ipv6 ? IP_PROTO_ICMPV6 : IP_PROTO_ICMP),
+          m_echo_request(ipv6 ? 128 : 8),
+          m_echo_reply(ipv6 ? 129 : 0),
+          m_type(intern((m_name + ".type").c_str(), FieldType::UNSIGNED, "Type")),
+          m_code(intern((m_name + ".code").c_str(), FieldType::UNSIGNED, "Code")),
+          m_checksum(intern((m_name + ".checksum").c_str(), FieldType::HEX, "Checksum")),
+          m_checksum_status(intern((m_name + ".checksum.status").c_str(), FieldType::CHECKSUM_STATUS,
+                                   "Checksum status")),
+          m_identifier(intern((m_name + ".echo.id").c_str(), FieldType::HEX, "Identifier")),
+          m_sequence(intern((m_name + ".echo.seq").c_str(), FieldType::UNSIGNED, "Sequence number")) {}
+    
+    std::string get_protocol_name() const override { return m_name; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::IP_PROTOCOL, m_protocol}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = IcmpLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint8_t type = header[L::TYPE];
+        
+        decoded.add_field(m_type, span.offset + L::TYPE, 1, type);
+        decoded.add_field(m_code, span.offset + L::CODE, 1, header[L::CODE]);
+        decoded.add_field(m_checksum, span.offset + L::CHECKSUM, 2, load_be16(header + L::CHECKSUM));
+        if (m_verify_checksums) {
+            // ICMPv6 covers a pseudo-header, ICMP only the message
+            decoded.add_field(m_checksum_status, span.offset + L::CHECKSUM, 2,
+                              verify_transport_checksum(span, decoded, m_protocol, m_protocol == IP_PROTO_ICMPV6));
+        }
+        
+        if (type == m_echo_request || type == m_echo_reply) {
+            decoded.add_field(m_identifier, span.offset + L::IDENTIFIER, 2, load_be16(header + L::IDENTIFIER));
+            decoded.add_field(m_sequence, span.offset + L::SEQUENCE, 2, load_be16(header + L::SEQUENCE));
+        }
+        
+        span.consume(L::SIZE);
+        return true;
+    }
+
+private:
+    std::string m_name;
+    uint32_t m_protocol;
+    uint8_t m_echo_request;
+    uint8_t m_echo_reply;
+    FieldId m_type;
+    FieldId m_code;
+    FieldId m_checksum;
+    FieldId m_checksum_status;
+    FieldId m_identifier;
+    FieldId m_sequence;
+};
+
+class TcpDecoder : public KeyedDecoder {
+public:
+    TcpDecoder()
+        : m_source_port(intern("tcp.srcport", FieldType::UNSIGNED, "Source port")),
+          m_destination_port(intern("tcp.dstport", FieldType::UNSIGNED, "Destination port")),
+          m_sequence(intern("tcp.seq", FieldType::UNSIGNED, "Sequence number")),
+          m_acknowledgment(intern("tcp.ack", FieldType::UNSIGNED, "Acknowledgment number")),
+          m_header_length(intern("tcp.hdr_len", FieldType::UNSIGNED, "Header length")),
+          m_flags(intern("tcp.flags", FieldType::HEX, "Flags")),
+          m_window(intern("tcp.window_size", FieldType::UNSIGNED, "Window")),
+          m_checksum(intern("tcp.checksum", FieldType::HEX, "Checksum")),
+          m_checksum_status(intern("tcp.checksum.status", FieldType::CHECKSUM_STATUS, "Checksum status")),
+          m_urgent_pointer(intern("tcp.urgent_pointer", FieldType::UNSIGNED, "Urgent pointer")) {}
+    
+    std::string get_protocol_name() const override { return "tcp"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::IP_PROTOCOL, IP_PROTO_TCP}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = TcpLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint16_t offset_flags = load_be16(header + L::OFFSET_FLAGS);
+        size_t header_length = static_cast<size_t>(offset_flags >> 12) * 4;
+        
+        if (header_length < L::SIZE || span.length < header_length) {
+            return false;
+        }
+        
+        uint16_t source_port = load_be16(header + L::SOURCE_PORT);
+        uint16_t destination_port = load_be16(header + L::DESTINATION_PORT);
+        
+        size_t base = span.offset;
+        decoded.add_field(m_source_port, base + L::SOURCE_PORT, 2, source_port);
+        decoded.add_field(m_destination_port, base + L::DESTINATION_PORT, 2, destination_port);
+        decoded.add_field(m_sequence, base + L::SEQUENCE, 4, load_be32(header + L::SEQUENCE));
+        decoded.add_field(m_acknowledgment, base + L::ACKNOWLEDGMENT, 4, load_be32(header + L::ACKNOWLEDGMENT));
+        decoded.add_field(m_header_length, base + L::OFFSET_FLAGS, 1, header_length);
+        decoded.add_field(m_flags, base + L::OFFSET_FLAGS, 2, offset_flags & 0x0FFF);
+        decoded.add_field(m_window, base + L::WINDOW, 2, load_be16(header + L::WINDOW));
+        decoded.add_field(m_checksum, base + L::CHECKSUM, 2, load_be16(header + L::CHECKSUM));
+        if (m_verify_checksums) {
+            decoded.add_field(m_checksum_status, base + L::CHECKSUM, 2,
+                              verify_transport_checksum(span, decoded, IP_PROTO_TCP, true));
+        }
+        decoded.add_field(m_urgent_pointer, base + L::URGENT_POINTER, 2, load_be16(header + L::URGENT_POINTER));
+        
+        span.consume(header_length);
+        
+        // Segments without payload carry no application layer
+        if (span.length > 0) {
+            push_ports(decoded, DispatchTable::TCP_PORT, source_port, destination_port);
+        }
+        
+        return true;
+    }
+
+private:
+    FieldId m_source_port;
+    FieldId m_destination_port;
+    FieldId m_sequence;
+    FieldId m_acknowledgment;
+    FieldId m_header_length;
+    FieldId m_flags;
+    FieldId m_window;
+    FieldId m_checksum;
+    FieldId m_checksum_status;
+    FieldId m_urgent_pointer;
+};
+
+class UdpDecoder : public KeyedDecoder {
+public:
+    UdpDecoder()
+        : m_source_port(intern("udp.srcport", FieldType::UNSIGNED, "Source port")),
+          m_destination_port(intern("udp.dstport", FieldType::UNSIGNED, "Destination port")),
+          m_length(intern("udp.length", FieldType::UNSIGNED, "Length")),
+          m_checksum(intern("udp.checksum", FieldType::HEX, "Checksum")),
+          m_checksum_status(intern("udp.checksum.status", FieldType::CHECKSUM_STATUS, "Checksum status")) {}
+    
+    std::string get_protocol_name() const override { return "udp"; }
+    
+    std::vector<DispatchKey> get_dispatch_keys() const override {
+        return {{DispatchTable::IP_PROTOCOL, IP_PROTO_UDP}};
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        using L = UdpLayout;
+        if (span.length < L::SIZE) {
+            return false;
+        }
+        
+        const uint8_t* header = span.data;
+        uint16_t source_port = load_be16(header + L::SOURCE_PORT);
+        uint16_t destination_port = load_be16(header + L::DESTINATION_PORT);
+        uint16_t length = load_be16(header + L::LENGTH);
+        uint16_t checksum = load_be16(header + L::CHECKSUM);
+        
+        size_t base = span.offset;
+        decoded.add_field(m_source_port, base + L::SOURCE_PORT, 2, source_port);
+        decoded.add_field(m_destination_port, base + L::DESTINATION_PORT, 2, destination_port);
+        decoded.add_field(m_length, base + L::LENGTH, 2, length);
+        decoded.add_field(m_checksum, base + L::CHECKSUM, 2, checksum);
+        
+        // A zero checksum over IPv4 means none was computed
+        if (m_verify_checksums) {
+            bool absent = checksum == 0 && !decoded.layers.empty() && decoded.layers.back().protocol == "ip";
+            decoded.add_field(m_checksum_status, base + L::CHECKSUM, 2,
+                              absent ? static_cast<uint64_t>(ChecksumStatus::UNVERIFIED)
+                                     : verify_transport_checksum(span, decoded, IP_PROTO_UDP, true));
+        }
+        
+        span.consume(L::SIZE);
+        if (length >= L::SIZE) {
+            span.truncate(length - L::SIZE);
+        }
+        
+        if (span.length > 0) {
+            push_ports(decoded, DispatchTable::UDP_PORT, source_port, destination_port);
+        }
+        
+        return true;
+    }
+
+private:
+    FieldId m_source_port;
+    FieldId m_destination_port;
+    FieldId m_length;
+    FieldId m_checksum;
+    FieldId m_checksum_status;
+};
+
+} // namespace
+
+void register_builtin_decoders(ProtocolAnalyzer& analyzer) {
+    analyzer.register_decoder(std::make_shared<EthernetDecoder>());
+    analyzer.register_decoder(std::make_shared<VlanDecoder>());
+    analyzer.register_decoder(std::make_shared<ArpDecoder>());
+    analyzer.register_decoder(std::make_shared<Ipv4Decoder>());
+    analyzer.register_decoder(std::make_shared<Ipv6Decoder>());
+    analyzer.register_decoder(std::make_shared<IcmpDecoder>(false));
+    analyzer.register_decoder(std::make_shared<IcmpDecoder>(true));
+    analyzer.register_decoder(std::make_shared<TcpDecoder>());
+    analyzer.register_decoder(std::make_shared<UdpDecoder>());
+}
+
+} // namespace wireshark_mcp
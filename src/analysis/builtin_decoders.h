@@ -0,0 +1,16 @@
+#pragma once
+
+namespace wireshark_mcp {
+
+class ProtocolAnalyzer;
+
+// Register the first-party link, network and transport decoders: Ethernet,
+// 802.1Q/802.1ad VLAN tags (stacked tags decode as one layer each), ARP,
+// IPv4, IPv6 (extension headers are part of the IPv6 layer), ICMP, ICMPv6,
+// TCP and UDP.
+//
+// They read fixed header layouts with one bounds check per layer and
+// whole-word big-endian loads, and allocate nothing per packet.
+void register_builtin_decoders(ProtocolAnalyzer& analyzer);
+
+} // namespace wireshark_mcp
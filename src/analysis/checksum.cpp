@@ -0,0 +1,266 @@
+#include "checksum.h"
+#include "../common/byte_order.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define WIRESHARK_MCP_X86_CHECKSUM 1
+#endif
+
+// MSVC compiles intrinsics for any instruction set without per-function
+// targets, and has no __builtin_cpu_supports: ask CPUID directly
+#if defined(WIRESHARK_MCP_X86_CHECKSUM) && defined(_MSC_VER)
+#include <intrin.h>
+#ifdef __clang__
+#define WIRESHARK_MCP_TARGET(isa) __attribute__((target(isa)))
+#else
+#define WIRESHARK_MCP_TARGET(isa)
+#endif
+#else
+#define WIRESHARK_MCP_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Kernels add the data as native-order 16-bit words into a wide sum;
+// folding it and, on little-endian hosts, swapping the bytes of the result
+// gives the big-endian sum (RFC 1071, section 2)
+using SumKernel = uint64_t (*)(const uint8_t* data, size_t length);
+
+// Vector iterations before the 32-bit lanes are drained: each lane gains
+// at most 2 * 0xFFFF per iteration
+constexpr size_t MAX_VECTOR_ITERATIONS = 32768;
+
+uint64_t sum_tail(const uint8_t* data, size_t length) {
+    uint64_t sum = 0;
+    
+    while (length >= 4) {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        sum += word;
+        data += 4;
+        length -= 4;
+    }
+    
+    if (length >= 2) {
+        uint16_t word;
+        std::memcpy(&word, data, sizeof(word));
+        sum += word;
+        data += 2;
+        length -= 2;
+    }
+    
+    // The odd byte is the first of a word padded with zero
+    if (length > 0) {
+        uint16_t word = 0;
+        std::memcpy(&word, data, 1);
+        sum += word;
+    }
+    
+    return sum;
+}
+
+// 32-bit words into 64-bit sums: no carries to handle before 2^32 words
+uint64_t sum_scalar(const uint8_t* data, size_t length) {
+    uint64_t sum0 = 0;
+    uint64_t sum1 = 0;
+    
+    while (length >= 16) {
+        uint32_t words[4];
+        std::memcpy(words, data, sizeof(words));
+        sum0 += words[0];
+        sum1 += words[1];
+        sum0 += words[2];
+        sum1 += words[3];
+        data += 16;
+        length -= 16;
+    }
+    
+    return sum0 + sum1 + sum_tail(data, length);
+}
+
+#ifdef WIRESHARK_MCP_X86_CHECKSUM
+
+// Each 32-bit lane holds two 16-bit words; the low and high halves are
+// added into separate accumulators, which also breaks the dependency chain
+WIRESHARK_MCP_TARGET("sse2")
+uint64_t sum_sse2(const uint8_t* data, size_t length) {
+    const __m128i low_mask = _mm_set1_epi32(0xFFFF);
+    uint64_t sum = 0;
+    
+    while (length >= 16) {
+        size_t iterations = std::min(length / 16, MAX_VECTOR_ITERATIONS);
+        __m128i low = _mm_setzero_si128();
+        __m128i high = _mm_setzero_si128();
+        
+        for (size_t i = 0; i < iterations; ++i) {
+            __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            low = _mm_add_epi32(low, _mm_and_si128(words, low_mask));
+            high = _mm_add_epi32(high, _mm_srli_epi32(words, 16));
+            data += 16;
+        }
+        length -= iterations * 16;
+        
+        alignas(16) uint32_t lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), low);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 4), high);
+        for (uint32_t lane : lanes) {
+            sum += lane;
+        }
+    }
+    
+    return sum + sum_tail(data, length);
+}
+
+WIRESHARK_MCP_TARGET("avx2")
+uint64_t sum_avx2(const uint8_t* data, size_t length) {
+    const __m256i low_mask = _mm256_set1_epi32(0xFFFF);
+    uint64_t sum = 0;
+    
+    while (length >= 32) {
+        size_t iterations = std::min(length / 32, MAX_VECTOR_ITERATIONS);
+        __m256i low = _mm256_setzero_si256();
+        __m256i high = _mm256_setzero_si256();
+        
+        for (size_t i = 0; i < iterations; ++i) {
+            __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            low = _mm256_add_epi32(low, _mm256_and_si256(words, low_mask));
+            high = _mm256_add_epi32(high, _mm256_srli_epi32(words, 16));
+            data += 32;
+        }
+        length -= iterations * 32;
+        
+        alignas(32) uint32_t lanes[16];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), low);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 8), high);
+        for (uint32_t lane : lanes) {
+            sum += lane;
+        }
+    }
+    
+    // Leave no dirty upper halves behind for the SSE code of the caller
+    _mm256_zeroupper();
+    
+    return sum + sum_tail(data, length);
+}
+
+#ifdef _MSC_VER
+bool cpu_supports(ChecksumKernel kernel) {
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    
+    __cpuid(info, 1);
+    if (kernel == ChecksumKernel::SSE2) {
+        return (info[3] & (1 << 26)) != 0;
+    }
+    
+    // AVX2 also needs the OS to save the YMM registers (OSXSAVE and XCR0)
+    if (max_leaf < 7 || (info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+#else
+bool cpu_supports(ChecksumKernel kernel) {
+    return kernel == ChecksumKernel::SSE2 ? __builtin_cpu_supports("sse2") : __builtin_cpu_supports("avx2");
+}
+#endif
+
+#endif
+
+SumKernel kernel_function(ChecksumKernel kernel) {
+    switch (kernel) {
+#ifdef WIRESHARK_MCP_X86_CHECKSUM
+        case ChecksumKernel::SSE2:
+            return sum_sse2;
+        case ChecksumKernel::AVX2:
+            return sum_avx2;
+#endif
+        default:
+            return sum_scalar;
+    }
+}
+
+ChecksumKernel detect_kernel() {
+    if (checksum_kernel_supported(ChecksumKernel::AVX2)) {
+        return ChecksumKernel::AVX2;
+    }
+    if (checksum_kernel_supported(ChecksumKernel::SSE2)) {
+        return ChecksumKernel::SSE2;
+    }
+    return ChecksumKernel::SCALAR;
+}
+
+// Detected once; relaxed loads are enough since any kernel gives the same sum
+std::atomic<int> g_active_kernel{-1};
+
+ChecksumKernel current_kernel() {
+    int kernel = g_active_kernel.load(std::memory_order_relaxed);
+    
+    if (kernel < 0) {
+        kernel = static_cast<int>(detect_kernel());
+        g_active_kernel.store(kernel, std::memory_order_relaxed);
+    }
+    
+    return static_cast<ChecksumKernel>(kernel);
+}
+
+} // namespace
+
+uint16_t checksum_sum(const uint8_t* data, size_t length, uint32_t initial) {
+    uint64_t sum = kernel_function(current_kernel())(data, length);
+    
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    uint16_t folded = big_endian16(checksum_fold(static_cast<uint32_t>(sum)));
+    
+    return checksum_fold(static_cast<uint32_t>(folded) + checksum_fold(initial));
+}
+
+ChecksumKernel active_checksum_kernel() {
+    return current_kernel();
+}
+
+bool checksum_kernel_supported(ChecksumKernel kernel) {
+    switch (kernel) {
+        case ChecksumKernel::SCALAR:
+            return true;
+#ifdef WIRESHARK_MCP_X86_CHECKSUM
+        case ChecksumKernel::SSE2:
+        case ChecksumKernel::AVX2:
+            return cpu_supports(kernel);
+#endif
+        default:
+            return false;
+    }
+}
+
+bool set_checksum_kernel(ChecksumKernel kernel) {
+    if (!checksum_kernel_supported(kernel)) {
+        return false;
+    }
+    
+    g_active_kernel.store(static_cast<int>(kernel), std::memory_order_relaxed);
+    return true;
+}
+
+const char* checksum_kernel_name(ChecksumKernel kernel) {
+    switch (kernel) {
+        case ChecksumKernel::SCALAR:
+            return "scalar";
+        case ChecksumKernel::SSE2:
+            return "sse2";
+        case ChecksumKernel::AVX2:
+            return "avx2";
+    }
+    
+    return "unknown";
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wireshark_mcp {
+
+// Outcome of verifying a checksum, as reported in *.checksum.status fields
+enum class ChecksumStatus : uint8_t {
+    BAD,
+    GOOD,
+    UNVERIFIED      // Not computable: truncated, fragmented or not present
+};
+
+// Implementations of the ones-complement sum
+enum class ChecksumKernel : uint8_t {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// Ones-complement sum of data read as big-endian 16-bit words (an odd
+// trailing byte is padded with zero), folded to 16 bits and added to
+// initial. Chained calls must pass even-length buffers except the last.
+// A region that includes its correct Internet checksum sums to 0xFFFF.
+uint16_t checksum_sum(const uint8_t* data, size_t length, uint32_t initial = 0);
+
+// Fold a 32-bit sum of 16-bit words into a 16-bit ones-complement sum
+inline uint16_t checksum_fold(uint32_t sum) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return static_cast<uint16_t>(sum);
+}
+
+// The kernel checksum_sum() uses: the widest the CPU supports, detected
+// on first use
+ChecksumKernel active_checksum_kernel();
+
+bool checksum_kernel_supported(ChecksumKernel kernel);
+
+// Force a kernel, for tests and benchmarks. False (and no change) when the
+// CPU or build lacks it. Not to be called while packets are being decoded.
+bool set_checksum_kernel(ChecksumKernel kernel);
+
+const char* checksum_kernel_name(ChecksumKernel kernel);
+
+} // namespace wireshark_mcp
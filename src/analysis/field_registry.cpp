@@ -0,0 +1,123 @@
+#include "field_registry.h"
+#include "checksum.h"
+#include <cstdio>
+
+namespace wireshark_mcp {
+
+FieldRegistry& FieldRegistry::instance() {
+    static FieldRegistry registry;
+    return registry;
+}
+
+FieldRegistry::FieldRegistry() {
+}
+
+FieldId FieldRegistry::intern(const std::string& name, FieldType type, const std::string& description) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_ids.find(name);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+    
+    m_fields.push_back({name, description, type});
+    FieldId id = static_cast<FieldId>(m_fields.size());
+    m_ids[name] = id;
+    
+    return id;
+}
+
+FieldId FieldRegistry::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_ids.find(name);
+    return it != m_ids.end() ? it->second : INVALID_FIELD_ID;
+}
+
+const FieldInfo& FieldRegistry::get(FieldId id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fields.at(id - 1);
+}
+
+std::string format_field_value(FieldType type, const uint8_t* data, size_t length, uint64_t value) {
+    char text[64];
+    
+    switch (type) {
+        case FieldType::UNSIGNED:
+            std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(value));
+            return text;
+        
+        case FieldType::HEX:
+            std::snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(value));
+            return text;
+        
+        case FieldType::BOOLEAN:
+            return value ? "true" : "false";
+        
+        case FieldType::CHECKSUM_STATUS:
+            switch (static_cast<ChecksumStatus>(value)) {
+                case ChecksumStatus::BAD:
+                    return "bad";
+                case ChecksumStatus::GOOD:
+                    return "good";
+                case ChecksumStatus::UNVERIFIED:
+                    return "unverified";
+            }
+            return "unknown";
+        
+        case FieldType::MAC:
+            if (length < 6) {
+                break;
+            }
+            std::snprintf(text, sizeof(text), "%02x:%02x:%02x:%02x:%02x:%02x",
+                          data[0], data[1], data[2], data[3], data[4], data[5]);
+            return text;
+        
+        case FieldType::IPV4:
+            if (length < 4) {
+                break;
+            }
+            std::snprintf(text, sizeof(text), "%u.%u.%u.%u", data[0], data[1], data[2], data[3]);
+            return text;
+        
+        case FieldType::IPV6: {
+            if (length < 16) {
+                break;
+            }
+            
+            // Groups without zero compression: unambiguous and cheap
+            std::string result;
+            for (size_t i = 0; i < 16; i += 2) {
+                std::snprintf(text, sizeof(text), i == 0 ? "%x" : ":%x", (data[i] << 8) | data[i + 1]);
+                result += text;
+            }
+            return result;
+        }
+        
+        case FieldType::TEXT: {
+            std::string result;
+            result.reserve(length);
+            for (size_t i = 0; i < length; ++i) {
+                result += (data[i] >= 0x20 && data[i] < 0x7f) ? static_cast<char>(data[i]) : '.';
+            }
+            return result;
+        }
+        
+        case FieldType::BYTES:
+            break;
+    }
+    
+    // Raw bytes, also the fallback for truncated fixed-size values
+    static const char digits[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(length * 2);
+    
+    for (size_t i = 0; i < length; ++i) {
+        result += digits[data[i] >> 4];
+        result += digits[data[i] & 0x0f];
+    }
+    
+    return result;
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace wireshark_mcp {
+
+// Interned identity of a packet field ("ip.ttl", "tcp.srcport", ...)
+using FieldId = uint32_t;
+
+constexpr FieldId INVALID_FIELD_ID = 0;
+
+// How a field's value is rendered
+enum class FieldType : uint8_t {
+    UNSIGNED,       // Decoded integer, shown in decimal
+    HEX,            // Decoded integer, shown as 0x...
+    BOOLEAN,        // Decoded integer, shown as true/false
+    MAC,            // 6 packet bytes
+    IPV4,           // 4 packet bytes
+    IPV6,           // 16 packet bytes
+    BYTES,          // Packet bytes as hex
+    TEXT,           // Packet bytes as printable ASCII
+    CHECKSUM_STATUS // ChecksumStatus, shown as good/bad/unverified
+};
+
+struct FieldInfo {
+    std::string name;
+    std::string description;
+    FieldType type;
+};
+
+// Process-wide table of field definitions.
+//
+// Decoders intern their fields once, when they are constructed, and keep
+// the ids; dissected packets then refer to fields by id only. Entries are
+// never removed, so references returned by get() stay valid.
+class FieldRegistry {
+public:
+    static FieldRegistry& instance();
+    
+    // Id of the field, registering it on first use. Registering a name again
+    // returns the existing id and keeps the first definition.
+    FieldId intern(const std::string& name, FieldType type, const std::string& description = "");
+    
+    // INVALID_FIELD_ID when the name was never registered
+    FieldId find(const std::string& name) const;
+    
+    // Definition of a valid id
+    const FieldInfo& get(FieldId id) const;
+    
+private:
+    FieldRegistry();
+    
+    mutable std::mutex m_mutex;
+    std::deque<FieldInfo> m_fields;     // Index = id - 1
+    std::unordered_map<std::string, FieldId> m_ids;
+};
+
+// Render a value for display or export
+std::string format_field_value(FieldType type, const uint8_t* data, size_t length, uint64_t value);
+
+} // namespace wireshark_mcp
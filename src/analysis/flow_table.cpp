@@ -0,0 +1,250 @@
+#include "flow_table.h"
+#include "field_registry.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+} // namespace
+
+std::string format_flow_endpoint(const FlowKey& key, bool endpoint_b) {
+    const auto& address = endpoint_b ? key.address_b : key.address_a;
+    uint16_t port = endpoint_b ? key.port_b : key.port_a;
+    
+    std::string text = key.ip_version == 6
+                           ? format_field_value(FieldType::IPV6, address.data(), 16, 0)
+                           : format_field_value(FieldType::IPV4, address.data(), 4, 0);
+    
+    if (key.port_a == 0 && key.port_b == 0) {
+        return text;
+    }
+    
+    if (key.ip_version == 6) {
+        return "[" + text + "]:" + std::to_string(port);
+    }
+    return text + ":" + std::to_string(port);
+}
+
+FlowTable::FlowTable()
+    : m_mask(0),
+      m_size(0),
+      m_max_flows(0),
+      m_sweep(0),
+      m_idle_timeout_ns(0),
+      m_now(0),
+      m_overflows(0),
+      m_expired(0) {
+}
+
+void FlowTable::configure(size_t max_flows, uint64_t idle_timeout_ns) {
+    // Load factor at most 7/8, so probe runs stay short and end in an empty slot
+    size_t capacity = 8;
+    while (capacity < max_flows + max_flows / 7 + 1) {
+        capacity *= 2;
+    }
+    
+    m_slots.assign(max_flows > 0 ? capacity : 0, Slot{0, 0});
+    m_flows.assign(m_slots.size(), FlowStats());
+    m_mask = m_slots.empty() ? 0 : capacity - 1;
+    m_max_flows = max_flows;
+    m_idle_timeout_ns = idle_timeout_ns;
+    clear();
+}
+
+void FlowTable::set_expired_handler(FlowExpiredHandler handler) {
+    m_expired_handler = std::move(handler);
+}
+
+void FlowTable::clear() {
+    std::fill(m_slots.begin(), m_slots.end(), Slot{0, 0});
+    m_size = 0;
+    m_sweep = 0;
+    m_now = 0;
+    m_overflows = 0;
+    m_expired = 0;
+}
+
+const FlowStats* FlowTable::update(const FlowKey& key, bool reversed, uint64_t timestamp_ns, size_t bytes,
+                                   uint8_t tcp_flags) {
+    if (m_slots.empty()) {
+        ++m_overflows;
+        return nullptr;
+    }
+    
+    m_now = std::max(m_now, timestamp_ns);
+    if (m_idle_timeout_ns != 0) {
+        expire(m_now, SWEEP_SLOTS_PER_UPDATE);
+    }
+    
+    uint64_t hash = key.hash();
+    size_t index = find_index(key, hash);
+    
+    // The same 5-tuple after a quiet period starts a new conversation
+    if (index != NOT_FOUND && is_idle(m_flows[index], m_now)) {
+        if (m_expired_handler) {
+            m_expired_handler(m_flows[index]);
+        }
+        remove(index);
+        ++m_expired;
+        index = NOT_FOUND;
+    }
+    
+    if (index == NOT_FOUND) {
+        if (m_size >= m_max_flows) {
+            ++m_overflows;
+            return nullptr;
+        }
+        
+        index = insert(key, hash);
+        m_flows[index].first_seen = timestamp_ns;
+        m_flows[index].last_seen = timestamp_ns;
+    }
+    
+    FlowStats& flow = m_flows[index];
+    if (reversed) {
+        ++flow.packets_b_to_a;
+        flow.bytes_b_to_a += bytes;
+    } else {
+        ++flow.packets_a_to_b;
+        flow.bytes_a_to_b += bytes;
+    }
+    
+    // Merged captures can deliver slightly out of order
+    flow.first_seen = std::min(flow.first_seen, timestamp_ns);
+    flow.last_seen = std::max(flow.last_seen, timestamp_ns);
+    flow.tcp_flags |= tcp_flags;
+    
+    return &flow;
+}
+
+bool FlowTable::update_frame(const uint8_t* data, size_t captured_length, size_t actual_length,
+                             uint64_t timestamp_ns) {
+    FlowKey key;
+    FlowPacketInfo info;
+    if (!extract_flow_key(data, captured_length, key, info)) {
+        return false;
+    }
+    
+    return update(key, info.reversed, timestamp_ns, actual_length, info.tcp_flags) != nullptr;
+}
+
+const FlowStats* FlowTable::find(const FlowKey& key) const {
+    if (m_slots.empty()) {
+        return nullptr;
+    }
+    
+    size_t index = find_index(key, key.hash());
+    return index != NOT_FOUND ? &m_flows[index] : nullptr;
+}
+
+size_t FlowTable::expire(uint64_t now_ns, size_t max_slots) {
+    if (m_slots.empty() || m_idle_timeout_ns == 0) {
+        return 0;
+    }
+    
+    size_t removed = 0;
+    for (size_t i = 0; i < max_slots && m_size > 0; ++i) {
+        if (m_slots[m_sweep].distance != 0 && is_idle(m_flows[m_sweep], now_ns)) {
+            if (m_expired_handler) {
+                m_expired_handler(m_flows[m_sweep]);
+            }
+            
+            // Removal shifts the next flow of the run into this slot, so
+            // the sweep stays where it is
+            remove(m_sweep);
+            ++removed;
+        } else {
+            m_sweep = (m_sweep + 1) & m_mask;
+        }
+    }
+    
+    m_expired += removed;
+    return removed;
+}
+
+void FlowTable::for_each(const std::function<void(const FlowStats& flow)>& visitor) const {
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].distance != 0) {
+            visitor(m_flows[i]);
+        }
+    }
+}
+
+bool FlowTable::is_idle(const FlowStats& flow, uint64_t now_ns) const {
+    return m_idle_timeout_ns != 0 && now_ns > flow.last_seen && now_ns - flow.last_seen > m_idle_timeout_ns;
+}
+
+size_t FlowTable::find_index(const FlowKey& key, uint64_t hash) const {
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t index = static_cast<size_t>(hash) & m_mask;
+    
+    // A slot closer to its home than the probe is to ours ends the search:
+    // Robin Hood insertion would have placed the key there
+    for (uint32_t distance = 1;; ++distance) {
+        const Slot& slot = m_slots[index];
+        if (slot.distance < distance) {
+            return NOT_FOUND;
+        }
+        if (slot.tag == tag && m_flows[index].key == key) {
+            return index;
+        }
+        index = (index + 1) & m_mask;
+    }
+}
+
+size_t FlowTable::insert(const FlowKey& key, uint64_t hash) {
+    Slot carried{static_cast<uint32_t>(hash >> 32), 1};
+    FlowStats flow;
+    flow.key = key;
+    
+    size_t index = static_cast<size_t>(hash) & m_mask;
+    size_t placed = NOT_FOUND;
+    
+    // Take the slot of any flow nearer its home, and carry that flow on
+    while (true) {
+        Slot& slot = m_slots[index];
+        
+        if (slot.distance == 0) {
+            slot = carried;
+            m_flows[index] = flow;
+            break;
+        }
+        
+        if (slot.distance < carried.distance) {
+            std::swap(slot, carried);
+            std::swap(m_flows[index], flow);
+            if (placed == NOT_FOUND) {
+                placed = index;
+            }
+        }
+        
+        index = (index + 1) & m_mask;
+        ++carried.distance;
+    }
+    
+    ++m_size;
+    return placed != NOT_FOUND ? placed : index;
+}
+
+void FlowTable::remove(size_t index) {
+    size_t next = (index + 1) & m_mask;
+    
+    // Backward shift: pull the rest of the run one slot closer to home
+    while (m_slots[next].distance > 1) {
+        m_slots[index] = m_slots[next];
+        --m_slots[index].distance;
+        m_flows[index] = m_flows[next];
+        index = next;
+        next = (next + 1) & m_mask;
+    }
+    
+    m_slots[index] = Slot{0, 0};
+    --m_size;
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../capture/flow_key.h"
+
+namespace wireshark_mcp {
+
+// Counters of one conversation, kept inline in the table
+struct FlowStats {
+    FlowKey key;
+    uint64_t first_seen = 0;        // Nanoseconds since the Unix epoch
+    uint64_t last_seen = 0;
+    uint64_t packets_a_to_b = 0;
+    uint64_t packets_b_to_a = 0;
+    uint64_t bytes_a_to_b = 0;
+    uint64_t bytes_b_to_a = 0;
+    uint8_t tcp_flags = 0;          // Every TCP flag seen in either direction
+
+    uint64_t packets() const { return packets_a_to_b + packets_b_to_a; }
+    uint64_t bytes() const { return bytes_a_to_b + bytes_b_to_a; }
+};
+
+// "10.0.0.1:443", "[2001:db8:0:0:0:0:0:1]:443" (port left out when the key has
+// none); addresses are formatted like IPv4/IPv6 field values
+std::string format_flow_endpoint(const FlowKey& key, bool endpoint_b);
+
+// Receives flows removed for being idle
+using FlowExpiredHandler = std::function<void(const FlowStats& flow)>;
+
+// Conversation table keyed by the normalized 5-tuple.
+//
+// Open addressing with Robin Hood probing over a table sized once, in
+// configure(), so the packet path never allocates or rehashes. Probes scan
+// a compact array of 8-byte slot tags (hash bits and probe distance) and
+// only touch a flow's counters on a tag match. Idle flows are evicted
+// incrementally: every update() also sweeps a few slots, and removal
+// shifts the following run back instead of leaving tombstones. When the
+// table is full, new flows are counted as overflows and not tracked.
+class FlowTable {
+public:
+    FlowTable();
+
+    // Room for max_flows flows, allocated up front; a zero idle timeout
+    // keeps flows until clear()
+    void configure(size_t max_flows, uint64_t idle_timeout_ns);
+
+    void set_expired_handler(FlowExpiredHandler handler);
+
+    // Forget every flow (without reporting them) and zero the counters
+    void clear();
+
+    // Account a frame to its flow, creating it when needed. Returns the
+    // flow, or nullptr when the table is full. The pointer stays valid
+    // until the next non-const call.
+    const FlowStats* update(const FlowKey& key, bool reversed, uint64_t timestamp_ns, size_t bytes,
+                            uint8_t tcp_flags);
+
+    // Same for an Ethernet frame; false when it has no flow key or the
+    // table is full
+    bool update_frame(const uint8_t* data, size_t captured_length, size_t actual_length,
+                      uint64_t timestamp_ns);
+
+    const FlowStats* find(const FlowKey& key) const;
+
+    // Examine up to max_slots slots for flows idle at now_ns (a packet
+    // timestamp), for callers that need eviction while no packets arrive.
+    // Returns the number of flows removed.
+    size_t expire(uint64_t now_ns, size_t max_slots);
+
+    // Visit every flow, in no particular order
+    void for_each(const std::function<void(const FlowStats& flow)>& visitor) const;
+
+    size_t size() const { return m_size; }
+    size_t get_max_flows() const { return m_max_flows; }
+    uint64_t get_overflows() const { return m_overflows; }
+    uint64_t get_expired() const { return m_expired; }
+
+private:
+    struct Slot {
+        uint32_t tag;           // High hash bits, to skip most key comparisons
+        uint32_t distance;      // Probe distance + 1; 0 = empty
+    };
+
+    // Slots examined for idle flows on every update()
+    static constexpr size_t SWEEP_SLOTS_PER_UPDATE = 4;
+
+    bool is_idle(const FlowStats& flow, uint64_t now_ns) const;
+    size_t find_index(const FlowKey& key, uint64_t hash) const;
+    size_t insert(const FlowKey& key, uint64_t hash);
+    void remove(size_t index);
+
+    std::vector<Slot> m_slots;
+    std::vector<FlowStats> m_flows;     // Parallel to m_slots
+    size_t m_mask;
+    size_t m_size;
+    size_t m_max_flows;
+    size_t m_sweep;                     // Next slot the idle sweep examines
+    uint64_t m_idle_timeout_ns;
+    uint64_t m_now;                     // Latest timestamp seen
+    uint64_t m_overflows;
+    uint64_t m_expired;
+    FlowExpiredHandler m_expired_handler;
+};
+
+} // namespace wireshark_mcp
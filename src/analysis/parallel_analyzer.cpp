@@ -0,0 +1,287 @@
+#include "parallel_analyzer.h"
+#include "../capture/flow_key.h"
+#include "../common/config.h"
+#include "../common/cpu_affinity.h"
+#include "../common/logging.h"
+#include <algorithm>
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Slots published (or delivered) between wake-ups of the other side
+constexpr uint64_t NOTIFY_INTERVAL = 32;
+
+} // namespace
+
+struct ParallelAnalyzer::Worker {
+    std::unique_ptr<ProtocolAnalyzer> analyzer;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable work;
+    std::vector<uint64_t> queue;        // Sequence numbers waiting to be dissected
+    bool stop = false;
+    std::atomic<uint64_t> packets{0};
+};
+
+ParallelAnalyzerOptions parallel_analyzer_options_from_config(const Config& config) {
+    ParallelAnalyzerOptions options;
+    
+    options.workers = static_cast<size_t>(std::max(0, config.get<int>("analysis.workers", 0)));
+    options.reorder_window = static_cast<size_t>(std::max(1, config.get<int>(
+        "analysis.reorder_window", static_cast<int>(options.reorder_window))));
+    options.cpu_affinity = config.get<std::string>("analysis.cpu_affinity", "");
+    
+    // "numa" places the workers next to the (first) capture NIC
+    std::string device = config.get<std::string>("capture.default_device", "");
+    options.numa_device = device.substr(0, device.find(','));
+    
+    return options;
+}
+
+ParallelAnalyzer::ParallelAnalyzer()
+    : m_link_type(DLT_EN10MB),
+      m_window(0),
+      m_submitted(0),
+      m_delivered(0),
+      m_delivery_waiting(false),
+      m_stop_delivery(false),
+      m_running(false) {
+}
+
+ParallelAnalyzer::~ParallelAnalyzer() {
+    stop();
+}
+
+bool ParallelAnalyzer::start(const ParallelAnalyzerOptions& options, OrderedHandler handler,
+                             AnalyzerFactory analyzer_factory) {
+    stop();
+    m_workers.clear();
+    m_cpus.clear();
+    m_error_message.clear();
+    
+    if (!handler) {
+        m_error_message = "No handler for decoded packets";
+        Log::error(m_error_message);
+        return false;
+    }
+    
+    // Placement problems cost performance, not correctness
+    std::string placement_error;
+    if (!resolve_cpu_set(options.cpu_affinity, options.numa_device, m_cpus, placement_error)) {
+        Log::warning("Analysis workers left unpinned: {}", placement_error);
+        m_cpus.clear();
+    }
+    
+    size_t worker_count = options.workers;
+    if (worker_count == 0) {
+        worker_count = !m_cpus.empty() ? m_cpus.size()
+                                       : std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    
+    for (size_t i = 0; i < worker_count; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->analyzer = analyzer_factory ? analyzer_factory() : std::make_unique<ProtocolAnalyzer>();
+        
+        if (!worker->analyzer) {
+            m_error_message = "Analyzer factory returned no analyzer";
+            Log::error(m_error_message);
+            m_workers.clear();
+            return false;
+        }
+        
+        worker->analyzer->set_link_type(options.link_type);
+        m_workers.push_back(std::move(worker));
+    }
+    
+    m_handler = std::move(handler);
+    m_link_type = options.link_type;
+    m_window = std::max<size_t>(options.reorder_window, 1);
+    m_slots.reset(new Slot[m_window]);
+    m_submitted = 0;
+    m_delivered.store(0);
+    m_stop_delivery = false;
+    m_running = true;
+    
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        m_workers[i]->thread = std::thread(&ParallelAnalyzer::worker_main, this, i);
+    }
+    m_delivery_thread = std::thread(&ParallelAnalyzer::delivery_main, this);
+    
+    Log::info("Parallel analysis started with {} workers, reorder window {}", m_workers.size(), m_window);
+    return true;
+}
+
+uint64_t ParallelAnalyzer::submit(const Packet& packet) {
+    uint64_t sequence = m_submitted++;
+    
+    // The slot is free once its previous occupant has been delivered
+    if (sequence - m_delivered.load(std::memory_order_acquire) >= m_window) {
+        std::unique_lock<std::mutex> lock(m_order_mutex);
+        m_space.wait(lock, [this, sequence] {
+            return sequence - m_delivered.load(std::memory_order_acquire) < m_window;
+        });
+    }
+    
+    m_slots[sequence % m_window].packet = packet;
+    
+    Worker& worker = *m_workers[shard(packet, sequence)];
+    bool was_empty;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        was_empty = worker.queue.empty();
+        worker.queue.push_back(sequence);
+    }
+    
+    if (was_empty) {
+        worker.work.notify_one();
+    }
+    
+    return sequence;
+}
+
+void ParallelAnalyzer::flush() {
+    if (!m_running) {
+        return;
+    }
+    
+    std::unique_lock<std::mutex> lock(m_order_mutex);
+    m_space.wait(lock, [this] {
+        return m_delivered.load(std::memory_order_acquire) == m_submitted;
+    });
+}
+
+void ParallelAnalyzer::stop() {
+    if (!m_running) {
+        return;
+    }
+    
+    flush();
+    
+    for (auto& worker : m_workers) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            worker->stop = true;
+        }
+        worker->work.notify_one();
+        worker->thread.join();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(m_order_mutex);
+        m_stop_delivery = true;
+    }
+    m_ready.notify_one();
+    m_delivery_thread.join();
+    
+    m_running = false;
+    Log::info("Parallel analysis stopped after {} packets", get_delivered());
+}
+
+uint64_t ParallelAnalyzer::get_worker_packets(size_t worker) const {
+    return worker < m_workers.size() ? m_workers[worker]->packets.load(std::memory_order_relaxed) : 0;
+}
+
+size_t ParallelAnalyzer::shard(const Packet& packet, uint64_t sequence) const {
+    FlowKey key;
+    if (m_link_type == DLT_EN10MB && extract_flow_key(packet.data.data(), packet.data.size(), key)) {
+        return static_cast<size_t>(key.hash() % m_workers.size());
+    }
+    
+    // No conversation to keep together
+    return static_cast<size_t>(sequence % m_workers.size());
+}
+
+void ParallelAnalyzer::worker_main(size_t index) {
+    Worker& worker = *m_workers[index];
+    
+    if (!m_cpus.empty()) {
+        int cpu = m_cpus[index % m_cpus.size()];
+        std::string error;
+        if (!pin_current_thread({cpu}, error)) {
+            Log::warning("Analysis worker {} not pinned to CPU {}: {}", index, cpu, error);
+        }
+    }
+    
+    std::vector<uint64_t> batch;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.work.wait(lock, [&worker] { return !worker.queue.empty() || worker.stop; });
+            
+            if (worker.queue.empty()) {
+                break;
+            }
+            batch.swap(worker.queue);
+        }
+        
+        for (size_t i = 0; i < batch.size(); ++i) {
+            Slot& slot = m_slots[batch[i] % m_window];
+            worker.analyzer->analyze_packet(slot.packet, slot.decoded);
+            
+            // Sequentially consistent, paired with m_delivery_waiting
+            slot.ready.store(true);
+            
+            if ((i + 1) % NOTIFY_INTERVAL == 0) {
+                notify_delivery();
+            }
+        }
+        
+        worker.packets.fetch_add(batch.size(), std::memory_order_relaxed);
+        batch.clear();
+        notify_delivery();
+    }
+}
+
+void ParallelAnalyzer::notify_delivery() {
+    // A delivery thread that missed the flag sees the slots when it
+    // rechecks them under the lock
+    if (m_delivery_waiting.load()) {
+        {
+            std::lock_guard<std::mutex> lock(m_order_mutex);
+        }
+        m_ready.notify_one();
+    }
+}
+
+void ParallelAnalyzer::delivery_main() {
+    uint64_t next = 0;
+    
+    while (true) {
+        Slot& slot = m_slots[next % m_window];
+        
+        if (!slot.ready.load(std::memory_order_acquire)) {
+            std::unique_lock<std::mutex> lock(m_order_mutex);
+            
+            // Let a blocked submit() or flush() see the run just delivered
+            m_space.notify_all();
+            
+            m_delivery_waiting.store(true);
+            m_ready.wait(lock, [this, &slot] { return slot.ready.load() || m_stop_delivery; });
+            m_delivery_waiting.store(false);
+            
+            // Stopping happens only once everything has been delivered
+            if (!slot.ready.load()) {
+                break;
+            }
+        }
+        
+        m_handler(next, slot.decoded);
+        
+        // Hand the buffers back to their pool before the slot is reused
+        slot.packet.data = PacketBuffer();
+        slot.decoded.raw_packet.data = PacketBuffer();
+        slot.ready.store(false, std::memory_order_relaxed);
+        m_delivered.store(++next, std::memory_order_release);
+        
+        if (next % NOTIFY_INTERVAL == 0) {
+            {
+                std::lock_guard<std::mutex> lock(m_order_mutex);
+            }
+            m_space.notify_all();
+        }
+    }
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include "protocol_analyzer.h"
+#include "../capture/fanout_capture.h"
+
+namespace wireshark_mcp {
+
+class Config;
+
+struct ParallelAnalyzerOptions {
+    size_t workers = 0;             // 0 = one per CPU in cpu_affinity, else per online CPU
+    size_t reorder_window = 4096;   // Packets in flight between submit() and delivery
+    std::string cpu_affinity;       // Worker CPUs, as for capture.cpu_affinity
+    std::string numa_device;        // Device whose NUMA node "numa" refers to
+    int link_type = DLT_EN10MB;     // Ethernet frames are sharded by flow, others round robin
+};
+
+// Build options from the analysis.* configuration keys
+ParallelAnalyzerOptions parallel_analyzer_options_from_config(const Config& config);
+
+// Receives every submitted packet, in submission order, on the delivery
+// thread. protocol_stack is empty for packets no decoder recognized.
+using OrderedHandler = std::function<void(uint64_t sequence, const DecodedPacket& decoded)>;
+
+// Dissects packets on a pool of worker threads and hands them back in order.
+//
+// Packets are sharded by the symmetric hash of their flow key, so both
+// directions of a conversation are always dissected by the same worker,
+// each with a private ProtocolAnalyzer (analyzers are not thread-safe).
+// Workers write into a ring of reorder slots indexed by sequence number,
+// and a delivery thread passes the slots to the handler strictly in
+// sequence. submit() blocks while the ring is full, which bounds memory
+// and pushes back on the reader. Slots keep their DecodedPacket storage,
+// so the steady state allocates nothing.
+class ParallelAnalyzer {
+public:
+    ParallelAnalyzer();
+    ~ParallelAnalyzer();
+
+    ParallelAnalyzer(const ParallelAnalyzer&) = delete;
+    ParallelAnalyzer& operator=(const ParallelAnalyzer&) = delete;
+
+    // Start the workers and the delivery thread. When no factory is given
+    // every worker gets a default-constructed ProtocolAnalyzer.
+    bool start(const ParallelAnalyzerOptions& options, OrderedHandler handler,
+               AnalyzerFactory analyzer_factory = nullptr);
+
+    // Queue a packet (sharing its buffer) and return its sequence number.
+    // Must be called from one thread at a time.
+    uint64_t submit(const Packet& packet);
+
+    // Block until everything submitted has been delivered
+    void flush();
+
+    // Deliver what was submitted, then stop and join all threads
+    void stop();
+
+    bool is_running() const { return m_running; }
+
+    size_t get_worker_count() const { return m_workers.size(); }
+
+    // Packets dissected by one worker
+    uint64_t get_worker_packets(size_t worker) const;
+
+    uint64_t get_delivered() const { return m_delivered.load(std::memory_order_acquire); }
+
+    std::string get_error() const { return m_error_message; }
+
+private:
+    struct Slot {
+        Packet packet;
+        DecodedPacket decoded;
+        std::atomic<bool> ready{false};
+    };
+
+    struct Worker;
+
+    // Worker for a packet: by flow where a key can be extracted
+    size_t shard(const Packet& packet, uint64_t sequence) const;
+
+    void worker_main(size_t index);
+    void delivery_main();
+
+    // Wake the delivery thread after publishing slots
+    void notify_delivery();
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<int> m_cpus;            // Worker i runs on m_cpus[i % size]; empty = unpinned
+    OrderedHandler m_handler;
+    int m_link_type;
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_window;
+    uint64_t m_submitted;               // Next sequence number; submitting thread only
+    std::atomic<uint64_t> m_delivered;  // Sequence numbers below this have been delivered
+
+    // Delivery thread wake-ups, and waits for free slots
+    std::mutex m_order_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_space;
+    std::atomic<bool> m_delivery_waiting;
+    bool m_stop_delivery;
+    std::thread m_delivery_thread;
+
+    std::atomic<bool> m_running;
+    std::string m_error_message;
+};
+
+} // namespace wireshark_mcp
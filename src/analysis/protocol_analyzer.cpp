@@ -1,10 +1,51 @@
 #include "protocol_analyzer.h"
+#include "builtin_decoders.h"
+#include "../common/config.h"
 #include "../common/logging.h"
+#include <algorithm>
 
 namespace wireshark_mcp {
 
-ProtocolAnalyzer::ProtocolAnalyzer() {
-    // Initialize with some default decoders
+namespace {
+
+// Bound on dissection depth, against decoders that dispatch in a cycle
+constexpr size_t MAX_LAYERS = 16;
+
+} // namespace
+
+const PacketField* DecodedPacket::find_field(FieldId id) const {
+    for (const auto& field : fields) {
+        if (field.id == id) {
+            return &field;
+        }
+    }
+    
+    return nullptr;
+}
+
+std::string field_name(const PacketField& field) {
+    return FieldRegistry::instance().get(field.id).name;
+}
+
+std::string field_description(const PacketField& field) {
+    return FieldRegistry::instance().get(field.id).description;
+}
+
+std::string field_value(const PacketField& field, const DecodedPacket& decoded) {
+    const PacketBuffer& data = decoded.raw_packet.data;
+    
+    // Fields never point past the captured bytes, but stay safe if one does
+    size_t offset = std::min<size_t>(field.offset, data.size());
+    size_t length = std::min<size_t>(field.length, data.size() - offset);
+    
+    return format_field_value(FieldRegistry::instance().get(field.id).type,
+                              data.data() + offset, length, field.value);
+}
+
+ProtocolAnalyzer::ProtocolAnalyzer()
+    : m_link_type(DLT_EN10MB),
+      m_verify_checksums(Config::getInstance().get<bool>("analysis.verify_checksums", false)) {
+    register_builtin_decoders(*this);
 }
 
 ProtocolAnalyzer::~ProtocolAnalyzer() {
@@ -18,66 +59,182 @@ void ProtocolAnalyzer::register_decoder(std::shared_ptr<ProtocolDecoder> decoder
     }
     
     std::string protocol_name = decoder->get_protocol_name();
-    m_decoders[protocol_name] = decoder;
-    m_decoder_enabled[protocol_name] = true;
+    
+    // Re-registering a name replaces the decoder in place
+    size_t index;
+    auto existing = m_decoder_index.find(protocol_name);
+    if (existing != m_decoder_index.end()) {
+        index = existing->second;
+        remove_from_graph(index);
+        m_decoders[index].decoder = decoder;
+        m_decoders[index].enabled = true;
+    } else {
+        index = m_decoders.size();
+        m_decoders.push_back({decoder, protocol_name, true});
+        m_decoder_index[protocol_name] = index;
+    }
+    
+    decoder->set_checksum_verification(m_verify_checksums);
+    
+    std::vector<DispatchKey> keys = decoder->get_dispatch_keys();
+    std::vector<DispatchTable> heuristic_tables = decoder->get_heuristic_tables();
+    
+    for (const auto& key : keys) {
+        auto& bucket = m_dispatch[pack_key(key)];
+        bucket.insert(bucket.begin(), index);
+    }
+    
+    if (keys.empty() && heuristic_tables.empty()) {
+        heuristic_tables.push_back(DispatchTable::LINK_TYPE);
+    }
+    
+    for (auto table : heuristic_tables) {
+        m_heuristics[static_cast<size_t>(table)].push_back(index);
+    }
     
     Log::info("Registered protocol decoder: {}", protocol_name);
 }
 
+void ProtocolAnalyzer::remove_from_graph(size_t index) {
+    for (auto it = m_dispatch.begin(); it != m_dispatch.end();) {
+        auto& bucket = it->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), index), bucket.end());
+        it = bucket.empty() ? m_dispatch.erase(it) : std::next(it);
+    }
+    
+    for (auto& heuristics : m_heuristics) {
+        heuristics.erase(std::remove(heuristics.begin(), heuristics.end(), index), heuristics.end());
+    }
+}
+
+ProtocolAnalyzer::DecoderEntry* ProtocolAnalyzer::select_decoder(const std::vector<DispatchKey>& keys,
+                                                                 const LayerSpan& span,
+                                                                 const DecodedPacket& decoded) {
+    // Exact keys first, in the order the lower layer gave them
+    for (const auto& key : keys) {
+        auto it = m_dispatch.find(pack_key(key));
+        if (it == m_dispatch.end()) {
+            continue;
+        }
+        
+        for (size_t index : it->second) {
+            if (m_decoders[index].enabled) {
+                return &m_decoders[index];
+            }
+        }
+    }
+    
+    // Then the heuristic decoders of each table named, once per table
+    uint32_t tried_tables = 0;
+    
+    for (const auto& key : keys) {
+        uint32_t table_bit = 1u << static_cast<uint32_t>(key.table);
+        if (tried_tables & table_bit) {
+            continue;
+        }
+        tried_tables |= table_bit;
+        
+        for (size_t index : m_heuristics[static_cast<size_t>(key.table)]) {
+            DecoderEntry& entry = m_decoders[index];
+            if (entry.enabled && entry.decoder->can_decode(span, decoded)) {
+                return &entry;
+            }
+        }
+    }
+    
+    return nullptr;
+}
+
 bool ProtocolAnalyzer::analyze_packet(const Packet& packet, DecodedPacket& decoded) {
-    // Initialize the decoded packet
+    // Initialize the decoded packet; the copy shares the packet's buffer
     decoded.raw_packet = packet;
+    decoded.highest_protocol.clear();
     decoded.protocol_stack.clear();
+    decoded.layers.clear();
     decoded.fields.clear();
     
-    // Start with layer 2 protocols (e.g., Ethernet)
-    bool decoded_something = false;
+    // Every packet enters the graph at its link type; each decoded layer
+    // names the next one, so the work done grows with the depth of the
+    // stack rather than with the number of registered decoders
+    decoded.next_protocols.clear();
+    decoded.next_protocols.push_back({DispatchTable::LINK_TYPE, static_cast<uint32_t>(m_link_type)});
     
-    // Try each decoder
-    for (const auto& decoder_pair : m_decoders) {
-        const std::string& protocol_name = decoder_pair.first;
-        const auto& decoder = decoder_pair.second;
+    // One pass over the captured bytes: each layer consumes its header and
+    // leaves the span on its payload for the next
+    LayerSpan span{packet.data.data(), 0, packet.data.size()};
+    
+    for (size_t layer = 0; layer < MAX_LAYERS && !decoded.next_protocols.empty(); ++layer) {
+        m_keys.swap(decoded.next_protocols);
+        decoded.next_protocols.clear();
         
-        // Skip disabled decoders
-        if (!m_decoder_enabled[protocol_name]) {
-            continue;
+        DecoderEntry* entry = select_decoder(m_keys, span, decoded);
+        if (!entry) {
+            break;
         }
         
-        // Check if this decoder can handle the packet
-        if (decoder->can_decode(packet, decoded.protocol_stack)) {
-            // Try to decode the packet
-            if (decoder->decode(packet, decoded)) {
-                decoded_something = true;
-                decoded.highest_protocol = protocol_name;
-                
-                // Protocol stack is updated by the decoder
-                break;
-            }
+        LayerSpan payload = span;
+        if (!entry->decoder->decode(payload, decoded)) {
+            break;
         }
+        
+        decoded.protocol_stack.push_back(entry->name);
+        decoded.layers.push_back({entry->name, span.offset, payload.offset - span.offset});
+        decoded.highest_protocol = entry->name;
+        
+        span = payload;
     }
     
-    if (!decoded_something) {
+    decoded.next_protocols.clear();
+    
+    if (decoded.protocol_stack.empty()) {
         Log::warning("Could not decode packet with any registered decoder");
+        return false;
+    }
+    
+    return true;
+}
+
+size_t ProtocolAnalyzer::analyze_packets(const std::vector<Packet>& packets, size_t count,
+                                         std::vector<DecodedPacket>& decoded) {
+    count = std::min(count, packets.size());
+    
+    if (decoded.size() < count) {
+        decoded.resize(count);
+    }
+    
+    size_t decoded_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (analyze_packet(packets[i], decoded[i])) {
+            ++decoded_count;
+        }
     }
     
-    return decoded_something;
+    return decoded_count;
 }
 
 std::vector<std::string> ProtocolAnalyzer::get_available_decoders() const {
     std::vector<std::string> decoders;
     
-    for (const auto& decoder_pair : m_decoders) {
-        decoders.push_back(decoder_pair.first);
+    for (const auto& entry : m_decoders) {
+        decoders.push_back(entry.name);
     }
     
     return decoders;
 }
 
+void ProtocolAnalyzer::set_checksum_verification(bool enabled) {
+    m_verify_checksums = enabled;
+    
+    for (auto& entry : m_decoders) {
+        entry.decoder->set_checksum_verification(enabled);
+    }
+}
+
 void ProtocolAnalyzer::set_decoder_enabled(const std::string& protocol_name, bool enabled) {
-    auto it = m_decoder_enabled.find(protocol_name);
+    auto it = m_decoder_index.find(protocol_name);
     
-    if (it != m_decoder_enabled.end()) {
-        it->second = enabled;
+    if (it != m_decoder_index.end()) {
+        m_decoders[it->second].enabled = enabled;
         Log::info("Set decoder '{}' enabled: {}", protocol_name, enabled);
     } else {
         Log::warning("Attempted to enable/disable unknown decoder: {}", protocol_name);
@@ -6,19 +6,67 @@
 #include <unordered_map>
 #include <functional>
 #include "../capture/packet_capture.h"
+#include "field_registry.h"
 
 namespace wireshark_mcp {
 
 // Forward declarations
 class ProtocolDecoder;
 
-// Decoded packet field
+// Namespaces in which a layer names the protocol it carries
+enum class DispatchTable : uint8_t {
+    LINK_TYPE,          // DLT_* of the capture; where every packet starts
+    ETHERTYPE,
+    IP_PROTOCOL,
+    TCP_PORT,
+    UDP_PORT
+};
+
+constexpr size_t DISPATCH_TABLE_COUNT = 5;
+
+// Edge of the dispatch graph: "the payload is value in table"
+struct DispatchKey {
+    DispatchTable table;
+    uint32_t value;
+};
+
+// Decoded packet field: what it is and where it sits, nothing rendered.
+// Integer values are decoded up front (bit fields already masked); names
+// and value strings are produced on demand by field_name()/field_value().
 struct PacketField {
-    std::string name;
-    std::string value;
-    std::string description;
+    uint64_t value;         // Integer fields; 0 for byte fields
+    FieldId id;
+    uint32_t offset;        // Into the captured packet
+    uint32_t length;
+};
+
+// The bytes a layer decoder works on. data points into the captured
+// packet at the start of the layer; nothing is copied between layers.
+struct LayerSpan {
+    const uint8_t* data;
+    size_t offset;          // Of data within the packet
+    size_t length;          // Bytes from data to the end of the layer's payload
+    
+    // Step over a header of n bytes (n <= length)
+    void consume(size_t n) {
+        data += n;
+        offset += n;
+        length -= n;
+    }
+    
+    // Drop bytes past the first n, e.g. Ethernet padding behind an IP datagram
+    void truncate(size_t n) {
+        if (n < length) {
+            length = n;
+        }
+    }
+};
+
+// Byte range one protocol occupies in the packet
+struct ProtocolLayer {
+    std::string protocol;
     size_t offset;
-    size_t length;
+    size_t length;          // Header bytes; the payload belongs to the layers above
 };
 
 // Decoded packet structure
@@ -26,9 +74,29 @@ struct DecodedPacket {
     Packet raw_packet;
     std::string highest_protocol;
     std::vector<std::string> protocol_stack;
-    std::vector<PacketField> fields;
+    std::vector<ProtocolLayer> layers;      // Bottom up, parallel to protocol_stack
+    std::vector<PacketField> fields;        // Bottom up; capacity is reused across packets
+    
+    // Record a field of the current packet (no allocation once the vector
+    // has grown to the usual field count)
+    void add_field(FieldId id, size_t offset, size_t length, uint64_t value = 0) {
+        fields.push_back({value, id, static_cast<uint32_t>(offset), static_cast<uint32_t>(length)});
+    }
+    
+    // First field with the id, or nullptr
+    const PacketField* find_field(FieldId id) const;
+    
+    // Filled in by each decoder for the layer above it: the keys that may
+    // identify its payload, most likely first (e.g. the lower of two ports).
+    // Dissection ends when a layer leaves it empty.
+    std::vector<DispatchKey> next_protocols;
 };
 
+// Rendering for display and export; these allocate, dissection does not
+std::string field_name(const PacketField& field);
+std::string field_description(const PacketField& field);
+std::string field_value(const PacketField& field, const DecodedPacket& decoded);
+
 class ProtocolAnalyzer {
 public:
     ProtocolAnalyzer();
@@ -40,15 +108,56 @@ public:
     // Analyze a packet
     bool analyze_packet(const Packet& packet, DecodedPacket& decoded);
     
+    // Analyze the first count packets of a batch (see PacketCapture::get_next_packets).
+    // Decoded entries are reused across calls. Returns the number decoded.
+    size_t analyze_packets(const std::vector<Packet>& packets, size_t count,
+                           std::vector<DecodedPacket>& decoded);
+    
     // Get available protocol decoders
     std::vector<std::string> get_available_decoders() const;
     
     // Enable/disable a protocol decoder
     void set_decoder_enabled(const std::string& protocol_name, bool enabled);
     
+    // Link type packets are dispatched on first (DLT_EN10MB by default)
+    void set_link_type(int link_type) { m_link_type = link_type; }
+    
+    // Verify IP, ICMP, TCP and UDP checksums into *.checksum.status fields
+    // (analysis.verify_checksums; off by default). Applies to decoders
+    // registered later too. Not to be changed while a packet is analyzed.
+    void set_checksum_verification(bool enabled);
+    bool get_checksum_verification() const { return m_verify_checksums; }
+    
 private:
-    std::unordered_map<std::string, std::shared_ptr<ProtocolDecoder>> m_decoders;
-    std::unordered_map<std::string, bool> m_decoder_enabled;
+    struct DecoderEntry {
+        std::shared_ptr<ProtocolDecoder> decoder;
+        std::string name;
+        bool enabled;
+    };
+    
+    static uint64_t pack_key(const DispatchKey& key) {
+        return (static_cast<uint64_t>(key.table) << 32) | key.value;
+    }
+    
+    // Decoder for the next layer: an enabled decoder registered for one of
+    // the keys, else the first heuristic decoder of their tables that
+    // accepts the packet. nullptr ends the dissection.
+    DecoderEntry* select_decoder(const std::vector<DispatchKey>& keys, const LayerSpan& span,
+                                 const DecodedPacket& decoded);
+    
+    void remove_from_graph(size_t index);
+    
+    // Registered decoders; the graph refers to them by index
+    std::vector<DecoderEntry> m_decoders;
+    std::unordered_map<std::string, size_t> m_decoder_index;
+    
+    // Dispatch graph: packed key -> decoders registered for it, newest first
+    std::unordered_map<uint64_t, std::vector<size_t>> m_dispatch;
+    std::vector<size_t> m_heuristics[DISPATCH_TABLE_COUNT];
+    
+    int m_link_type;
+    bool m_verify_checksums;
+    std::vector<DispatchKey> m_keys;    // Scratch: keys of the layer being decoded
 };
 
 // Base class for protocol decoders
@@ -59,11 +168,26 @@ public:
     // Get protocol name
     virtual std::string get_protocol_name() const = 0;
     
-    // Check if this decoder can decode the packet
-    virtual bool can_decode(const Packet& packet, const std::vector<std::string>& protocol_stack) const = 0;
+    // Keys the decoder is dispatched on, e.g. {ETHERTYPE, 0x0800} for IPv4
+    virtual std::vector<DispatchKey> get_dispatch_keys() const { return {}; }
+    
+    // Tables in which the decoder is offered payloads no key matched, via
+    // can_decode(). A decoder with neither keys nor heuristic tables is tried
+    // heuristically on the link layer.
+    virtual std::vector<DispatchTable> get_heuristic_tables() const { return {}; }
+    
+    // Check if the bytes at span look like this protocol (heuristic
+    // dispatch only); decoded holds the layers below
+    virtual bool can_decode(const LayerSpan& span, const DecodedPacket& decoded) const = 0;
+    
+    // Decode the layer at the start of span: consume() its header, truncate()
+    // the payload if the header gives its length, and set
+    // decoded.next_protocols for the layer above. The span is then handed
+    // to that layer as is.
+    virtual bool decode(LayerSpan& span, DecodedPacket& decoded) = 0;
     
-    // Decode the packet
-    virtual bool decode(const Packet& packet, DecodedPacket& decoded) = 0;
+    // Decoders of protocols with checksums verify them when enabled
+    virtual void set_checksum_verification(bool /*enabled*/) {}
 };
 
 } // namespace wireshark_mcp
@@ -0,0 +1,307 @@
+#include "fanout_capture.h"
+#include "tpacket_ring.h"
+#include "../analysis/protocol_analyzer.h"
+#include "../common/cpu_affinity.h"
+#include "../common/logging.h"
+#include "../security/auth_manager.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Frames pulled from a worker's ring per iteration
+constexpr size_t WORKER_BATCH = 256;
+
+// How often a worker refreshes its kernel drop counter
+constexpr auto KERNEL_STATS_INTERVAL = std::chrono::milliseconds(250);
+
+} // namespace
+
+struct FanoutCapture::Worker {
+    TPacketRing ring;
+    std::unique_ptr<ProtocolAnalyzer> analyzer;
+    std::thread thread;
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> kernel_dropped{0};
+
+    // Raw frames for the consumer when started without a handler
+    std::unique_ptr<PacketRing<Packet>> queue;
+    std::atomic<uint64_t> queue_dropped{0};
+
+    // Reused for every frame so the steady state does not allocate
+    Packet packet;
+    DecodedPacket decoded;
+};
+
+FanoutCapture::FanoutCapture()
+    : m_running(false),
+      m_next_worker(0) {
+}
+
+FanoutCapture::~FanoutCapture() {
+    stop();
+}
+
+bool FanoutCapture::initialize(const std::string& device_name, CaptureOptions options,
+                               AnalyzerFactory analyzer_factory) {
+    stop();
+    m_workers.clear();
+    m_cpus.clear();
+    m_options = options;
+    
+    m_slicer.set_rules(options.slice_rules);
+    m_slicer.set_default_payload(options.slice_payload);
+
+    if (options.fanout_workers == 0) {
+        m_error_message = "Fanout capture needs at least one worker";
+        Log::error(m_error_message);
+        return false;
+    }
+
+    // Check permissions
+    if (!AuthManager::validate_capture_permissions(device_name)) {
+        m_error_message = "Insufficient permissions for device: " + device_name;
+        Log::error(m_error_message);
+        return false;
+    }
+
+    // Placement problems cost performance, not correctness
+    std::string placement_error;
+    if (!resolve_cpu_set(options.cpu_affinity, device_name, m_cpus, placement_error)) {
+        Log::warning("Fanout workers on {} left unpinned: {}", device_name, placement_error);
+        m_cpus.clear();
+    }
+
+    uint16_t group_id = options.fanout_group;
+#ifdef __linux__
+    if (group_id == 0) {
+        group_id = static_cast<uint16_t>(getpid() & 0xffff);
+    }
+#endif
+
+    // One program shared by every socket of the group
+    struct bpf_program filter;
+    bool has_filter = !options.capture_filter.empty();
+    
+    if (has_filter && !compile_capture_filter(options.capture_filter, DLT_EN10MB,
+                                              options.snapshot_length, filter, m_error_message)) {
+        Log::error(m_error_message);
+        return false;
+    }
+    
+    for (size_t i = 0; i < options.fanout_workers; ++i) {
+        auto worker = std::make_unique<Worker>();
+
+        if (!worker->ring.open(device_name, options) ||
+            (has_filter && !worker->ring.attach_filter(filter)) ||
+            !worker->ring.join_fanout(group_id, options.fanout_mode)) {
+            m_error_message = "Failed to open fanout socket " + std::to_string(i) +
+                              ": " + worker->ring.get_error();
+            Log::error(m_error_message);
+            m_workers.clear();
+            
+            if (has_filter) {
+                pcap_freecode(&filter);
+            }
+            return false;
+        }
+
+        worker->analyzer = analyzer_factory ? analyzer_factory()
+                                            : std::make_unique<ProtocolAnalyzer>();
+        m_workers.push_back(std::move(worker));
+    }
+
+    if (has_filter) {
+        pcap_freecode(&filter);
+    }
+    
+    Log::info("Initialized fanout capture on {} with {} workers (group {})",
+              device_name, m_workers.size(), group_id);
+    return true;
+}
+
+bool FanoutCapture::start(FanoutHandler handler) {
+    if (m_workers.empty()) {
+        m_error_message = "Fanout capture not initialized";
+        Log::error(m_error_message);
+        return false;
+    }
+
+    if (m_running) {
+        m_error_message = "Fanout capture already running";
+        Log::warning(m_error_message);
+        return false;
+    }
+
+    // Join the workers of a run that ended on an error
+    stop();
+
+    m_handler = std::move(handler);
+    m_next_worker = 0;
+    set_error("");
+    m_running = true;
+
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = *m_workers[i];
+        worker.packets = 0;
+        worker.bytes = 0;
+        worker.kernel_dropped = 0;
+        worker.queue_dropped = 0;
+        worker.queue = m_handler ? nullptr : std::make_unique<PacketRing<Packet>>(m_options.queue_capacity);
+        worker.thread = std::thread(&FanoutCapture::worker_main, this, i);
+    }
+
+    Log::info("Fanout capture started");
+    return true;
+}
+
+void FanoutCapture::stop() {
+    // A failed worker already cleared m_running, but the threads still need joining
+    bool stopped = false;
+    m_running = false;
+
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+            stopped = true;
+        }
+    }
+
+    if (stopped) {
+        Log::info("Fanout capture stopped");
+    }
+}
+
+uint64_t FanoutCapture::get_worker_packets(size_t worker) const {
+    if (worker >= m_workers.size()) {
+        return 0;
+    }
+
+    return m_workers[worker]->packets.load(std::memory_order_relaxed);
+}
+
+bool FanoutCapture::get_next_packet(Packet& packet) {
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = *m_workers[m_next_worker];
+        m_next_worker = (m_next_worker + 1) % m_workers.size();
+
+        if (worker.queue && worker.queue->try_pop(packet)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FanoutCapture::set_capture_filter(const struct bpf_program& program) {
+    // The kernel swaps the program atomically, so running workers are fine
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        if (!m_workers[i]->ring.attach_filter(program)) {
+            set_error("Failed to filter fanout socket " + std::to_string(i) + ": " +
+                      m_workers[i]->ring.get_error());
+            Log::error(get_error());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+CaptureStats FanoutCapture::get_stats() const {
+    CaptureStats stats;
+
+    for (const auto& worker : m_workers) {
+        stats.packets_received += worker->packets.load(std::memory_order_relaxed);
+        stats.bytes_received += worker->bytes.load(std::memory_order_relaxed);
+        stats.kernel_dropped += worker->kernel_dropped.load(std::memory_order_relaxed);
+        stats.queue_dropped += worker->queue_dropped.load(std::memory_order_relaxed);
+        stats.queue_depth += worker->queue ? worker->queue->size() : 0;
+    }
+
+    return stats;
+}
+
+std::string FanoutCapture::get_error() const {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_error_message;
+}
+
+void FanoutCapture::set_error(const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_error_message = message;
+}
+
+void FanoutCapture::worker_main(size_t index) {
+    Worker& worker = *m_workers[index];
+
+    if (!m_cpus.empty()) {
+        int cpu = m_cpus[index % m_cpus.size()];
+        std::string error;
+        if (!pin_current_thread({cpu}, error)) {
+            Log::warning("Fanout worker {} not pinned to CPU {}: {}", index, cpu, error);
+        }
+    }
+
+    auto process = [this, &worker, index](const PacketView& view) {
+        size_t captured_length = m_options.slicing ? m_slicer.slice_length(view.data, view.captured_length)
+                                                   : view.captured_length;
+        worker.packets.fetch_add(1, std::memory_order_relaxed);
+
+        if (worker.queue) {
+            auto fill = [&view, captured_length](Packet& slot) {
+                slot.timestamp = view.timestamp;
+                slot.actual_length = view.actual_length;
+                slot.captured_length = captured_length;
+                slot.sampling_rate = 1;
+                slot.data.assign(view.data, view.data + captured_length);
+            };
+
+            // Never stall the socket for a slow consumer
+            if (!worker.queue->try_push(fill)) {
+                worker.queue_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        worker.packet.timestamp = view.timestamp;
+        worker.packet.actual_length = view.actual_length;
+        worker.packet.captured_length = captured_length;
+        worker.packet.data.assign(view.data, view.data + captured_length);
+
+        worker.analyzer->analyze_packet(worker.packet, worker.decoded);
+
+        if (m_handler) {
+            m_handler(index, worker.decoded);
+        }
+    };
+
+    auto next_sample = std::chrono::steady_clock::now();
+
+    while (m_running.load(std::memory_order_acquire)) {
+        uint64_t bytes = 0;
+        if (worker.ring.dispatch(process, WORKER_BATCH, m_options.timeout_ms, &bytes) < 0) {
+            // One dead socket would silently skew the group, so stop them all
+            set_error("Fanout worker " + std::to_string(index) + " failed: " + worker.ring.get_error());
+            Log::error(get_error());
+            m_running = false;
+            break;
+        }
+        worker.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_sample) {
+            uint64_t dropped = 0;
+            if (worker.ring.read_statistics(dropped)) {
+                worker.kernel_dropped.store(dropped, std::memory_order_relaxed);
+            }
+            next_sample = now + KERNEL_STATS_INTERVAL;
+        }
+    }
+}
+
+} // namespace wireshark_mcp
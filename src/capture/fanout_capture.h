@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include "packet_capture.h"
+
+namespace wireshark_mcp {
+
+class TPacketRing;
+class ProtocolAnalyzer;
+struct DecodedPacket;
+
+// Creates the analyzer owned by one worker
+using AnalyzerFactory = std::function<std::unique_ptr<ProtocolAnalyzer>()>;
+
+// Receives each decoded packet on the worker thread that captured it
+using FanoutHandler = std::function<void(size_t worker, const DecodedPacket& decoded)>;
+
+// Multi-core capture built on PACKET_FANOUT.
+//
+// Opens one TPACKET_V3 socket per worker and joins them into a single fanout
+// group, so the kernel spreads receive work across cores. Each worker runs
+// its own capture -> analysis pipeline with a private ProtocolAnalyzer; in
+// HASH mode both directions of a conversation always land on the same worker.
+// Started without a handler, the workers queue raw frames instead, which is
+// how PacketCapture uses the group when capture.fanout_workers is set.
+class FanoutCapture {
+public:
+    FanoutCapture();
+    ~FanoutCapture();
+
+    FanoutCapture(const FanoutCapture&) = delete;
+    FanoutCapture& operator=(const FanoutCapture&) = delete;
+
+    // Open options.fanout_workers sockets on the device. When no factory is
+    // given every worker gets a default-constructed ProtocolAnalyzer.
+    bool initialize(const std::string& device_name, CaptureOptions options,
+                    AnalyzerFactory analyzer_factory = nullptr);
+
+    // Start one thread per socket. Without a handler each worker copies its
+    // frames into a queue of options.queue_capacity packets (full queues drop
+    // the newest frame) for get_next_packet().
+    bool start(FanoutHandler handler = nullptr);
+
+    // Stop and join all workers. Queued frames stay readable until the next
+    // start().
+    void stop();
+
+    // False once stopped, or when a worker failed (see get_error())
+    bool is_running() const { return m_running; }
+
+    size_t get_worker_count() const { return m_workers.size(); }
+
+    // Packets processed by one worker
+    uint64_t get_worker_packets(size_t worker) const;
+
+    // Take the next queued frame, visiting the workers round robin. Frames
+    // of one flow keep their order in HASH mode; frames of different
+    // workers are not merged by time. Single consumer only.
+    bool get_next_packet(Packet& packet);
+
+    // Replace the kernel filter on every socket of the group
+    bool set_capture_filter(const struct bpf_program& program);
+
+    // Packet, byte, kernel drop and queue counters summed over the workers
+    // (no rates)
+    CaptureStats get_stats() const;
+
+    std::string get_error() const;
+
+private:
+    struct Worker;
+
+    void worker_main(size_t index);
+    void set_error(const std::string& message);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    FanoutHandler m_handler;
+    CaptureOptions m_options;
+    std::vector<int> m_cpus;        // Worker i runs on m_cpus[i % size]; empty = unpinned
+    PacketSlicer m_slicer;
+    std::atomic<bool> m_running;
+    size_t m_next_worker;           // Queue get_next_packet() tries first
+    std::string m_error_message;
+    mutable std::mutex m_error_mutex;
+};
+
+} // namespace wireshark_mcp
@@ -0,0 +1,179 @@
+#include "flow_key.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint16_t ETHERTYPE_IPV6 = 0x86DD;
+constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint16_t ETHERTYPE_QINQ = 0x88A8;
+
+constexpr uint8_t IP_PROTO_TCP = 6;
+constexpr uint8_t IP_PROTO_UDP = 17;
+constexpr uint8_t IP_PROTO_SCTP = 132;
+
+constexpr uint8_t IPV6_HOP_BY_HOP = 0;
+constexpr uint8_t IPV6_ROUTING = 43;
+constexpr uint8_t IPV6_FRAGMENT = 44;
+constexpr uint8_t IPV6_DEST_OPTIONS = 60;
+constexpr int IPV6_MAX_EXTENSIONS = 8;
+
+constexpr size_t ETHERNET_HEADER_LEN = 14;
+constexpr size_t VLAN_TAG_LEN = 4;
+constexpr size_t IPV4_MIN_HEADER_LEN = 20;
+constexpr size_t IPV6_HEADER_LEN = 40;
+constexpr size_t TCP_FLAGS_OFFSET = 13;
+
+uint16_t read_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint64_t read_u64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// splitmix64 finalizer: spreads every input bit over the whole word
+uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+} // namespace
+
+bool FlowKey::normalize() {
+    int order = std::memcmp(address_a.data(), address_b.data(), address_a.size());
+    
+    if (order > 0 || (order == 0 && port_a > port_b)) {
+        std::swap(address_a, address_b);
+        std::swap(port_a, port_b);
+        return true;
+    }
+    return false;
+}
+
+uint64_t FlowKey::hash() const {
+    uint64_t h = mix(read_u64(address_a.data()) ^ 0x9E3779B97F4A7C15ULL);
+    h = mix(h ^ read_u64(address_a.data() + 8));
+    h = mix(h ^ read_u64(address_b.data()));
+    h = mix(h ^ read_u64(address_b.data() + 8));
+    
+    uint64_t tail = (static_cast<uint64_t>(port_a) << 48) | (static_cast<uint64_t>(port_b) << 32) |
+                    (static_cast<uint64_t>(ip_protocol) << 8) | ip_version;
+    return mix(h ^ tail);
+}
+
+bool FlowKey::operator==(const FlowKey& other) const {
+    return address_a == other.address_a && address_b == other.address_b &&
+           port_a == other.port_a && port_b == other.port_b &&
+           ip_protocol == other.ip_protocol && ip_version == other.ip_version;
+}
+
+bool extract_flow_key(const uint8_t* data, size_t captured_length, FlowKey& key) {
+    FlowPacketInfo info;
+    return extract_flow_key(data, captured_length, key, info);
+}
+
+bool extract_flow_key(const uint8_t* data, size_t captured_length, FlowKey& key, FlowPacketInfo& info) {
+    if (captured_length < ETHERNET_HEADER_LEN) {
+        return false;
+    }
+    
+    size_t offset = ETHERNET_HEADER_LEN;
+    uint16_t ethertype = read_be16(data + 12);
+    
+    while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) &&
+           offset + VLAN_TAG_LEN <= captured_length) {
+        ethertype = read_be16(data + offset + 2);
+        offset += VLAN_TAG_LEN;
+    }
+    
+    key = FlowKey();
+    info = FlowPacketInfo();
+    bool fragmented = false;
+    
+    if (ethertype == ETHERTYPE_IPV4) {
+        if (offset + IPV4_MIN_HEADER_LEN > captured_length) {
+            return false;
+        }
+        
+        size_t header_length = static_cast<size_t>(data[offset] & 0x0F) * 4;
+        if (header_length < IPV4_MIN_HEADER_LEN) {
+            return false;
+        }
+        
+        key.ip_version = 4;
+        key.ip_protocol = data[offset + 9];
+        std::memcpy(key.address_a.data(), data + offset + 12, 4);
+        std::memcpy(key.address_b.data(), data + offset + 16, 4);
+        
+        // More-fragments flag or a non-zero offset
+        fragmented = (read_be16(data + offset + 6) & 0x3FFF) != 0;
+        offset += header_length;
+    } else if (ethertype == ETHERTYPE_IPV6) {
+        if (offset + IPV6_HEADER_LEN > captured_length) {
+            return false;
+        }
+        
+        key.ip_version = 6;
+        std::memcpy(key.address_a.data(), data + offset + 8, 16);
+        std::memcpy(key.address_b.data(), data + offset + 24, 16);
+        
+        uint8_t next_header = data[offset + 6];
+        offset += IPV6_HEADER_LEN;
+        
+        for (int i = 0; i < IPV6_MAX_EXTENSIONS; ++i) {
+            if (next_header != IPV6_HOP_BY_HOP && next_header != IPV6_ROUTING &&
+                next_header != IPV6_FRAGMENT && next_header != IPV6_DEST_OPTIONS) {
+                break;
+            }
+            
+            if (offset + 8 > captured_length) {
+                return false;
+            }
+            
+            size_t length = 8;
+            if (next_header == IPV6_FRAGMENT) {
+                fragmented = true;
+            } else {
+                length = (static_cast<size_t>(data[offset + 1]) + 1) * 8;
+            }
+            
+            next_header = data[offset];
+            offset += length;
+        }
+        
+        key.ip_protocol = next_header;
+    } else {
+        return false;
+    }
+    
+    // TCP, UDP and SCTP all start with the two ports
+    if (!fragmented && (key.ip_protocol == IP_PROTO_TCP || key.ip_protocol == IP_PROTO_UDP ||
+                        key.ip_protocol == IP_PROTO_SCTP)) {
+        if (offset + 4 > captured_length) {
+            return false;
+        }
+        
+        key.port_a = read_be16(data + offset);
+        key.port_b = read_be16(data + offset + 2);
+        
+        if (key.ip_protocol == IP_PROTO_TCP && offset + TCP_FLAGS_OFFSET < captured_length) {
+            info.tcp_flags = data[offset + TCP_FLAGS_OFFSET];
+        }
+    }
+    
+    info.reversed = key.normalize();
+    return true;
+}
+
+} // namespace wireshark_mcp
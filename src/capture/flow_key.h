@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace wireshark_mcp {
+
+// Transport 5-tuple identifying a conversation.
+//
+// Keys are normalized so that both directions of a conversation compare and
+// hash equal: endpoint A is always the lower (address, port) pair. IPv4
+// addresses occupy the first four bytes of the address arrays.
+struct FlowKey {
+    std::array<uint8_t, 16> address_a{};
+    std::array<uint8_t, 16> address_b{};
+    uint16_t port_a = 0;
+    uint16_t port_b = 0;
+    uint8_t ip_protocol = 0;
+    uint8_t ip_version = 0;
+
+    // Swap the endpoints if needed so A <= B; true when they were swapped
+    bool normalize();
+
+    // Direction-independent hash of a normalized key, well mixed in every bit
+    uint64_t hash() const;
+
+    bool operator==(const FlowKey& other) const;
+    bool operator!=(const FlowKey& other) const { return !(*this == other); }
+};
+
+// Extract the normalized flow key of an Ethernet frame (VLAN tags and IPv6
+// extension headers are skipped). Returns false for non-IP or truncated
+// frames. Fragments carry no ports, so all fragmented datagrams of a
+// conversation share the key with ports set to 0.
+bool extract_flow_key(const uint8_t* data, size_t captured_length, FlowKey& key);
+
+// What the normalized key leaves out about the frame itself
+struct FlowPacketInfo {
+    bool reversed = false;      // Sent from endpoint B to endpoint A
+    uint8_t tcp_flags = 0;      // Flags of an unfragmented TCP segment, else 0
+};
+
+// As above, also reporting the frame's direction and TCP flags
+bool extract_flow_key(const uint8_t* data, size_t captured_length, FlowKey& key, FlowPacketInfo& info);
+
+// Hasher for unordered containers keyed by FlowKey
+struct FlowKeyHash {
+    size_t operator()(const FlowKey& key) const { return static_cast<size_t>(key.hash()); }
+};
+
+} // namespace wireshark_mcp
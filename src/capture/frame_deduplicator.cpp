@@ -0,0 +1,201 @@
+#include "frame_deduplicator.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint16_t ETHERTYPE_IPV6 = 0x86DD;
+constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint16_t ETHERTYPE_QINQ = 0x88A8;
+
+constexpr size_t ETHERNET_HEADER_LEN = 14;
+constexpr size_t VLAN_TAG_LEN = 4;
+constexpr size_t IPV4_MIN_HEADER_LEN = 20;
+constexpr size_t IPV4_MAX_HEADER_LEN = 60;
+constexpr size_t IPV6_HEADER_LEN = 40;
+
+// Volatile fields rewritten hop by hop
+constexpr size_t IPV4_TTL_OFFSET = 8;
+constexpr size_t IPV4_CHECKSUM_OFFSET = 10;
+constexpr size_t IPV6_HOP_LIMIT_OFFSET = 7;
+
+constexpr uint64_t HASH_MULTIPLIER_1 = 0x87C37B91114253D5ULL;
+constexpr uint64_t HASH_MULTIPLIER_2 = 0x4CF5AD432745937FULL;
+
+uint16_t read_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint64_t rotate_left(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Eight bytes per step; the caller mixes the result
+uint64_t hash_bytes(const uint8_t* data, size_t length, uint64_t h) {
+    while (length >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        h ^= rotate_left(word * HASH_MULTIPLIER_1, 31) * HASH_MULTIPLIER_2;
+        h = rotate_left(h, 27) * 5 + 0x52DCE729;
+        data += 8;
+        length -= 8;
+    }
+    
+    uint64_t tail = 0;
+    std::memcpy(&tail, data, length);
+    h ^= rotate_left(tail * HASH_MULTIPLIER_1, 31) * HASH_MULTIPLIER_2;
+    return h;
+}
+
+// Network header position of an Ethernet frame, 0 when it is not IP
+size_t ip_header_offset(const uint8_t* data, size_t captured_length, uint16_t& ethertype) {
+    if (captured_length < ETHERNET_HEADER_LEN) {
+        return 0;
+    }
+    
+    size_t offset = ETHERNET_HEADER_LEN;
+    ethertype = read_be16(data + 12);
+    
+    while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) &&
+           offset + VLAN_TAG_LEN <= captured_length) {
+        ethertype = read_be16(data + offset + 2);
+        offset += VLAN_TAG_LEN;
+    }
+    
+    return ethertype == ETHERTYPE_IPV4 || ethertype == ETHERTYPE_IPV6 ? offset : 0;
+}
+
+} // namespace
+
+uint64_t frame_fingerprint(const uint8_t* data, size_t captured_length, size_t actual_length,
+                           bool ethernet) {
+    uint16_t ethertype = 0;
+    size_t offset = ethernet ? ip_header_offset(data, captured_length, ethertype) : 0;
+    
+    if (offset == 0) {
+        uint64_t seed = (static_cast<uint64_t>(captured_length) << 32) ^ actual_length;
+        return mix(hash_bytes(data, captured_length, seed));
+    }
+    
+    // Copy the IP header so the volatile fields can be blanked
+    uint8_t header[IPV4_MAX_HEADER_LEN];
+    size_t header_length = IPV6_HEADER_LEN;
+    
+    if (ethertype == ETHERTYPE_IPV4) {
+        header_length = offset + IPV4_MIN_HEADER_LEN <= captured_length
+                            ? std::max(static_cast<size_t>(data[offset] & 0x0F) * 4, IPV4_MIN_HEADER_LEN)
+                            : IPV4_MIN_HEADER_LEN;
+    }
+    header_length = std::min(header_length, captured_length - offset);
+    std::memcpy(header, data + offset, header_length);
+    
+    if (ethertype == ETHERTYPE_IPV4 && header_length >= IPV4_MIN_HEADER_LEN) {
+        header[IPV4_TTL_OFFSET] = 0;
+        header[IPV4_CHECKSUM_OFFSET] = 0;
+        header[IPV4_CHECKSUM_OFFSET + 1] = 0;
+    } else if (ethertype == ETHERTYPE_IPV6 && header_length == IPV6_HEADER_LEN) {
+        header[IPV6_HOP_LIMIT_OFFSET] = 0;
+    }
+    
+    // Lengths from the network header on, so added or removed VLAN tags do not matter
+    uint64_t seed = (static_cast<uint64_t>(captured_length - offset) << 32) ^
+                    (actual_length > offset ? actual_length - offset : 0);
+    uint64_t h = hash_bytes(header, header_length, seed);
+    h = hash_bytes(data + offset + header_length, captured_length - offset - header_length, h);
+    
+    return mix(h);
+}
+
+FrameDeduplicator::FrameDeduplicator()
+    : m_bucket_mask(0),
+      m_window_us(0),
+      m_ethernet(true),
+      m_duplicates(0) {
+}
+
+void FrameDeduplicator::configure(uint32_t window_us, size_t table_entries, bool ethernet) {
+    size_t buckets = 1;
+    while (buckets * SLOTS_PER_BUCKET < table_entries) {
+        buckets *= 2;
+    }
+    
+    m_slots.assign(buckets * SLOTS_PER_BUCKET, Slot{0, 0});
+    m_bucket_mask = buckets - 1;
+    m_window_us = std::min<uint32_t>(window_us, 0x7FFFFFFF);
+    m_ethernet = ethernet;
+    m_duplicates.store(0, std::memory_order_relaxed);
+}
+
+void FrameDeduplicator::reset() {
+    std::fill(m_slots.begin(), m_slots.end(), Slot{0, 0});
+    m_duplicates.store(0, std::memory_order_relaxed);
+}
+
+bool FrameDeduplicator::is_duplicate(const uint8_t* data, size_t captured_length, size_t actual_length,
+                                     uint64_t timestamp_ns) {
+    if (m_slots.empty()) {
+        return false;
+    }
+    
+    uint64_t h = frame_fingerprint(data, captured_length, actual_length, m_ethernet);
+    uint32_t tag = static_cast<uint32_t>(h >> 32) | 1;
+    uint32_t now = static_cast<uint32_t>(timestamp_ns / 1000);
+    
+    // Second bucket derived from the tag, as in a cuckoo filter
+    size_t buckets[2];
+    buckets[0] = static_cast<size_t>(h) & m_bucket_mask;
+    buckets[1] = (buckets[0] ^ (static_cast<size_t>(tag) * 0x5BD1E995)) & m_bucket_mask;
+    
+    Slot* victim = nullptr;
+    bool victim_free = false;
+    uint32_t victim_age = 0;
+    
+    for (size_t bucket : buckets) {
+        Slot* slots = &m_slots[bucket * SLOTS_PER_BUCKET];
+        
+        for (size_t i = 0; i < SLOTS_PER_BUCKET; ++i) {
+            Slot& slot = slots[i];
+            
+            // Distance in either direction, so reordered copies still match
+            uint32_t delta = now - slot.time_us;
+            uint32_t age = std::min(delta, 0u - delta);
+            bool live = slot.tag != 0 && age <= m_window_us;
+            
+            if (live && slot.tag == tag) {
+                m_duplicates.store(m_duplicates.load(std::memory_order_relaxed) + 1,
+                                   std::memory_order_relaxed);
+                return true;
+            }
+            
+            if (!live) {
+                if (!victim_free) {
+                    victim = &slot;
+                    victim_free = true;
+                }
+            } else if (!victim_free && (victim == nullptr || age >= victim_age)) {
+                victim = &slot;
+                victim_age = age;
+            }
+        }
+    }
+    
+    victim->tag = tag;
+    victim->time_us = now;
+    return false;
+}
+
+} // namespace wireshark_mcp
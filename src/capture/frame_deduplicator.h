@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wireshark_mcp {
+
+// Content fingerprint of a frame that survives a trip through a router or a
+// second mirror port. For IP frames on Ethernet the link header (MACs, VLAN
+// tags) is skipped and the IPv4 TTL and header checksum, or the IPv6 hop
+// limit, are ignored. Other frames are hashed whole.
+uint64_t frame_fingerprint(const uint8_t* data, size_t captured_length, size_t actual_length,
+                           bool ethernet);
+
+// Drops frames that were already seen within a short time window, as SPAN
+// and mirror setups tend to deliver the same frame twice.
+//
+// Fingerprints live in a compact bucketized table: each fingerprint has two
+// candidate buckets of four 8-byte slots (a 32-bit tag and the microsecond
+// time it was seen). Slots older than the window count as free, so the table
+// never needs sweeping; when all eight candidates are live the oldest one is
+// overwritten, which costs a missed duplicate. Tags keep 31 hash bits (the
+// low bit marks a used slot), so a distinct frame matching one of up to eight
+// live tags is dropped as a duplicate with probability about 8 / 2^31, or one
+// frame in roughly 270 million.
+class FrameDeduplicator {
+public:
+    FrameDeduplicator();
+
+    // Window in microseconds (below ~35 minutes) and table size in entries,
+    // rounded up to a power of two
+    void configure(uint32_t window_us, size_t table_entries, bool ethernet);
+
+    // Forget every fingerprint and zero the counter
+    void reset();
+
+    // True when the same frame was seen within the window of timestamp_ns;
+    // otherwise the frame is remembered and false returned
+    bool is_duplicate(const uint8_t* data, size_t captured_length, size_t actual_length,
+                      uint64_t timestamp_ns);
+
+    // Safe to read from any thread
+    uint64_t get_duplicates() const { return m_duplicates.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        uint32_t tag;           // 0 = empty
+        uint32_t time_us;       // Wraps every ~71 minutes; compared as a signed delta
+    };
+
+    static constexpr size_t SLOTS_PER_BUCKET = 4;
+
+    std::vector<Slot> m_slots;
+    size_t m_bucket_mask;
+    uint32_t m_window_us;
+    bool m_ethernet;
+    std::atomic<uint64_t> m_duplicates;
+};
+
+} // namespace wireshark_mcp
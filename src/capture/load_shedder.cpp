@@ -0,0 +1,120 @@
+#include "load_shedder.h"
+#include "flow_key.h"
+#include "../common/logging.h"
+
+#include <algorithm>
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Escalate quickly so the queue does not overflow, relax slowly so a burst
+// that just ended does not make the rate oscillate
+constexpr auto SHED_ESCALATE_INTERVAL = std::chrono::milliseconds(10);
+constexpr auto SHED_RELAX_INTERVAL = std::chrono::milliseconds(1000);
+
+// Largest power of two not above value (value >= 1)
+uint32_t floor_power_of_two(uint32_t value) {
+    uint32_t power = 1;
+    while (power <= value / 2) {
+        power *= 2;
+    }
+    return power;
+}
+
+// Flow hash bits are already spent downstream: the low ones pick the worker
+// and the flow table slot, the high ones the table tag. Sampling re-mixes the
+// hash with its own seed so the kept flows stay spread over all of them.
+constexpr uint64_t SAMPLING_SEED = 0x5851F42D4C957F2DULL;
+
+uint64_t sampling_hash(uint64_t flow_hash) {
+    uint64_t value = flow_hash ^ SAMPLING_SEED;
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+} // namespace
+
+LoadShedder::LoadShedder()
+    : m_mode(SheddingMode::OFF),
+      m_high_watermark(0.75),
+      m_low_watermark(0.25),
+      m_max_rate(64),
+      m_rate(1),
+      m_shed_packets(0),
+      m_packet_counter(0) {
+}
+
+void LoadShedder::configure(SheddingMode mode, double high_watermark, double low_watermark,
+                            uint32_t max_rate) {
+    m_mode = mode;
+    m_high_watermark = high_watermark;
+    m_low_watermark = std::min(low_watermark, high_watermark);
+    m_max_rate = floor_power_of_two(std::max<uint32_t>(max_rate, 1));
+    reset();
+}
+
+void LoadShedder::reset() {
+    m_rate.store(1, std::memory_order_relaxed);
+    m_shed_packets.store(0, std::memory_order_relaxed);
+    m_packet_counter = 0;
+    m_last_change = std::chrono::steady_clock::time_point();
+}
+
+void LoadShedder::update(size_t queue_depth, size_t queue_capacity,
+                         std::chrono::steady_clock::time_point now) {
+    if (m_mode == SheddingMode::OFF || queue_capacity == 0) {
+        return;
+    }
+    
+    double fill = static_cast<double>(queue_depth) / static_cast<double>(queue_capacity);
+    uint32_t rate = m_rate.load(std::memory_order_relaxed);
+    
+    if (fill >= m_high_watermark && rate < m_max_rate &&
+        now - m_last_change >= SHED_ESCALATE_INTERVAL) {
+        rate *= 2;
+        Log::warning("Capture queue {}% full, sampling 1 in {} {}", static_cast<int>(fill * 100.0), rate,
+                     m_mode == SheddingMode::FLOW ? "flows" : "packets");
+    } else if (fill <= m_low_watermark && rate > 1 &&
+               now - m_last_change >= SHED_RELAX_INTERVAL) {
+        rate /= 2;
+        Log::info("Capture queue drained, sampling 1 in {}", rate);
+    } else {
+        return;
+    }
+    
+    m_rate.store(rate, std::memory_order_relaxed);
+    m_last_change = now;
+}
+
+uint32_t LoadShedder::admit(const uint8_t* data, size_t captured_length) {
+    uint32_t rate = m_rate.load(std::memory_order_relaxed);
+    if (rate == 1) {
+        return 1;
+    }
+    
+    bool keep;
+    FlowKey key;
+    
+    // Rates are powers of two, so the low bits of the sampling hash select
+    // the sample
+    if (m_mode == SheddingMode::FLOW && extract_flow_key(data, captured_length, key)) {
+        keep = (sampling_hash(key.hash()) & (rate - 1)) == 0;
+    } else {
+        keep = (m_packet_counter++ & (rate - 1)) == 0;
+    }
+    
+    if (!keep) {
+        m_shed_packets.store(m_shed_packets.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+        return 0;
+    }
+    
+    return rate;
+}
+
+} // namespace wireshark_mcp
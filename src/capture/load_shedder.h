@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace wireshark_mcp {
+
+// How the capture thread sheds load when the consumer falls behind
+enum class SheddingMode {
+    OFF,            // Never sample; overflow_policy alone decides what is lost
+    FLOW,           // Keep whole conversations: 1 in N flows by symmetric flow hash
+    PACKET          // Keep every Nth packet regardless of flow
+};
+
+// Adaptive sampling stage between the capture backend and the queue.
+//
+// The sampling rate N starts at 1 and doubles while the queue stays above the
+// high watermark, then halves again once it has drained below the low
+// watermark. Rates are powers of two, so in FLOW mode the flows kept at 2N
+// are a subset of those kept at N: a conversation is never split by a rate
+// change in the direction of shedding more. Frames without a flow key (non-IP
+// or non-Ethernet) fall back to packet sampling. Each admitted packet carries
+// the rate it was sampled at, so counts can be scaled back up.
+class LoadShedder {
+public:
+    LoadShedder();
+
+    void configure(SheddingMode mode, double high_watermark, double low_watermark, uint32_t max_rate);
+
+    // Clear the rate and counters for a new capture
+    void reset();
+
+    SheddingMode get_mode() const { return m_mode; }
+
+    // Adjust the rate from the queue fill level. Call once per batch.
+    void update(size_t queue_depth, size_t queue_capacity,
+                std::chrono::steady_clock::time_point now);
+
+    // Sampling rate the frame represents, or 0 when it is shed
+    uint32_t admit(const uint8_t* data, size_t captured_length);
+
+    // Safe to read from any thread
+    uint32_t get_rate() const { return m_rate.load(std::memory_order_relaxed); }
+    uint64_t get_shed_packets() const { return m_shed_packets.load(std::memory_order_relaxed); }
+
+private:
+    SheddingMode m_mode;
+    double m_high_watermark;
+    double m_low_watermark;
+    uint32_t m_max_rate;
+
+    std::atomic<uint32_t> m_rate;
+    std::atomic<uint64_t> m_shed_packets;
+    uint64_t m_packet_counter;
+    std::chrono::steady_clock::time_point m_last_change;
+};
+
+} // namespace wireshark_mcp
@@ -0,0 +1,311 @@
+#include "multi_capture.h"
+#include "../common/logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace wireshark_mcp {
+
+namespace {
+
+uint64_t wall_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+std::vector<std::string> parse_device_list(const std::string& devices) {
+    std::vector<std::string> result;
+    std::istringstream stream(devices);
+    std::string device;
+    
+    while (std::getline(stream, device, ',')) {
+        size_t first = device.find_first_not_of(" \t");
+        if (first == std::string::npos) {
+            continue;
+        }
+        size_t last = device.find_last_not_of(" \t");
+        result.push_back(device.substr(first, last - first + 1));
+    }
+    
+    return result;
+}
+
+MultiCapture::MultiCapture()
+    : m_dedup_enabled(false),
+      m_last_timestamp(0),
+      m_late_packets(0) {
+}
+
+MultiCapture::~MultiCapture() {
+    stop_capture();
+}
+
+bool MultiCapture::initialize(const std::vector<std::string>& device_names, CaptureOptions options) {
+    return open_sources(device_names, options, false);
+}
+
+bool MultiCapture::initialize_files(const std::vector<std::string>& file_paths, CaptureOptions options) {
+    return open_sources(file_paths, options, true);
+}
+
+bool MultiCapture::open_sources(const std::vector<std::string>& names, CaptureOptions options,
+                                bool files) {
+    stop_capture();
+    m_sources.clear();
+    m_heap.clear();
+    
+    if (names.empty()) {
+        m_error_message = "No capture sources given";
+        Log::error(m_error_message);
+        return false;
+    }
+    
+    // Each source needs its own thread so a busy one cannot starve the rest
+    options.use_capture_thread = true;
+    m_options = options;
+    
+    // Duplicates across interfaces are only visible after the merge
+    m_dedup_enabled = options.dedup;
+    options.dedup = false;
+    
+    for (const auto& name : names) {
+        auto source = std::make_unique<Source>();
+        bool opened = files ? source->capture.initialize_file(name, options)
+                            : source->capture.initialize_device(name, options);
+        
+        if (!opened) {
+            m_error_message = "Failed to open " + name + ": " + source->capture.get_error();
+            Log::error(m_error_message);
+            m_sources.clear();
+            return false;
+        }
+        
+        m_sources.push_back(std::move(source));
+    }
+    
+    if (m_dedup_enabled) {
+        bool ethernet = std::all_of(m_sources.begin(), m_sources.end(), [](const auto& source) {
+            return source->capture.get_datalink() == DLT_EN10MB;
+        });
+        m_dedup.configure(static_cast<uint32_t>(std::max(m_options.dedup_window_us, 0)),
+                          m_options.dedup_table_size, ethernet);
+    }
+    
+    Log::info("Initialized merged capture on {} sources (reorder window {} us)",
+              m_sources.size(), options.reorder_window_us);
+    return true;
+}
+
+bool MultiCapture::start_capture() {
+    if (m_sources.empty()) {
+        m_error_message = "Capture devices not initialized";
+        Log::error(m_error_message);
+        return false;
+    }
+    
+    m_heap.clear();
+    m_last_timestamp = 0;
+    m_late_packets = 0;
+    
+    if (m_dedup_enabled) {
+        m_dedup.reset();
+    }
+    
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        m_sources[i]->has_head = false;
+        m_sources[i]->live = true;
+        
+        if (!m_sources[i]->capture.start_capture()) {
+            m_error_message = "Failed to start capture on " + get_device_name(i) + ": " +
+                              m_sources[i]->capture.get_error();
+            Log::error(m_error_message);
+            
+            for (size_t j = 0; j < i; ++j) {
+                m_sources[j]->capture.stop_capture();
+            }
+            return false;
+        }
+    }
+    
+    Log::info("Merged capture started on {} sources", m_sources.size());
+    return true;
+}
+
+void MultiCapture::stop_capture() {
+    for (auto& source : m_sources) {
+        source->capture.stop_capture();
+    }
+}
+
+bool MultiCapture::is_capturing() const {
+    if (!m_heap.empty()) {
+        return true;
+    }
+    
+    // Stopped devices may still hold queued packets
+    for (const auto& source : m_sources) {
+        if (source->capture.is_capturing() || source->capture.get_queue_counters().depth > 0) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+std::string MultiCapture::get_device_name(size_t source) const {
+    if (source >= m_sources.size()) {
+        return "";
+    }
+    
+    return m_sources[source]->capture.get_device_name();
+}
+
+bool MultiCapture::later(size_t a, size_t b) const {
+    uint64_t ta = m_sources[a]->head.timestamp;
+    uint64_t tb = m_sources[b]->head.timestamp;
+    
+    // Ties go to the lower device index so the merge is deterministic
+    return ta != tb ? ta > tb : a > b;
+}
+
+void MultiCapture::refill_heads() {
+    auto order = [this](size_t a, size_t b) { return later(a, b); };
+    
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        Source& source = *m_sources[i];
+        
+        if (source.has_head) {
+            continue;
+        }
+        
+        // Read the state first: a source that had already stopped and still
+        // has nothing queued will never deliver again
+        bool live = source.capture.is_capturing();
+        
+        if (source.capture.get_next_packet(source.head)) {
+            source.has_head = true;
+            m_heap.push_back(i);
+            std::push_heap(m_heap.begin(), m_heap.end(), order);
+        } else {
+            source.live = live;
+        }
+    }
+}
+
+bool MultiCapture::get_next_packet(Packet& packet, size_t* source_index) {
+    while (next_merged(packet, source_index)) {
+        if (!m_dedup_enabled || !m_dedup.is_duplicate(packet.data.data(), packet.captured_length,
+                                                      packet.actual_length, packet.timestamp)) {
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool MultiCapture::next_merged(Packet& packet, size_t* source_index) {
+    refill_heads();
+    
+    if (m_heap.empty()) {
+        return false;
+    }
+    
+    size_t first = m_heap.front();
+    Source& source = *m_sources[first];
+    
+    // Only a live source with nothing pending could still deliver an
+    // earlier packet; wait for it until the window runs out
+    bool waiting = false;
+    for (const auto& other : m_sources) {
+        if (!other->has_head && other->live) {
+            if (other->capture.is_offline()) {
+                return false;
+            }
+            waiting = true;
+        }
+    }
+    
+    if (waiting) {
+        uint64_t window_ns = static_cast<uint64_t>(std::max(m_options.reorder_window_us, 0)) * 1000;
+        if (source.head.timestamp + window_ns > wall_clock_ns()) {
+            return false;
+        }
+    }
+    
+    auto order = [this](size_t a, size_t b) { return later(a, b); };
+    std::pop_heap(m_heap.begin(), m_heap.end(), order);
+    m_heap.pop_back();
+    
+    if (source.head.timestamp < m_last_timestamp) {
+        ++m_late_packets;
+    } else {
+        m_last_timestamp = source.head.timestamp;
+    }
+    
+    // The caller's old buffer goes back to the device queue for reuse
+    std::swap(packet, source.head);
+    source.has_head = false;
+    
+    if (source_index) {
+        *source_index = first;
+    }
+    
+    return true;
+}
+
+size_t MultiCapture::get_next_packets(std::vector<Packet>& packets, size_t max_packets) {
+    if (packets.size() < max_packets) {
+        packets.resize(max_packets);
+    }
+    
+    size_t count = 0;
+    while (count < max_packets && get_next_packet(packets[count])) {
+        ++count;
+    }
+    
+    return count;
+}
+
+bool MultiCapture::set_capture_filter(const std::string& filter) {
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        if (!m_sources[i]->capture.set_capture_filter(filter)) {
+            m_error_message = m_sources[i]->capture.get_error();
+            return false;
+        }
+    }
+    
+    m_options.capture_filter = filter;
+    return true;
+}
+
+CaptureStats MultiCapture::get_stats() {
+    CaptureStats total;
+    
+    for (auto& source : m_sources) {
+        CaptureStats stats = source->capture.get_stats();
+        
+        total.packets_received += stats.packets_received;
+        total.bytes_received += stats.bytes_received;
+        total.kernel_dropped += stats.kernel_dropped;
+        total.interface_dropped += stats.interface_dropped;
+        total.queue_dropped += stats.queue_dropped;
+        total.shed_packets += stats.shed_packets;
+        total.duplicates_dropped += stats.duplicates_dropped;
+        total.sampling_rate = std::max(total.sampling_rate, stats.sampling_rate);
+        total.queue_depth += stats.queue_depth;
+        total.queue_high_water = std::max(total.queue_high_water, stats.queue_high_water);
+        total.packets_per_second += stats.packets_per_second;
+        total.bytes_per_second += stats.bytes_per_second;
+    }
+    
+    if (m_dedup_enabled) {
+        total.duplicates_dropped += m_dedup.get_duplicates();
+    }
+    
+    return total;
+}
+
+} // namespace wireshark_mcp
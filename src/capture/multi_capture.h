@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "packet_capture.h"
+
+namespace wireshark_mcp {
+
+// Simultaneous capture from several interfaces merged into one stream.
+//
+// Every device gets its own PacketCapture running on a capture thread. The
+// consumer side performs a k-way heap merge over the per-device queues: the
+// earliest pending packet is released as soon as every live device has a
+// packet pending, or once it is older than the reorder window. A device that
+// stays quiet therefore delays the stream by at most the window; packets
+// arriving later than that are delivered immediately and counted as late.
+// With options.dedup the merged stream is deduplicated as a whole, so a frame
+// mirrored onto two of the interfaces is only delivered once.
+class MultiCapture {
+public:
+    MultiCapture();
+    ~MultiCapture();
+
+    MultiCapture(const MultiCapture&) = delete;
+    MultiCapture& operator=(const MultiCapture&) = delete;
+
+    // Open every device with the same options (a capture thread is always used)
+    bool initialize(const std::vector<std::string>& device_names, CaptureOptions options);
+
+    // Merge capture files instead. Files always deliver eventually, so they
+    // are merged strictly in timestamp order without a window.
+    bool initialize_files(const std::vector<std::string>& file_paths, CaptureOptions options);
+
+    bool start_capture();
+    void stop_capture();
+
+    // True while any device is still capturing or packets remain to be merged
+    bool is_capturing() const;
+
+    // Next packet in timestamp order (non-blocking). When source is given it
+    // receives the index of the device the packet came from.
+    bool get_next_packet(Packet& packet, size_t* source = nullptr);
+
+    // Batch form of get_next_packet, same reuse rules as
+    // PacketCapture::get_next_packets
+    size_t get_next_packets(std::vector<Packet>& packets, size_t max_packets);
+
+    // Install the same kernel filter on every device
+    bool set_capture_filter(const std::string& filter);
+
+    size_t get_source_count() const { return m_sources.size(); }
+    std::string get_device_name(size_t source) const;
+    const CaptureOptions& get_options() const { return m_options; }
+
+    // Statistics summed over all devices (high-water mark and sampling rate
+    // are the largest)
+    CaptureStats get_stats();
+
+    // Packets released out of timestamp order because they missed the window
+    uint64_t get_late_packets() const { return m_late_packets; }
+
+    std::string get_error() const { return m_error_message; }
+
+private:
+    struct Source {
+        PacketCapture capture;
+        Packet head;
+        bool has_head = false;
+        bool live = false;      // Still capturing when last found empty
+    };
+
+    bool open_sources(const std::vector<std::string>& names, CaptureOptions options, bool files);
+    
+    // Merge step of get_next_packet, before duplicate elimination
+    bool next_merged(Packet& packet, size_t* source);
+
+    // Pull a head packet for every source that lacks one
+    void refill_heads();
+
+    // Heap order: true when source a's head is due after source b's, so the
+    // earliest packet sits on top
+    bool later(size_t a, size_t b) const;
+
+    std::vector<std::unique_ptr<Source>> m_sources;
+    std::vector<size_t> m_heap;     // Indices of sources holding a head packet
+    CaptureOptions m_options;
+    FrameDeduplicator m_dedup;
+    bool m_dedup_enabled;
+    uint64_t m_last_timestamp;
+    uint64_t m_late_packets;
+    std::string m_error_message;
+};
+
+// Split a comma-separated device list (e.g. capture.default_device)
+std::vector<std::string> parse_device_list(const std::string& devices);
+
+} // namespace wireshark_mcp
@@ -1,57 +1,526 @@
 #include "packet_capture.h"
+#include "fanout_capture.h"
+#include "tpacket_ring.h"
+#include "traffic_generator.h"
 #include "../common/logging.h"
+#include "../common/config.h"
+#include "../common/cpu_affinity.h"
 #include "../security/auth_manager.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 namespace wireshark_mcp {
 
+namespace {
+
+// Frames pulled from the backend per capture thread iteration
+constexpr size_t CAPTURE_THREAD_BATCH = 256;
+
+// Longest single sleep while pacing a replay, so stop requests are honoured
+constexpr auto REPLAY_SLEEP_SLICE = std::chrono::milliseconds(100);
+
+// How often the capture thread refreshes the kernel drop counters
+constexpr auto KERNEL_STATS_INTERVAL = std::chrono::milliseconds(250);
+
+// Open and activate a live pcap handle sized from the options
+pcap_t* open_live_handle(const std::string& device_name, const CaptureOptions& options,
+                         std::string& error) {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    
+    pcap_t* handle = pcap_create(device_name.c_str(), errbuf);
+    if (handle == nullptr) {
+        error = errbuf;
+        return nullptr;
+    }
+    
+    // Buffer size and immediate mode can only be set before activation
+    pcap_set_snaplen(handle, options.snapshot_length);
+    pcap_set_promisc(handle, options.promiscuous_mode ? 1 : 0);
+    pcap_set_timeout(handle, options.timeout_ms);
+    pcap_set_immediate_mode(handle, options.immediate_mode ? 1 : 0);
+    
+    // Older kernels and libpcap builds only stamp in microseconds
+    if (pcap_set_tstamp_precision(handle, PCAP_TSTAMP_PRECISION_NANO) != 0) {
+        Log::info("Nanosecond timestamps not supported on {}, using microseconds", device_name);
+    }
+    
+    if (options.timestamp_source == TimestampSource::ADAPTER) {
+        // Prefer the adapter clock synchronized to system time, then the raw one
+        if (pcap_set_tstamp_type(handle, PCAP_TSTAMP_ADAPTER) != 0 &&
+            pcap_set_tstamp_type(handle, PCAP_TSTAMP_ADAPTER_UNSYNCED) != 0) {
+            Log::warning("Adapter timestamps not supported on {}, using host timestamps", device_name);
+        }
+    }
+    
+    if (options.buffer_size > 0) {
+        pcap_set_buffer_size(handle, options.buffer_size);
+    }
+    
+    int status = pcap_activate(handle);
+    
+    if (status != 0) {
+        std::string message = pcap_statustostr(status);
+        std::string detail = pcap_geterr(handle);
+        if (!detail.empty()) {
+            message += ": " + detail;
+        }
+        
+        if (status < 0) {
+            error = message;
+            pcap_close(handle);
+            return nullptr;
+        }
+        
+        // Warnings (e.g. promiscuous mode unsupported) leave a usable handle
+        Log::warning("Capture on {} activated with warning: {}", device_name, message);
+    }
+    
+    return handle;
+}
+
+// Nanoseconds per tv_usec unit for an activated handle
+uint64_t timestamp_scale(pcap_t* handle) {
+    return pcap_get_tstamp_precision(handle) == PCAP_TSTAMP_PRECISION_NANO ? 1 : 1000;
+}
+
+uint64_t to_nanoseconds(const struct timeval& ts, uint64_t scale) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_usec) * scale;
+}
+
+void copy_to_packet(const PacketView& view, Packet& packet) {
+    packet.timestamp = view.timestamp;
+    packet.actual_length = view.actual_length;
+    packet.captured_length = view.captured_length;
+    packet.sampling_rate = view.sampling_rate;
+    packet.data.assign(view.data, view.data + view.captured_length);
+}
+
+} // namespace
+
+CaptureOptions capture_options_from_config(const Config& config) {
+    CaptureOptions options;
+    
+    options.promiscuous_mode = config.get<bool>("capture.promiscuous_mode", options.promiscuous_mode);
+    options.capture_filter = config.get<std::string>("capture.default_filter", "");
+    
+    options.slicing = config.get<bool>("capture.slicing", options.slicing);
+    options.slice_payload = config.get<int>("capture.slice_payload", options.slice_payload);
+    
+    std::string slice_rules = config.get<std::string>("capture.slice_rules", "");
+    std::string slice_error;
+    if (!parse_slice_rules(slice_rules, options.slice_rules, slice_error)) {
+        Log::warning("{}, slicing disabled", slice_error);
+        options.slicing = false;
+    }
+    
+    options.dedup = config.get<bool>("capture.dedup", options.dedup);
+    options.dedup_window_us = config.get<int>("capture.dedup_window_us", options.dedup_window_us);
+    options.dedup_table_size = static_cast<size_t>(
+        config.get<int>("capture.dedup_table_size", static_cast<int>(options.dedup_table_size)));
+    
+    options.buffer_size = config.get<int>("capture.buffer_size", options.buffer_size);
+    options.immediate_mode = config.get<bool>("capture.immediate_mode", options.immediate_mode);
+    
+    std::string timestamp_source = config.get<std::string>("capture.timestamp_source", "host");
+    if (timestamp_source == "adapter") {
+        options.timestamp_source = TimestampSource::ADAPTER;
+    } else if (timestamp_source != "host") {
+        Log::warning("Unknown timestamp source '{}', using host", timestamp_source);
+    }
+    options.adaptive_buffer = config.get<bool>("capture.adaptive_buffer", options.adaptive_buffer);
+    options.max_buffer_size = config.get<int>("capture.max_buffer_size", options.max_buffer_size);
+    
+    std::string backend = config.get<std::string>("capture.backend", "pcap");
+    if (backend == "tpacket_v3") {
+        options.backend = CaptureBackend::TPACKET_V3;
+    } else if (backend == "generator") {
+        options.backend = CaptureBackend::GENERATOR;
+    } else if (backend != "pcap") {
+        Log::warning("Unknown capture backend '{}', using pcap", backend);
+    }
+    
+    options.ring_block_size = static_cast<size_t>(
+        config.get<int>("capture.ring_block_size", static_cast<int>(options.ring_block_size)));
+    options.ring_block_count = static_cast<size_t>(
+        config.get<int>("capture.ring_block_count", static_cast<int>(options.ring_block_count)));
+    
+    options.generator_pps = static_cast<uint64_t>(
+        config.get<int>("capture.generator_pps", static_cast<int>(options.generator_pps)));
+    options.generator_packet_count = static_cast<uint64_t>(
+        config.get<int>("capture.generator_packet_count", static_cast<int>(options.generator_packet_count)));
+    options.generator_flows = static_cast<size_t>(
+        config.get<int>("capture.generator_flows", static_cast<int>(options.generator_flows)));
+    options.generator_ipv6_share = config.get<double>("capture.generator_ipv6_share", options.generator_ipv6_share);
+    options.generator_udp_share = config.get<double>("capture.generator_udp_share", options.generator_udp_share);
+    options.generator_min_frame = static_cast<size_t>(
+        config.get<int>("capture.generator_min_frame", static_cast<int>(options.generator_min_frame)));
+    options.generator_max_frame = static_cast<size_t>(
+        config.get<int>("capture.generator_max_frame", static_cast<int>(options.generator_max_frame)));
+    
+    std::string size_mix = config.get<std::string>("capture.generator_size_mix", "imix");
+    if (size_mix == "fixed") {
+        options.generator_size_mix = FrameSizeMix::FIXED;
+    } else if (size_mix == "uniform") {
+        options.generator_size_mix = FrameSizeMix::UNIFORM;
+    } else if (size_mix != "imix") {
+        Log::warning("Unknown generator size mix '{}', using imix", size_mix);
+    }
+    
+    options.event_driven = config.get<bool>("capture.event_driven", options.event_driven);
+    options.use_capture_thread = config.get<bool>("capture.thread", options.use_capture_thread);
+    options.queue_capacity = static_cast<size_t>(
+        config.get<int>("capture.queue_capacity", static_cast<int>(options.queue_capacity)));
+    
+    std::string policy = config.get<std::string>("capture.overflow_policy", "drop_newest");
+    if (policy == "block") {
+        options.overflow_policy = OverflowPolicy::BLOCK;
+    } else if (policy == "drop_oldest") {
+        options.overflow_policy = OverflowPolicy::DROP_OLDEST;
+    } else if (policy != "drop_newest") {
+        Log::warning("Unknown overflow policy '{}', using drop_newest", policy);
+    }
+    
+    std::string shedding = config.get<std::string>("capture.load_shedding", "off");
+    if (shedding == "flow") {
+        options.load_shedding = SheddingMode::FLOW;
+    } else if (shedding == "packet") {
+        options.load_shedding = SheddingMode::PACKET;
+    } else if (shedding != "off") {
+        Log::warning("Unknown load shedding mode '{}', shedding disabled", shedding);
+    }
+    options.shed_high_watermark = config.get<double>("capture.shed_high_watermark", options.shed_high_watermark);
+    options.shed_low_watermark = config.get<double>("capture.shed_low_watermark", options.shed_low_watermark);
+    options.shed_max_rate = static_cast<uint32_t>(
+        config.get<int>("capture.shed_max_rate", static_cast<int>(options.shed_max_rate)));
+    
+    std::string replay = config.get<std::string>("capture.replay_mode", "fast");
+    if (replay == "original") {
+        options.replay_mode = ReplayMode::ORIGINAL_TIMING;
+    } else if (replay == "scaled") {
+        options.replay_mode = ReplayMode::SCALED;
+    } else if (replay != "fast") {
+        Log::warning("Unknown replay mode '{}', replaying as fast as possible", replay);
+    }
+    options.replay_speed = config.get<double>("capture.replay_speed", options.replay_speed);
+    
+    options.fanout_workers = static_cast<size_t>(config.get<int>("capture.fanout_workers", 0));
+    options.cpu_affinity = config.get<std::string>("capture.cpu_affinity", "");
+    
+    std::string fanout_mode = config.get<std::string>("capture.fanout_mode", "hash");
+    if (fanout_mode == "cpu") {
+        options.fanout_mode = FanoutMode::CPU;
+    } else if (fanout_mode == "round_robin") {
+        options.fanout_mode = FanoutMode::ROUND_ROBIN;
+    } else if (fanout_mode != "hash") {
+        Log::warning("Unknown fanout mode '{}', using hash", fanout_mode);
+    }
+    
+    options.reorder_window_us = config.get<int>("capture.reorder_window_us", options.reorder_window_us);
+    
+    return options;
+}
+
+bool compile_capture_filter(const std::string& expression, int linktype, int snapshot_length,
+                            struct bpf_program& program, std::string& error) {
+    // A dead handle lets us compile without touching a live (non thread-safe) one
+    pcap_t* compiler = pcap_open_dead(linktype, snapshot_length);
+    if (compiler == nullptr) {
+        error = "Failed to create filter compiler";
+        return false;
+    }
+    
+    if (pcap_compile(compiler, &program, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == -1) {
+        error = "Invalid capture filter '" + expression + "': " + pcap_geterr(compiler);
+        pcap_close(compiler);
+        return false;
+    }
+    
+    pcap_close(compiler);
+    return true;
+}
+
 PacketCapture::PacketCapture()
     : m_pcap_handle(nullptr),
-      m_capturing(false) {
+      m_timestamp_scale(1000),
+      m_slicing(false),
+      m_dedup_enabled(false),
+      m_capturing(false),
+      m_offline(false),
+      m_replay_started(false),
+      m_replay_first_timestamp(0),
+      m_thread_running(false),
+      m_epoll_fd(-1),
+      m_wakeup_fd(-1),
+      m_consumer_waiting(false),
+      m_filter_pending(false),
+      m_enqueued(0),
+      m_dropped_newest(0),
+      m_dropped_oldest(0),
+      m_producer_waits(0),
+      m_queue_high_water(0),
+      m_packets_received(0),
+      m_bytes_received(0),
+      m_kernel_dropped(0),
+      m_interface_dropped(0),
+      m_kernel_dropped_base(0),
+      m_interface_dropped_base(0),
+      m_stats_packets(0),
+      m_stats_bytes(0) {
 }
 
 PacketCapture::~PacketCapture() {
+    stop_capture();
+    close_handles();
+    
+    if (m_filter_pending) {
+        pcap_freecode(&m_pending_filter);
+    }
+}
+
+std::string PacketCapture::get_error() const {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_error_message;
+}
+
+void PacketCapture::set_error(const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_error_message = message;
+}
+
+void PacketCapture::close_handles() {
     if (m_pcap_handle) {
         pcap_close(m_pcap_handle);
         m_pcap_handle = nullptr;
     }
+    
+    m_ring.reset();
+    m_generator.reset();
+    m_fanout.reset();
+    m_generator_filter.clear();
+    m_offline = false;
+    m_device_name.clear();
 }
 
 bool PacketCapture::initialize_device(const std::string& device_name, 
                                      CaptureOptions options) {
     Log::info("Initializing capture on device: {}", device_name);
     
+    // Release any previously opened device
+    stop_capture();
+    close_handles();
+    
     // Store options
     m_options = options;
     
+    // Nothing is opened, so no capture permission is needed
+    if (options.backend == CaptureBackend::GENERATOR) {
+        return initialize_generator(device_name);
+    }
+    
     // Check permissions
     if (!AuthManager::validate_capture_permissions(device_name)) {
-        m_error_message = "Insufficient permissions for device: " + device_name;
-        Log::error(m_error_message);
+        std::string error = "Insufficient permissions for device: " + device_name;
+        set_error(error);
+        Log::error(error);
         return false;
     }
     
-    // Error buffer for pcap
-    char errbuf[PCAP_ERRBUF_SIZE];
+    if (options.fanout_workers > 0) {
+        return initialize_fanout(device_name);
+    }
+    
+    if (options.backend == CaptureBackend::TPACKET_V3) {
+        m_ring = std::make_unique<TPacketRing>();
+        
+        if (!m_ring->open(device_name, options)) {
+            std::string error = "Failed to open device: " + m_ring->get_error();
+            set_error(error);
+            Log::error(error);
+            m_ring.reset();
+            return false;
+        }
+        
+        m_device_name = device_name;
+        configure_slicer(DLT_EN10MB);
+        configure_shedder(DLT_EN10MB);
+        configure_dedup(DLT_EN10MB);
+        
+        Log::info("Successfully initialized TPACKET_V3 capture on device: {}", device_name);
+        return true;
+    }
     
     // Open device for capturing
-    m_pcap_handle = pcap_open_live(
-        device_name.c_str(),
-        options.snapshot_length,
-        options.promiscuous_mode ? 1 : 0,
-        options.timeout_ms,
-        errbuf
-    );
+    std::string error;
+    m_pcap_handle = open_live_handle(device_name, options, error);
+    
+    if (m_pcap_handle == nullptr) {
+        std::string message = "Failed to open device: " + error;
+        set_error(message);
+        Log::error(message);
+        return false;
+    }
+    
+    m_device_name = device_name;
+    m_timestamp_scale = timestamp_scale(m_pcap_handle);
+    configure_slicer(pcap_datalink(m_pcap_handle));
+    configure_shedder(pcap_datalink(m_pcap_handle));
+    configure_dedup(pcap_datalink(m_pcap_handle));
+    
+    Log::info("Successfully initialized capture on device: {} (buffer {} bytes{})",
+              device_name, options.buffer_size, options.immediate_mode ? ", immediate mode" : "");
+    return true;
+}
+
+bool PacketCapture::initialize_generator(const std::string& name) {
+    m_generator = std::make_unique<TrafficGenerator>();
+    
+    if (!m_generator->configure(m_options)) {
+        std::string error = m_generator->get_error();
+        set_error(error);
+        Log::error(error);
+        m_generator.reset();
+        return false;
+    }
+    
+    m_device_name = name.empty() ? "generator" : name;
+    configure_slicer(DLT_EN10MB);
+    configure_shedder(DLT_EN10MB);
+    configure_dedup(DLT_EN10MB);
+    
+    Log::info("Initialized traffic generator '{}' ({} flows, {} pps)", m_device_name,
+              m_generator->get_flow_count(), m_options.generator_pps);
+    return true;
+}
+
+bool PacketCapture::initialize_fanout(const std::string& device_name) {
+    // The workers are the capture threads and have no common descriptor to wait on
+    if (m_options.use_capture_thread || m_options.event_driven) {
+        Log::warning("Fanout capture on {} reads on its workers, capture thread and event-driven mode unused",
+                     device_name);
+        m_options.use_capture_thread = false;
+        m_options.event_driven = false;
+    }
+    
+    if (m_options.dedup) {
+        Log::warning("Duplicate elimination is not available with fanout capture, disabled");
+    }
+    
+    m_fanout = std::make_unique<FanoutCapture>();
+    
+    if (!m_fanout->initialize(device_name, m_options)) {
+        set_error("Failed to open device: " + m_fanout->get_error());
+        m_fanout.reset();
+        return false;
+    }
+    
+    m_device_name = device_name;
+    configure_slicer(DLT_EN10MB);
+    configure_shedder(DLT_EN10MB);
+    m_dedup_enabled = false;
+    return true;
+}
+
+bool PacketCapture::initialize_file(const std::string& file_path, CaptureOptions options) {
+    Log::info("Initializing capture from file: {}", file_path);
+    
+    // Release any previously opened source
+    stop_capture();
+    close_handles();
+    
+    m_options = options;
+    
+    // A file is always readable and epoll refuses regular files, so reads
+    // on the caller's thread just poll; the capture thread has its own wakeup
+    if (m_options.event_driven && !m_options.use_capture_thread) {
+        Log::warning("Event-driven mode needs the capture thread for file replay, polling instead");
+        m_options.event_driven = false;
+    }
+    
+    if (options.replay_mode == ReplayMode::SCALED && options.replay_speed <= 0.0) {
+        std::string error = "Replay speed must be positive";
+        set_error(error);
+        Log::error(error);
+        return false;
+    }
+    
+    char errbuf[PCAP_ERRBUF_SIZE];
+    
+    // Handles both pcap and pcapng; microsecond files are scaled up
+    m_pcap_handle = pcap_open_offline_with_tstamp_precision(
+        file_path.c_str(), PCAP_TSTAMP_PRECISION_NANO, errbuf);
     
     if (m_pcap_handle == nullptr) {
-        m_error_message = "Failed to open device: " + std::string(errbuf);
-        Log::error(m_error_message);
+        std::string error = "Failed to open capture file: " + std::string(errbuf);
+        set_error(error);
+        Log::error(error);
         return false;
     }
     
-    Log::info("Successfully initialized capture on device: {}", device_name);
+    m_offline = true;
+    m_replay_started = false;
+    m_device_name = file_path;
+    m_timestamp_scale = timestamp_scale(m_pcap_handle);
+    configure_slicer(pcap_datalink(m_pcap_handle));
+    configure_shedder(pcap_datalink(m_pcap_handle));
+    configure_dedup(pcap_datalink(m_pcap_handle));
+    
+    Log::info("Successfully opened capture file: {}", file_path);
     return true;
 }
 
+int PacketCapture::get_datalink() const {
+    if (m_ring || m_generator || m_fanout) {
+        return DLT_EN10MB;
+    }
+    
+    return m_pcap_handle ? pcap_datalink(m_pcap_handle) : -1;
+}
+
+void PacketCapture::configure_slicer(int linktype) {
+    m_slicing = m_options.slicing && linktype == DLT_EN10MB;
+    
+    if (m_options.slicing && !m_slicing) {
+        Log::warning("Slicing needs an Ethernet link (link type {}), keeping whole frames", linktype);
+    }
+    
+    m_slicer.set_rules(m_options.slice_rules);
+    m_slicer.set_default_payload(m_options.slice_payload);
+}
+
+void PacketCapture::configure_shedder(int linktype) {
+    SheddingMode mode = m_options.load_shedding;
+    
+    if (mode != SheddingMode::OFF && (m_offline || !m_options.use_capture_thread)) {
+        // Files can simply be read more slowly; without a queue there is no load to measure
+        Log::warning("Load shedding needs a live capture on a capture thread, disabled");
+        mode = SheddingMode::OFF;
+    } else if (mode == SheddingMode::FLOW && linktype != DLT_EN10MB) {
+        Log::warning("Flow sampling needs an Ethernet link (link type {}), sampling packets", linktype);
+        mode = SheddingMode::PACKET;
+    }
+    
+    m_shedder.configure(mode, m_options.shed_high_watermark, m_options.shed_low_watermark,
+                        m_options.shed_max_rate);
+}
+
+void PacketCapture::configure_dedup(int linktype) {
+    m_dedup_enabled = m_options.dedup;
+    
+    if (m_dedup_enabled) {
+        // Header-aware fingerprints need Ethernet framing; other links hash whole frames
+        m_dedup.configure(static_cast<uint32_t>(std::max(m_options.dedup_window_us, 0)),
+                          m_options.dedup_table_size, linktype == DLT_EN10MB);
+    }
+}
+
 std::vector<std::string> PacketCapture::get_available_devices() {
     std::vector<std::string> devices;
     pcap_if_t *alldevs;
@@ -75,38 +544,665 @@ std::vector<std::string> PacketCapture::get_available_devices() {
 }
 
 bool PacketCapture::start_capture() {
-    if (!m_pcap_handle) {
-        m_error_message = "Capture device not initialized";
-        Log::error(m_error_message);
+    if (!m_pcap_handle && !m_ring && !m_generator && !m_fanout) {
+        std::string error = "Capture device not initialized";
+        set_error(error);
+        Log::error(error);
         return false;
     }
     
     if (m_capturing) {
-        m_error_message = "Capture already in progress";
-        Log::warning(m_error_message);
+        std::string error = "Capture already in progress";
+        set_error(error);
+        Log::warning(error);
+        return false;
+    }
+    
+    // Install the kernel filter before the first frame is read
+    if (!m_options.capture_filter.empty() && !set_capture_filter(m_options.capture_filter)) {
+        return false;
+    }
+    
+    m_packets_received = 0;
+    m_bytes_received = 0;
+    m_kernel_dropped = 0;
+    m_interface_dropped = 0;
+    m_kernel_dropped_base = 0;
+    m_interface_dropped_base = 0;
+    m_stats_time = std::chrono::steady_clock::now();
+    m_stats_packets = 0;
+    m_stats_bytes = 0;
+    
+    if (m_generator) {
+        m_generator->restart();
+    }
+    
+    if (m_dedup_enabled) {
+        m_dedup.reset();
+    }
+    
+    if (m_fanout && !m_fanout->start()) {
+        set_error(m_fanout->get_error());
         return false;
     }
     
-    // Set filter if needed (example for TCP packets only)
-    // struct bpf_program fp;
-    // pcap_compile(m_pcap_handle, &fp, "tcp", 0, PCAP_NETMASK_UNKNOWN);
-    // pcap_setfilter(m_pcap_handle, &fp);
+    if (m_options.event_driven && !open_event_fds()) {
+        return false;
+    }
     
     m_capturing = true;
+    
+    // Leftovers of a previous threaded capture must not shadow the device
+    m_queue.reset();
+    
+    if (m_start_callback) {
+        m_start_callback();
+    }
+    
+    if (m_options.use_capture_thread) {
+        m_queue = std::make_unique<PacketRing<Packet>>(m_options.queue_capacity);
+        m_enqueued = 0;
+        m_dropped_newest = 0;
+        m_dropped_oldest = 0;
+        m_producer_waits = 0;
+        m_queue_high_water = 0;
+        m_shedder.reset();
+        
+        m_thread_running = true;
+        m_capture_thread = std::thread(&PacketCapture::capture_thread_main, this);
+        
+        Log::info("Packet capture started on capture thread (queue capacity {})",
+                  m_queue->capacity());
+        return true;
+    }
+    
     Log::info("Packet capture started");
     
     return true;
 }
 
 void PacketCapture::stop_capture() {
+    bool stopped = false;
+    
+    if (m_capture_thread.joinable()) {
+        m_thread_running = false;
+        
+        // Wake the thread if it is blocked inside libpcap
+        {
+            std::lock_guard<std::mutex> lock(m_handle_mutex);
+            if (m_pcap_handle) {
+                pcap_breakloop(m_pcap_handle);
+            }
+        }
+        
+        m_capture_thread.join();
+        stopped = true;
+        
+        // Packets still queued stay readable until the next start; an empty
+        // queue goes now, so a restart without the capture thread reads the
+        // device again
+        if (m_queue->empty()) {
+            m_queue.reset();
+        }
+    }
+    
+    if (m_fanout) {
+        m_fanout->stop();
+    }
+    
     if (m_capturing) {
         m_capturing = false;
+        stopped = true;
         Log::info("Packet capture stopped");
     }
+    
+    if (stopped && m_stop_callback) {
+        m_stop_callback();
+    }
+    
+    close_event_fds();
+}
+
+bool PacketCapture::open_event_fds() {
+#ifdef __linux__
+    close_event_fds();
+    
+    int source_fd = -1;
+    
+    if (m_options.use_capture_thread) {
+        // The consumer waits on the queue, which the capture thread signals
+        m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        source_fd = m_wakeup_fd;
+        m_consumer_waiting = true;
+    } else if (m_ring) {
+        source_fd = m_ring->get_fd();
+    } else if (m_pcap_handle) {
+        source_fd = pcap_get_selectable_fd(m_pcap_handle);
+        
+        // Reads after a wakeup must not block once the buffer is drained
+        char errbuf[PCAP_ERRBUF_SIZE];
+        if (!m_offline && pcap_setnonblock(m_pcap_handle, 1, errbuf) == -1) {
+            Log::warning("Failed to make capture handle non-blocking: {}", errbuf);
+        }
+    }
+    
+    if (source_fd < 0) {
+        set_error("Capture source has no selectable descriptor");
+        Log::error("Capture source has no selectable descriptor");
+        close_event_fds();
+        return false;
+    }
+    
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = source_fd;
+    
+    if (m_epoll_fd < 0 || epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, source_fd, &event) < 0) {
+        std::string error = "Failed to set up capture wakeups: " + std::string(std::strerror(errno));
+        set_error(error);
+        Log::error(error);
+        close_event_fds();
+        return false;
+    }
+    
+    return true;
+#else
+    // get_selectable_fd() stays -1, so consumers keep polling on a timer
+    Log::warning("Event-driven capture is only available on Linux, polling instead");
+    m_options.event_driven = false;
+    return true;
+#endif
+}
+
+void PacketCapture::close_event_fds() {
+#ifdef __linux__
+    if (m_epoll_fd >= 0) {
+        ::close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+    
+    if (m_wakeup_fd >= 0) {
+        ::close(m_wakeup_fd);
+        m_wakeup_fd = -1;
+    }
+#endif
+}
+
+void PacketCapture::signal_wakeup() {
+#ifdef __linux__
+    uint64_t one = 1;
+    if (::write(m_wakeup_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        Log::warning("Failed to signal capture consumer: {}", std::strerror(errno));
+    }
+#endif
+}
+
+void PacketCapture::rearm_wakeup() {
+#ifdef __linux__
+    // Consume the pending signal, then announce that we are about to sleep
+    uint64_t value;
+    if (::read(m_wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        Log::warning("Failed to reset capture wakeup: {}", std::strerror(errno));
+    }
+    
+    m_consumer_waiting.store(true);
+    
+    // A batch queued after our last pop may have missed the flag
+    if (!m_queue->empty()) {
+        signal_wakeup();
+    }
+#endif
+}
+
+bool PacketCapture::wait_for_packets(int timeout_ms) {
+#ifdef __linux__
+    if (m_epoll_fd < 0) {
+        return false;
+    }
+    
+    struct epoll_event event;
+    int result;
+    
+    do {
+        result = epoll_wait(m_epoll_fd, &event, 1, timeout_ms);
+    } while (result < 0 && errno == EINTR);
+    
+    return result > 0;
+#else
+    return false;
+#endif
+}
+
+size_t PacketCapture::notify_packets(size_t count) {
+    if (count > 0 && m_packet_callback) {
+        m_packet_callback();
+    }
+    
+    return count;
+}
+
+bool PacketCapture::set_capture_filter(const std::string& filter) {
+    if (!m_pcap_handle && !m_ring && !m_generator && !m_fanout) {
+        set_error("Capture device not initialized");
+        Log::error("Capture device not initialized");
+        return false;
+    }
+    
+    int linktype = m_pcap_handle ? pcap_datalink(m_pcap_handle) : DLT_EN10MB;
+    struct bpf_program program;
+    std::string error;
+    
+    if (!compile_capture_filter(filter, linktype, m_options.snapshot_length, program, error)) {
+        set_error(error);
+        Log::error(error);
+        return false;
+    }
+    
+    // libpcap handles are not thread-safe, so a running capture thread
+    // picks the program up between two batches
+    if ((m_pcap_handle || m_generator) && m_capture_thread.joinable()) {
+        std::lock_guard<std::mutex> lock(m_filter_mutex);
+        
+        if (m_filter_pending) {
+            pcap_freecode(&m_pending_filter);
+        }
+        
+        m_pending_filter = program;
+        m_filter_pending = true;
+        m_options.capture_filter = filter;
+        
+        Log::info("Capture filter queued: '{}'", filter);
+        return true;
+    }
+    
+    bool installed = install_filter(program);
+    pcap_freecode(&program);
+    
+    if (installed) {
+        m_options.capture_filter = filter;
+        Log::info("Capture filter installed: '{}'", filter);
+    }
+    
+    return installed;
+}
+
+bool PacketCapture::install_filter(struct bpf_program& program) {
+    if (m_generator) {
+        // Evaluated in user space, so keep a private copy of the program
+        m_generator_filter.assign(program.bf_insns, program.bf_insns + program.bf_len);
+        
+        if (m_generator_filter.empty()) {
+            m_generator->set_filter(nullptr);
+            return true;
+        }
+        
+        m_generator->set_filter([this](const PacketView& view) {
+            struct bpf_program filter;
+            filter.bf_len = static_cast<u_int>(m_generator_filter.size());
+            filter.bf_insns = m_generator_filter.data();
+            
+            struct pcap_pkthdr header;
+            header.ts.tv_sec = static_cast<decltype(header.ts.tv_sec)>(view.timestamp / 1000000000ULL);
+            header.ts.tv_usec = static_cast<decltype(header.ts.tv_usec)>(view.timestamp % 1000000000ULL / 1000);
+            header.caplen = static_cast<bpf_u_int32>(view.captured_length);
+            header.len = static_cast<bpf_u_int32>(view.actual_length);
+            
+            return pcap_offline_filter(&filter, &header, view.data) != 0;
+        });
+        return true;
+    }
+    
+    if (m_ring) {
+        if (!m_ring->attach_filter(program)) {
+            set_error(m_ring->get_error());
+            Log::error(m_ring->get_error());
+            return false;
+        }
+        return true;
+    }
+    
+    if (m_fanout) {
+        if (!m_fanout->set_capture_filter(program)) {
+            set_error(m_fanout->get_error());
+            return false;
+        }
+        return true;
+    }
+    
+    if (pcap_setfilter(m_pcap_handle, &program) == -1) {
+        std::string error = "Failed to install capture filter: " + std::string(pcap_geterr(m_pcap_handle));
+        set_error(error);
+        Log::error(error);
+        return false;
+    }
+    
+    return true;
+}
+
+void PacketCapture::apply_pending_filter() {
+    std::lock_guard<std::mutex> lock(m_filter_mutex);
+    
+    if (m_filter_pending) {
+        install_filter(m_pending_filter);
+        pcap_freecode(&m_pending_filter);
+        m_filter_pending = false;
+    }
+}
+
+CaptureQueueCounters PacketCapture::get_queue_counters() const {
+    CaptureQueueCounters counters;
+    counters.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    counters.dropped_newest = m_dropped_newest.load(std::memory_order_relaxed);
+    counters.dropped_oldest = m_dropped_oldest.load(std::memory_order_relaxed);
+    counters.producer_waits = m_producer_waits.load(std::memory_order_relaxed);
+    counters.depth = m_queue ? m_queue->size() : 0;
+    counters.high_water = m_queue_high_water.load(std::memory_order_relaxed);
+    return counters;
+}
+
+CaptureStats PacketCapture::get_stats() {
+    // Without a capture thread the caller is the reading thread
+    if (!m_capture_thread.joinable()) {
+        sample_kernel_stats();
+    }
+    
+    CaptureStats stats;
+    stats.packets_received = m_packets_received.load(std::memory_order_relaxed);
+    stats.bytes_received = m_bytes_received.load(std::memory_order_relaxed);
+    stats.kernel_dropped = m_kernel_dropped.load(std::memory_order_relaxed);
+    stats.interface_dropped = m_interface_dropped.load(std::memory_order_relaxed);
+    stats.queue_dropped = m_dropped_newest.load(std::memory_order_relaxed) +
+                          m_dropped_oldest.load(std::memory_order_relaxed);
+    stats.queue_depth = m_queue ? m_queue->size() : 0;
+    stats.queue_high_water = m_queue_high_water.load(std::memory_order_relaxed);
+    stats.shed_packets = m_shedder.get_shed_packets();
+    stats.sampling_rate = m_shedder.get_rate();
+    stats.duplicates_dropped = m_dedup.get_duplicates();
+    
+    // The fanout workers keep their own counters
+    if (m_fanout) {
+        CaptureStats workers = m_fanout->get_stats();
+        stats.packets_received = workers.packets_received;
+        stats.bytes_received = workers.bytes_received;
+        stats.kernel_dropped = workers.kernel_dropped;
+        stats.queue_dropped = workers.queue_dropped;
+        stats.queue_depth = workers.queue_depth;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - m_stats_time).count();
+    
+    if (elapsed > 0.0) {
+        stats.packets_per_second = static_cast<double>(stats.packets_received - m_stats_packets) / elapsed;
+        stats.bytes_per_second = static_cast<double>(stats.bytes_received - m_stats_bytes) / elapsed;
+    }
+    
+    m_stats_time = now;
+    m_stats_packets = stats.packets_received;
+    m_stats_bytes = stats.bytes_received;
+    
+    return stats;
+}
+
+void PacketCapture::account_packets(size_t packets, uint64_t bytes) {
+    if (packets == 0) {
+        return;
+    }
+    
+    // Single writer: plain load/store avoids a locked read-modify-write
+    m_packets_received.store(m_packets_received.load(std::memory_order_relaxed) + packets,
+                             std::memory_order_relaxed);
+    m_bytes_received.store(m_bytes_received.load(std::memory_order_relaxed) + bytes,
+                           std::memory_order_relaxed);
+}
+
+void PacketCapture::sample_kernel_stats() {
+    // Capture files have no kernel counters
+    if (m_offline) {
+        return;
+    }
+    
+    if (m_ring) {
+        uint64_t dropped = 0;
+        if (m_ring->read_statistics(dropped)) {
+            m_kernel_dropped.store(dropped, std::memory_order_relaxed);
+        }
+        return;
+    }
+    
+    if (!m_pcap_handle) {
+        return;
+    }
+    
+    struct pcap_stat ps;
+    if (pcap_stats(m_pcap_handle, &ps) != 0) {
+        return;
+    }
+    
+    uint64_t previous = m_kernel_dropped.load(std::memory_order_relaxed);
+    uint64_t dropped = m_kernel_dropped_base + ps.ps_drop;
+    
+    m_kernel_dropped.store(dropped, std::memory_order_relaxed);
+    m_interface_dropped.store(m_interface_dropped_base + ps.ps_ifdrop, std::memory_order_relaxed);
+    
+    if (dropped > previous && m_options.adaptive_buffer && m_capturing &&
+        m_options.buffer_size < m_options.max_buffer_size) {
+        grow_kernel_buffer();
+    }
+}
+
+void PacketCapture::grow_kernel_buffer() {
+    CaptureOptions options = m_options;
+    int current = options.buffer_size > 0 ? options.buffer_size : 2 * 1024 * 1024;
+    options.buffer_size = current >= options.max_buffer_size / 2 ? options.max_buffer_size
+                                                                 : current * 2;
+    
+    // The buffer size is fixed at activation, so a bigger one means a new
+    // handle. Frames still queued in the old buffer are lost.
+    std::string error;
+    pcap_t* handle = open_live_handle(m_device_name, options, error);
+    
+    if (handle == nullptr) {
+        Log::warning("Could not grow capture buffer on {}: {}", m_device_name, error);
+        return;
+    }
+    
+    if (!m_options.capture_filter.empty()) {
+        struct bpf_program program;
+        bool installed = false;
+        
+        if (compile_capture_filter(m_options.capture_filter, pcap_datalink(handle),
+                                   m_options.snapshot_length, program, error)) {
+            installed = pcap_setfilter(handle, &program) == 0;
+            pcap_freecode(&program);
+        }
+        
+        if (!installed) {
+            Log::warning("Could not grow capture buffer on {}: filter not reinstalled", m_device_name);
+            pcap_close(handle);
+            return;
+        }
+    }
+    
+#ifdef __linux__
+    // Without a capture thread an event-driven consumer sleeps on the handle's
+    // own descriptor, so the new one must be watched and read without blocking
+    int old_fd = -1;
+    if (m_epoll_fd >= 0 && !m_capture_thread.joinable()) {
+        char errbuf[PCAP_ERRBUF_SIZE];
+        int fd = pcap_get_selectable_fd(handle);
+        
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        
+        if (fd < 0 || pcap_setnonblock(handle, 1, errbuf) == -1 ||
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            Log::warning("Could not grow capture buffer on {}: new handle cannot wake the consumer",
+                         m_device_name);
+            pcap_close(handle);
+            return;
+        }
+        
+        old_fd = pcap_get_selectable_fd(m_pcap_handle);
+    }
+#endif
+    
+    m_kernel_dropped_base = m_kernel_dropped.load(std::memory_order_relaxed);
+    m_interface_dropped_base = m_interface_dropped.load(std::memory_order_relaxed);
+    
+    pcap_t* old_handle;
+    {
+        std::lock_guard<std::mutex> lock(m_handle_mutex);
+        old_handle = m_pcap_handle;
+        m_pcap_handle = handle;
+    }
+    m_timestamp_scale = timestamp_scale(handle);
+    
+#ifdef __linux__
+    if (old_fd >= 0) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, old_fd, nullptr);
+    }
+#endif
+    pcap_close(old_handle);
+    
+    m_options.buffer_size = options.buffer_size;
+    
+    Log::warning("Kernel drops on {}: capture buffer grown to {} bytes",
+                 m_device_name, options.buffer_size);
+}
+
+void PacketCapture::capture_thread_main() {
+    std::vector<int> cpus;
+    std::string error;
+    
+    if (!resolve_cpu_set(m_options.cpu_affinity, m_device_name, cpus, error) ||
+        !pin_current_thread(cpus, error)) {
+        Log::warning("Capture thread for {} left unpinned: {}", m_device_name, error);
+    } else if (!cpus.empty()) {
+        Log::info("Capture thread for {} pinned to CPUs {}", m_device_name, m_options.cpu_affinity);
+    }
+    
+    auto enqueue = [this](const PacketView& view) { enqueue_packet(view); };
+    auto next_sample = std::chrono::steady_clock::now();
+    
+    while (m_thread_running.load(std::memory_order_acquire)) {
+        if (m_filter_pending.load(std::memory_order_acquire)) {
+            apply_pending_filter();
+        }
+        
+        size_t count = read_from_device(enqueue, CAPTURE_THREAD_BATCH);
+        
+        // Wake an event-driven consumer once per batch, only if it sleeps
+        if (count > 0 && m_wakeup_fd >= 0) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_consumer_waiting.load(std::memory_order_relaxed) && m_consumer_waiting.exchange(false)) {
+                signal_wakeup();
+            }
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        m_shedder.update(m_queue->size(), m_queue->capacity(), now);
+        
+        if (now >= next_sample) {
+            sample_kernel_stats();
+            next_sample = now + KERNEL_STATS_INTERVAL;
+        }
+        
+        // End of input (e.g. a capture file) also ends the thread
+        if (!m_capturing) {
+            break;
+        }
+    }
+    
+    // Let a waiting consumer notice that the capture is over
+    if (m_wakeup_fd >= 0) {
+        signal_wakeup();
+    }
+}
+
+void PacketCapture::enqueue_packet(const PacketView& view) {
+    // Sampled out before it costs a copy
+    uint32_t rate = m_shedder.admit(view.data, view.captured_length);
+    if (rate == 0) {
+        return;
+    }
+    
+    auto fill = [&view, rate](Packet& slot) {
+        copy_to_packet(view, slot);
+        slot.sampling_rate = rate;
+    };
+    
+    if (!m_queue->try_push(fill)) {
+        switch (m_options.overflow_policy) {
+            case OverflowPolicy::DROP_NEWEST:
+                m_dropped_newest.fetch_add(1, std::memory_order_relaxed);
+                return;
+                
+            case OverflowPolicy::DROP_OLDEST:
+                // The consumer may be mid-pop on the slot we need; retry until it lands
+                while (!m_queue->try_push(fill)) {
+                    if (m_queue->try_discard()) {
+                        m_dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+                break;
+                
+            case OverflowPolicy::BLOCK:
+                m_producer_waits.fetch_add(1, std::memory_order_relaxed);
+                while (!m_queue->try_push(fill)) {
+                    if (!m_thread_running.load(std::memory_order_relaxed)) {
+                        m_dropped_newest.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+                break;
+        }
+    }
+    
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    
+    size_t depth = m_queue->size();
+    if (depth > m_queue_high_water.load(std::memory_order_relaxed)) {
+        m_queue_high_water.store(depth, std::memory_order_relaxed);
+    }
 }
 
 bool PacketCapture::get_next_packet(Packet& packet) {
-    if (!m_capturing || !m_pcap_handle) {
+    if (m_queue) {
+        // Swapping hands the caller's old buffer back to the queue for reuse
+        if (m_queue->try_pop(packet)) {
+            notify_packets(1);
+            return true;
+        }
+        
+        if (m_wakeup_fd >= 0) {
+            rearm_wakeup();
+        }
+        return false;
+    }
+    
+    if (m_fanout) {
+        return notify_packets(pop_fanout_packet(packet) ? 1 : 0) == 1;
+    }
+    
+    if (!m_capturing) {
+        return false;
+    }
+    
+    if (m_ring || m_generator) {
+        // Compatibility path: copy the frame out of the ring
+        auto copy_packet = [&packet](const PacketView& view) { copy_to_packet(view, packet); };
+        
+        return notify_packets(read_from_device(copy_packet, 1)) == 1;
+    }
+    
+    if (!m_pcap_handle) {
         return false;
     }
     
@@ -115,20 +1211,34 @@ bool PacketCapture::get_next_packet(Packet& packet) {
     
     int result = pcap_next_ex(m_pcap_handle, &header, &packet_data);
     
+    // Duplicates are counted as received but never handed out
+    while (result == 1 && m_dedup_enabled &&
+           m_dedup.is_duplicate(packet_data, header->caplen, header->len,
+                                to_nanoseconds(header->ts, m_timestamp_scale))) {
+        account_packets(1, header->len);
+        result = pcap_next_ex(m_pcap_handle, &header, &packet_data);
+    }
+    
     if (result == 1) {
         // Successfully got a packet
-        packet.timestamp = header->ts.tv_sec * 1000000 + header->ts.tv_usec;
+        packet.timestamp = to_nanoseconds(header->ts, m_timestamp_scale);
+        pace_replay(packet.timestamp);
         packet.actual_length = header->len;
-        packet.captured_length = header->caplen;
-        packet.data.assign(packet_data, packet_data + header->caplen);
+        packet.captured_length = m_slicing ? m_slicer.slice_length(packet_data, header->caplen)
+                                           : header->caplen;
+        packet.sampling_rate = 1;
+        packet.data.assign(packet_data, packet_data + packet.captured_length);
+        account_packets(1, header->len);
+        notify_packets(1);
         return true;
     } else if (result == 0) {
         // Timeout elapsed
         return false;
     } else if (result == -1) {
         // Error occurred
-        m_error_message = pcap_geterr(m_pcap_handle);
-        Log::error("Error reading packet: {}", m_error_message);
+        std::string error = pcap_geterr(m_pcap_handle);
+        set_error(error);
+        Log::error("Error reading packet: {}", error);
         return false;
     } else if (result == -2) {
         // End of capture file reached (when reading from file)
@@ -139,9 +1249,214 @@ bool PacketCapture::get_next_packet(Packet& packet) {
     return false;
 }
 
+size_t PacketCapture::get_next_packets(std::vector<Packet>& packets, size_t max_packets) {
+    if (packets.size() < max_packets) {
+        packets.resize(max_packets);
+    }
+    
+    size_t count = 0;
+    
+    if (m_queue) {
+        while (count < max_packets && m_queue->try_pop(packets[count])) {
+            ++count;
+        }
+        
+        if (count < max_packets && m_wakeup_fd >= 0) {
+            rearm_wakeup();
+        }
+        return notify_packets(count);
+    }
+    
+    if (m_fanout) {
+        while (count < max_packets && pop_fanout_packet(packets[count])) {
+            ++count;
+        }
+        return notify_packets(count);
+    }
+    
+    auto copy_packet = [&packets, &count](const PacketView& view) {
+        copy_to_packet(view, packets[count++]);
+    };
+    
+    return notify_packets(read_from_device(copy_packet, max_packets));
+}
+
+size_t PacketCapture::dispatch_packets(const PacketVisitor& visitor, size_t max_packets) {
+    if (m_queue || m_fanout) {
+        size_t count = 0;
+        
+        while (count < max_packets &&
+               (m_queue ? m_queue->try_pop(m_consumer_packet) : pop_fanout_packet(m_consumer_packet))) {
+            PacketView view;
+            view.timestamp = m_consumer_packet.timestamp;
+            view.data = m_consumer_packet.data.data();
+            view.actual_length = m_consumer_packet.actual_length;
+            view.captured_length = m_consumer_packet.captured_length;
+            view.sampling_rate = m_consumer_packet.sampling_rate;
+            
+            visitor(view);
+            ++count;
+        }
+        
+        if (count < max_packets && m_wakeup_fd >= 0) {
+            rearm_wakeup();
+        }
+        return notify_packets(count);
+    }
+    
+    return notify_packets(read_from_device(visitor, max_packets));
+}
+
+bool PacketCapture::pop_fanout_packet(Packet& packet) {
+    if (m_fanout->get_next_packet(packet)) {
+        return true;
+    }
+    
+    if (m_capturing && !m_fanout->is_running()) {
+        set_error(m_fanout->get_error());
+        m_capturing = false;
+        Log::error("Fanout capture on {} ended: {}", m_device_name, get_error());
+    }
+    return false;
+}
+
+size_t PacketCapture::read_from_device(const PacketVisitor& visitor, size_t max_packets) {
+    if (!m_capturing || max_packets == 0) {
+        return 0;
+    }
+    
+    if (m_ring || m_generator) {
+        uint64_t bytes = 0;
+        size_t duplicates = 0;
+        
+        // An event-driven consumer only reads after a wakeup, never wait
+        int timeout_ms = m_options.event_driven && !m_capture_thread.joinable() ? 0 : m_options.timeout_ms;
+        
+        PacketVisitor filter;
+        if (m_slicing || m_dedup_enabled) {
+            filter = [this, &visitor, &duplicates](const PacketView& view) {
+                if (m_dedup_enabled && m_dedup.is_duplicate(view.data, view.captured_length,
+                                                            view.actual_length, view.timestamp)) {
+                    ++duplicates;
+                    return;
+                }
+                
+                PacketView sliced = view;
+                if (m_slicing) {
+                    sliced.captured_length = m_slicer.slice_length(view.data, view.captured_length);
+                }
+                visitor(sliced);
+            };
+        }
+        
+        const PacketVisitor& target = filter ? filter : visitor;
+        int result = m_ring ? m_ring->dispatch(target, max_packets, timeout_ms, &bytes)
+                            : m_generator->dispatch(target, max_packets, timeout_ms, &bytes);
+        
+        if (result < 0) {
+            std::string error = m_ring ? m_ring->get_error() : m_generator->get_error();
+            set_error(error);
+            Log::error("Error reading packet: {}", error);
+            return 0;
+        }
+        
+        account_packets(static_cast<size_t>(result), bytes);
+        
+        // A generator with a packet count ends like a capture file
+        if (m_generator && m_generator->finished()) {
+            m_capturing = false;
+            Log::info("Traffic generator finished after {} packets", m_generator->get_generated());
+        }
+        
+        return static_cast<size_t>(result) - duplicates;
+    }
+    
+    if (!m_pcap_handle) {
+        return 0;
+    }
+    
+    DispatchContext context;
+    context.capture = this;
+    context.visitor = &visitor;
+    context.count = 0;
+    context.duplicates = 0;
+    context.bytes = 0;
+    
+    // One call drains up to max_packets frames from the capture buffer
+    int result = pcap_dispatch(m_pcap_handle, static_cast<int>(max_packets),
+                               &PacketCapture::packet_handler,
+                               reinterpret_cast<u_char*>(&context));
+    
+    if (result == -1) {
+        std::string error = pcap_geterr(m_pcap_handle);
+        set_error(error);
+        Log::error("Error reading packet: {}", error);
+    } else if (result == 0 && m_offline) {
+        // End of capture file
+        m_capturing = false;
+        Log::info("Reached end of capture file");
+    }
+    
+    account_packets(context.count + context.duplicates, context.bytes);
+    return context.count;
+}
+
+void PacketCapture::pace_replay(uint64_t timestamp) {
+    if (!m_offline || m_options.replay_mode == ReplayMode::AS_FAST_AS_POSSIBLE) {
+        return;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    
+    if (!m_replay_started) {
+        m_replay_started = true;
+        m_replay_first_timestamp = timestamp;
+        m_replay_start = now;
+        return;
+    }
+    
+    double speed = m_options.replay_mode == ReplayMode::SCALED ? m_options.replay_speed : 1.0;
+    uint64_t offset = timestamp > m_replay_first_timestamp ? timestamp - m_replay_first_timestamp : 0;
+    auto due = m_replay_start + std::chrono::nanoseconds(
+        static_cast<uint64_t>(static_cast<double>(offset) / speed));
+    
+    // Sleep in slices so a stop request is not held up by a long gap
+    while (now < due && m_capturing) {
+        if (m_capture_thread.joinable() && !m_thread_running.load(std::memory_order_relaxed)) {
+            break;
+        }
+        
+        std::this_thread::sleep_until(std::min(due, now + REPLAY_SLEEP_SLICE));
+        now = std::chrono::steady_clock::now();
+    }
+}
+
 void PacketCapture::packet_handler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet) {
-    // This is a static callback function for pcap_loop
-    // Implementation if needed
+    // Static callback for pcap_dispatch; forwards each frame to the visitor
+    auto* context = reinterpret_cast<DispatchContext*>(user);
+    PacketCapture* capture = context->capture;
+    
+    PacketView view;
+    view.timestamp = to_nanoseconds(pkthdr->ts, capture->m_timestamp_scale);
+    context->bytes += pkthdr->len;
+    
+    if (capture->m_dedup_enabled &&
+        capture->m_dedup.is_duplicate(packet, pkthdr->caplen, pkthdr->len, view.timestamp)) {
+        ++context->duplicates;
+        return;
+    }
+    
+    capture->pace_replay(view.timestamp);
+    view.data = packet;
+    view.actual_length = pkthdr->len;
+    view.captured_length = pkthdr->caplen;
+    
+    if (capture->m_slicing) {
+        view.captured_length = capture->m_slicer.slice_length(packet, pkthdr->caplen);
+    }
+    
+    (*context->visitor)(view);
+    ++context->count;
 }
 
 } // namespace wireshark_mcp
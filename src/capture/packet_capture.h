@@ -4,9 +4,66 @@
 #include <vector>
 #include <pcap.h>
 #include <memory>
+#include <functional>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "packet_ring.h"
+#include "packet_slicer.h"
+#include "load_shedder.h"
+#include "frame_deduplicator.h"
+#include "../common/packet_buffer.h"
 
 namespace wireshark_mcp {
 
+class Config;
+class TPacketRing;
+class TrafficGenerator;
+class FanoutCapture;
+
+// Receive backend used for live capture
+enum class CaptureBackend {
+    PCAP,           // libpcap, portable, copies each frame
+    TPACKET_V3,     // Linux AF_PACKET block ring, frames delivered in place
+    GENERATOR       // Synthetic traffic, no interface needed (load testing)
+};
+
+// What the capture thread does when the consumer queue is full
+enum class OverflowPolicy {
+    BLOCK,          // Wait for the consumer (back-pressure into the kernel buffer)
+    DROP_NEWEST,    // Discard the packet being enqueued
+    DROP_OLDEST     // Evict the oldest queued packet to make room
+};
+
+// How PACKET_FANOUT spreads frames across the sockets of a group
+enum class FanoutMode {
+    HASH,           // Kernel flow hash, both directions of a flow share a socket
+    CPU,            // Socket chosen by the CPU that received the frame (follows RSS)
+    ROUND_ROBIN     // Even load balancing, no flow affinity
+};
+
+// Pacing used when reading from a capture file
+enum class ReplayMode {
+    AS_FAST_AS_POSSIBLE,    // No pacing, for benchmarking and reprocessing
+    ORIGINAL_TIMING,        // Reproduce the recorded inter-packet gaps
+    SCALED                  // Recorded gaps divided by replay_speed
+};
+
+// Frame sizes produced by the traffic generator
+enum class FrameSizeMix {
+    FIXED,          // Every frame generator_min_frame bytes
+    UNIFORM,        // Uniform between generator_min_frame and generator_max_frame
+    IMIX            // Simple IMIX: 7:4:1 of 60, 590 and 1514 bytes, clamped to the range
+};
+
+// Clock that stamps live frames
+enum class TimestampSource {
+    HOST,           // Kernel software timestamp taken on receive
+    ADAPTER         // NIC hardware timestamp, where the driver supports it
+};
+
 // Capture options structure
 struct CaptureOptions {
     bool promiscuous_mode = true;
@@ -15,16 +72,160 @@ struct CaptureOptions {
     bool capture_to_file = false;
     std::string output_file;
     bool enable_encryption = true;
+    
+    // Kernel capture buffer in bytes (0 = libpcap default). Larger buffers
+    // absorb longer bursts before the kernel starts dropping.
+    int buffer_size = 1024 * 1024;
+    
+    // Deliver each frame as soon as it arrives instead of batching up to
+    // timeout_ms; lower latency at the cost of more wakeups
+    bool immediate_mode = false;
+    
+    // Timestamps are always requested at nanosecond precision; this picks
+    // the clock. Unsupported sources fall back to HOST with a warning.
+    TimestampSource timestamp_source = TimestampSource::HOST;
+    
+    // Double buffer_size (up to max_buffer_size) whenever kernel drops are
+    // observed during a live pcap capture
+    bool adaptive_buffer = false;
+    int max_buffer_size = 64 * 1024 * 1024;
+    
+    // BPF expression compiled and installed in the kernel (empty = everything)
+    std::string capture_filter;
+    
+    // Per-protocol slicing of Ethernet frames: keep the L2-L4 headers plus
+    // the payload budget of the first matching rule (slice_payload when none
+    // matches, -1 = whole payload). Packet::actual_length keeps the wire length.
+    bool slicing = false;
+    std::vector<SliceRule> slice_rules;
+    int slice_payload = 0;
+    
+    // Drop frames already seen within dedup_window_us, as SPAN and mirror
+    // ports often deliver every frame twice. The table holds dedup_table_size
+    // fingerprints; size it for the packets of a few windows.
+    bool dedup = false;
+    int dedup_window_us = 1000;
+    size_t dedup_table_size = 65536;
+    
+    // Receive backend and TPACKET_V3 ring geometry
+    CaptureBackend backend = CaptureBackend::PCAP;
+    size_t ring_block_size = 4 * 1024 * 1024;
+    size_t ring_block_count = 64;
+    int ring_block_timeout_ms = 10;
+    
+    // Traffic mix of the GENERATOR backend. The device name is only a label.
+    // A rate of 0 generates as fast as the consumer reads; a packet count of
+    // 0 generates until the capture is stopped.
+    uint64_t generator_pps = 0;
+    uint64_t generator_packet_count = 0;
+    size_t generator_flows = 1024;
+    double generator_ipv6_share = 0.0;
+    double generator_udp_share = 0.5;
+    FrameSizeMix generator_size_mix = FrameSizeMix::IMIX;
+    size_t generator_min_frame = 60;
+    size_t generator_max_frame = 1514;
+    uint64_t generator_seed = 1;
+    
+    // Expose a selectable descriptor (see PacketCapture::get_selectable_fd)
+    // and read without blocking, so consumers sleep until traffic arrives.
+    // Pair with immediate_mode for the lowest wakeup latency. File replay
+    // without the capture thread ignores it: a file is always readable.
+    bool event_driven = false;
+    
+    // Receive on a dedicated thread that feeds a bounded queue
+    bool use_capture_thread = false;
+    size_t queue_capacity = 65536;
+    OverflowPolicy overflow_policy = OverflowPolicy::DROP_NEWEST;
+    
+    // Adaptive sampling in front of the capture thread queue, engaged while
+    // the queue is above shed_high_watermark (a fraction of queue_capacity)
+    // and released below shed_low_watermark. Live captures only.
+    SheddingMode load_shedding = SheddingMode::OFF;
+    double shed_high_watermark = 0.75;
+    double shed_low_watermark = 0.25;
+    uint32_t shed_max_rate = 64;
+    
+    // Offline replay pacing (replay_speed 2.0 plays twice as fast)
+    ReplayMode replay_mode = ReplayMode::AS_FAST_AS_POSSIBLE;
+    double replay_speed = 1.0;
+    
+    // Multi-core capture: number of sockets/workers in one PACKET_FANOUT group
+    // (0 disables fanout). A group id of 0 derives one from the process id.
+    // Fanout replaces the backend and the capture thread of a live capture:
+    // each worker reads its own TPACKET_V3 socket into its own queue.
+    size_t fanout_workers = 0;
+    FanoutMode fanout_mode = FanoutMode::HASH;
+    uint16_t fanout_group = 0;
+    
+    // CPUs the capture thread (or each fanout worker, round robin) runs on:
+    // a list such as "2-3,6", "numa" for the cores local to the device's NIC,
+    // or empty to leave placement to the scheduler
+    std::string cpu_affinity;
+    
+    // Multi-interface capture: how long the merge waits for a quiet
+    // interface before releasing packets from the others
+    int reorder_window_us = 10000;
 };
 
-// Packet structure
+// Capture thread queue counters
+struct CaptureQueueCounters {
+    uint64_t enqueued = 0;
+    uint64_t dropped_newest = 0;
+    uint64_t dropped_oldest = 0;
+    uint64_t producer_waits = 0;
+    size_t depth = 0;
+    size_t high_water = 0;
+};
+
+// Point-in-time capture statistics. Counters cover the current capture;
+// rates cover the interval since the previous get_stats() call.
+struct CaptureStats {
+    uint64_t packets_received = 0;
+    uint64_t bytes_received = 0;        // Wire length, not the captured slice
+    uint64_t kernel_dropped = 0;        // No room in the kernel buffer/ring
+    uint64_t interface_dropped = 0;     // Dropped by the interface or driver
+    uint64_t queue_dropped = 0;         // Dropped at the capture thread queue
+    uint64_t shed_packets = 0;          // Left out by load-shedding sampling
+    uint64_t duplicates_dropped = 0;    // Removed by the dedup stage
+    uint32_t sampling_rate = 1;         // Current load-shedding rate (1 in N)
+    size_t queue_depth = 0;
+    size_t queue_high_water = 0;
+    double packets_per_second = 0.0;
+    double bytes_per_second = 0.0;
+};
+
+// Build capture options from the capture.* configuration keys
+CaptureOptions capture_options_from_config(const Config& config);
+
+// Compile a BPF expression for the given link type. On failure the reason
+// is stored in error. The program must be released with pcap_freecode.
+bool compile_capture_filter(const std::string& expression, int linktype, int snapshot_length,
+                            struct bpf_program& program, std::string& error);
+
+// Packet structure. Copying a Packet shares its data buffer.
 struct Packet {
-    uint64_t timestamp;
-    std::vector<uint8_t> data;
+    uint64_t timestamp;         // Nanoseconds since the Unix epoch
+    PacketBuffer data;
+    size_t actual_length;
+    size_t captured_length;
+    uint32_t sampling_rate = 1; // Packets this one stands for under load shedding
+};
+
+// Non-owning view of a captured frame. The data pointer is only valid for
+// the duration of the visitor call it is passed to.
+struct PacketView {
+    uint64_t timestamp;         // Nanoseconds since the Unix epoch
+    const uint8_t* data;
     size_t actual_length;
     size_t captured_length;
+    uint32_t sampling_rate = 1; // Packets this one stands for under load shedding
 };
 
+using PacketVisitor = std::function<void(const PacketView&)>;
+
+// Capture lifecycle notification
+using CaptureCallback = std::function<void()>;
+
 class PacketCapture {
 public:
     PacketCapture();
@@ -33,6 +234,19 @@ public:
     // Initialize capture device
     bool initialize_device(const std::string& device_name, CaptureOptions options);
     
+    // Read packets from a pcap/pcapng file instead of a live device.
+    // The capture stops by itself at end of file.
+    bool initialize_file(const std::string& file_path, CaptureOptions options);
+    
+    // True when the source is a capture file
+    bool is_offline() const { return m_offline; }
+    
+    // Device or file the capture was initialized with
+    std::string get_device_name() const { return m_device_name; }
+    
+    // DLT_* link type of the open source (-1 when none is open)
+    int get_datalink() const;
+    
     // Get list of available devices
     std::vector<std::string> get_available_devices();
     
@@ -45,18 +259,190 @@ public:
     // Get next packet (non-blocking)
     bool get_next_packet(Packet& packet);
     
+    // Get up to max_packets packets in one call. The vector is grown to
+    // max_packets if needed and the first N entries are filled; existing
+    // entries keep their buffers so repeated calls do not reallocate.
+    // Returns N.
+    size_t get_next_packets(std::vector<Packet>& packets, size_t max_packets);
+    
+    // Visit up to max_packets frames without copying them.
+    // Returns the number of frames visited.
+    size_t dispatch_packets(const PacketVisitor& visitor, size_t max_packets);
+    
+    // Replace the kernel capture filter. Safe during a live capture: the
+    // kernel swaps programs atomically, so no frame sees a half-installed
+    // filter. Compile errors are reported through get_error().
+    bool set_capture_filter(const std::string& filter);
+    
     // Check if capture is active
     bool is_capturing() const { return m_capturing; }
     
+    // Options the device was initialized with
+    const CaptureOptions& get_options() const { return m_options; }
+    
     // Get error message
-    std::string get_error() const { return m_error_message; }
+    std::string get_error() const;
+    
+    // Event-driven mode: descriptor that becomes readable when packets are
+    // waiting (or the capture ended), for select/poll/epoll or a GUI socket
+    // notifier. After a wakeup, read until no packets are returned. -1 when
+    // not capturing in event-driven mode.
+    int get_selectable_fd() const { return m_epoll_fd; }
+    
+    // Event-driven mode: block until packets are waiting, at most timeout_ms
+    // (-1 = forever). Returns false on timeout.
+    bool wait_for_packets(int timeout_ms);
+    
+    // Notifications, called on the thread that starts/stops the capture or
+    // reads the packets respectively
+    void setStartCallback(CaptureCallback callback) { m_start_callback = std::move(callback); }
+    void setStopCallback(CaptureCallback callback) { m_stop_callback = std::move(callback); }
+    void setPacketCallback(CaptureCallback callback) { m_packet_callback = std::move(callback); }
+    
+    // Queue counters when running with a capture thread
+    CaptureQueueCounters get_queue_counters() const;
+    
+    // Snapshot of receive, drop and queue statistics. Intended for periodic
+    // polling (e.g. once a second) from the consumer thread.
+    CaptureStats get_stats();
 
 private:
+    void close_handles();
+    void set_error(const std::string& message);
+    
+    // Sleep until a file packet is due under the replay mode
+    void pace_replay(uint64_t timestamp);
+    
+    // Install a compiled filter on the open backend
+    bool install_filter(struct bpf_program& program);
+    void apply_pending_filter();
+    
+    // Read frames straight from the backend
+    size_t read_from_device(const PacketVisitor& visitor, size_t max_packets);
+    
+    // Capture thread body and its enqueue step
+    void capture_thread_main();
+    void enqueue_packet(const PacketView& view);
+    
+    // Receive-path accounting, one call per batch
+    void account_packets(size_t packets, uint64_t bytes);
+    
+    // Refresh the kernel drop counters. Must run on the thread that reads
+    // from the backend, since the handles are not thread-safe.
+    void sample_kernel_stats();
+    
+    // Reopen the pcap handle with a larger kernel buffer after drops
+    void grow_kernel_buffer();
+    
+    // Set up the GENERATOR backend in place of a device
+    bool initialize_generator(const std::string& name);
+    
+    // Set up a PACKET_FANOUT group in place of a single socket
+    bool initialize_fanout(const std::string& device_name);
+    
+    // Take a frame queued by the fanout workers; ends the capture once a
+    // failed worker has stopped the group and the queues are empty
+    bool pop_fanout_packet(Packet& packet);
+    
+    // Enable slicing when the options ask for it and the link is Ethernet
+    void configure_slicer(int linktype);
+    
+    // Set up load shedding; flow sampling needs an Ethernet link
+    void configure_shedder(int linktype);
+    
+    // Set up duplicate elimination for the link type
+    void configure_dedup(int linktype);
+    
+    // Event-driven mode plumbing
+    bool open_event_fds();
+    void close_event_fds();
+    void signal_wakeup();
+    void rearm_wakeup();
+    
+    // Tell the packet callback about a non-empty read
+    size_t notify_packets(size_t count);
+    
     pcap_t* m_pcap_handle;
-    bool m_capturing;
+    std::mutex m_handle_mutex;          // Guards handle swaps against pcap_breakloop
+    std::unique_ptr<TPacketRing> m_ring;
+    std::unique_ptr<TrafficGenerator> m_generator;
+    std::unique_ptr<FanoutCapture> m_fanout;
+    std::string m_device_name;
+    
+    // Nanoseconds per pcap tv_usec unit: 1 for nanosecond handles, 1000
+    // when the handle only delivers microseconds
+    uint64_t m_timestamp_scale;
+    
+    PacketSlicer m_slicer;
+    bool m_slicing;
+    FrameDeduplicator m_dedup;          // Used by the reading thread only
+    bool m_dedup_enabled;
+    std::atomic<bool> m_capturing;
+    bool m_offline;
+    
+    // Replay clock: first file timestamp and when it was delivered
+    bool m_replay_started;
+    uint64_t m_replay_first_timestamp;
+    std::chrono::steady_clock::time_point m_replay_start;
     std::string m_error_message;
+    mutable std::mutex m_error_mutex;
     CaptureOptions m_options;
     
+    // Capture thread and the queue it feeds
+    std::unique_ptr<PacketRing<Packet>> m_queue;
+    std::thread m_capture_thread;
+    std::atomic<bool> m_thread_running;
+    Packet m_consumer_packet;
+    LoadShedder m_shedder;              // Used by the capture thread only
+    
+    // Event-driven mode: epoll set handed to consumers and, with a capture
+    // thread, the eventfd the thread signals while the consumer is waiting
+    int m_epoll_fd;
+    int m_wakeup_fd;
+    std::atomic<bool> m_consumer_waiting;
+    
+    CaptureCallback m_start_callback;
+    CaptureCallback m_stop_callback;
+    CaptureCallback m_packet_callback;
+    
+    // Filter run in user space on generated frames
+    std::vector<struct bpf_insn> m_generator_filter;
+    
+    // Filter waiting to be installed by the capture thread
+    std::mutex m_filter_mutex;
+    struct bpf_program m_pending_filter;
+    std::atomic<bool> m_filter_pending;
+    
+    std::atomic<uint64_t> m_enqueued;
+    std::atomic<uint64_t> m_dropped_newest;
+    std::atomic<uint64_t> m_dropped_oldest;
+    std::atomic<uint64_t> m_producer_waits;
+    std::atomic<size_t> m_queue_high_water;
+    
+    // Receive statistics, written only by the reading thread
+    std::atomic<uint64_t> m_packets_received;
+    std::atomic<uint64_t> m_bytes_received;
+    std::atomic<uint64_t> m_kernel_dropped;
+    std::atomic<uint64_t> m_interface_dropped;
+    
+    // Drops counted by handles that were replaced by grow_kernel_buffer()
+    uint64_t m_kernel_dropped_base;
+    uint64_t m_interface_dropped_base;
+    
+    // Rate baseline from the previous get_stats() call
+    std::chrono::steady_clock::time_point m_stats_time;
+    uint64_t m_stats_packets;
+    uint64_t m_stats_bytes;
+    
+    // State handed to packet_handler through pcap_dispatch
+    struct DispatchContext {
+        PacketCapture* capture;
+        const PacketVisitor* visitor;
+        size_t count;
+        size_t duplicates;
+        uint64_t bytes;
+    };
+    
     // Callback for packet processing
     static void packet_handler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet);
 };
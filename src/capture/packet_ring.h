@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace wireshark_mcp {
+
+// Bounded lock-free ring between one producer and one consumer.
+//
+// Every slot carries a sequence number, so besides the consumer the producer
+// may also remove the oldest entry (drop-oldest overflow handling) without
+// racing a consumer that is still reading it. Elements are filled and
+// drained in place: try_pop swaps the consumer's object into the slot, which
+// lets buffers owned by T circulate instead of being reallocated.
+template<typename T>
+class PacketRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit PacketRing(size_t capacity)
+        : m_capacity(round_up_pow2(capacity)),
+          m_mask(m_capacity - 1),
+          m_slots(new Slot[m_capacity]),
+          m_tail(0),
+          m_head(0) {
+        for (size_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    size_t capacity() const { return m_capacity; }
+
+    // Approximate number of queued elements
+    size_t size() const {
+        size_t tail = m_tail.load(std::memory_order_acquire);
+        size_t head = m_head.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Producer only: fill the next free slot in place by calling writer(T&).
+    // Returns false if the ring is full.
+    template<typename Writer>
+    bool try_push(Writer&& writer) {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[pos & m_mask];
+
+        if (slot.sequence.load(std::memory_order_acquire) != pos) {
+            return false;
+        }
+
+        writer(slot.value);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        m_tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Take the oldest element by swapping it with item.
+    // Returns false if the ring is empty.
+    bool try_pop(T& item) {
+        return take_oldest([&item](T& value) {
+            using std::swap;
+            swap(item, value);
+        });
+    }
+
+    // Drop the oldest element, leaving its storage in the ring for reuse.
+    // Returns false if the ring is empty.
+    bool try_discard() {
+        return take_oldest([](T&) {});
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Both the consumer and an evicting producer dequeue here, so the head
+    // is claimed with a CAS before the slot is touched
+    template<typename Reader>
+    bool take_oldest(Reader&& reader) {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        Slot* slot;
+
+        for (;;) {
+            slot = &m_slots[pos & m_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+
+        reader(slot->value);
+        slot->sequence.store(pos + m_capacity, std::memory_order_release);
+        return true;
+    }
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> m_tail;
+    alignas(64) std::atomic<size_t> m_head;
+};
+
+} // namespace wireshark_mcp
@@ -0,0 +1,292 @@
+#include "packet_slicer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint16_t ETHERTYPE_IPV6 = 0x86DD;
+constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint16_t ETHERTYPE_QINQ = 0x88A8;
+
+constexpr uint8_t IP_PROTO_ICMP = 1;
+constexpr uint8_t IP_PROTO_TCP = 6;
+constexpr uint8_t IP_PROTO_UDP = 17;
+constexpr uint8_t IP_PROTO_ICMPV6 = 58;
+constexpr uint8_t IP_PROTO_SCTP = 132;
+
+// IPv6 extension headers that can precede the transport header
+constexpr uint8_t IPV6_HOP_BY_HOP = 0;
+constexpr uint8_t IPV6_ROUTING = 43;
+constexpr uint8_t IPV6_FRAGMENT = 44;
+constexpr uint8_t IPV6_DEST_OPTIONS = 60;
+constexpr int IPV6_MAX_EXTENSIONS = 8;
+
+constexpr size_t ETHERNET_HEADER_LEN = 14;
+constexpr size_t VLAN_TAG_LEN = 4;
+constexpr size_t IPV4_MIN_HEADER_LEN = 20;
+constexpr size_t IPV6_HEADER_LEN = 40;
+constexpr size_t TCP_MIN_HEADER_LEN = 20;
+constexpr size_t UDP_HEADER_LEN = 8;
+
+uint16_t read_be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+bool parse_number(const std::string& text, long max_value, long& value) {
+    if (text.empty()) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    value = std::strtol(text.c_str(), &end, 10);
+    return *end == '\0' && value >= 0 && value <= max_value;
+}
+
+bool parse_protocol(const std::string& name, uint8_t& protocol) {
+    if (name == "any") {
+        protocol = 0;
+    } else if (name == "tcp") {
+        protocol = IP_PROTO_TCP;
+    } else if (name == "udp") {
+        protocol = IP_PROTO_UDP;
+    } else if (name == "icmp") {
+        protocol = IP_PROTO_ICMP;
+    } else if (name == "icmpv6") {
+        protocol = IP_PROTO_ICMPV6;
+    } else if (name == "sctp") {
+        protocol = IP_PROTO_SCTP;
+    } else {
+        long number;
+        if (!parse_number(name, 255, number)) {
+            return false;
+        }
+        protocol = static_cast<uint8_t>(number);
+    }
+    
+    return true;
+}
+
+} // namespace
+
+bool parse_slice_rules(const std::string& spec, std::vector<SliceRule>& rules,
+                       std::string& error) {
+    rules.clear();
+    
+    std::istringstream stream(spec);
+    std::string entry;
+    
+    while (std::getline(stream, entry, ',')) {
+        entry = trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+        
+        // proto[/port]:bytes
+        size_t colon = entry.find(':');
+        if (colon == std::string::npos) {
+            error = "Slice rule '" + entry + "' has no payload size";
+            return false;
+        }
+        
+        std::string match = trim(entry.substr(0, colon));
+        std::string budget = trim(entry.substr(colon + 1));
+        std::string port;
+        
+        size_t slash = match.find('/');
+        if (slash != std::string::npos) {
+            port = trim(match.substr(slash + 1));
+            match = trim(match.substr(0, slash));
+        }
+        
+        SliceRule rule;
+        long number;
+        
+        if (!parse_protocol(match, rule.ip_protocol)) {
+            error = "Unknown protocol in slice rule '" + entry + "'";
+            return false;
+        }
+        
+        if (!port.empty()) {
+            if (!parse_number(port, 65535, number)) {
+                error = "Invalid port in slice rule '" + entry + "'";
+                return false;
+            }
+            rule.port = static_cast<uint16_t>(number);
+        }
+        
+        if (budget == "all") {
+            rule.payload_bytes = -1;
+        } else if (parse_number(budget, 65535, number)) {
+            rule.payload_bytes = static_cast<int>(number);
+        } else {
+            error = "Invalid payload size in slice rule '" + entry + "'";
+            return false;
+        }
+        
+        rules.push_back(rule);
+    }
+    
+    return true;
+}
+
+PacketSlicer::PacketSlicer()
+    : m_default_payload(-1) {
+}
+
+size_t PacketSlicer::slice_length(const uint8_t* data, size_t captured_length) const {
+    if (captured_length < ETHERNET_HEADER_LEN) {
+        return captured_length;
+    }
+    
+    size_t offset = ETHERNET_HEADER_LEN;
+    uint16_t ethertype = read_be16(data + 12);
+    
+    while ((ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ) &&
+           offset + VLAN_TAG_LEN <= captured_length) {
+        ethertype = read_be16(data + offset + 2);
+        offset += VLAN_TAG_LEN;
+    }
+    
+    uint8_t ip_protocol = 0;
+    bool first_fragment = true;
+    
+    // Anything cut short by the snaplen is kept as it is
+    if (ethertype == ETHERTYPE_IPV4) {
+        if (offset + IPV4_MIN_HEADER_LEN > captured_length) {
+            return captured_length;
+        }
+        
+        size_t header_length = static_cast<size_t>(data[offset] & 0x0F) * 4;
+        if (header_length < IPV4_MIN_HEADER_LEN) {
+            return captured_length;
+        }
+        
+        ip_protocol = data[offset + 9];
+        first_fragment = (read_be16(data + offset + 6) & 0x1FFF) == 0;
+        offset += header_length;
+    } else if (ethertype == ETHERTYPE_IPV6) {
+        if (offset + IPV6_HEADER_LEN > captured_length) {
+            return captured_length;
+        }
+        
+        ip_protocol = data[offset + 6];
+        offset += IPV6_HEADER_LEN;
+        
+        for (int i = 0; i < IPV6_MAX_EXTENSIONS; ++i) {
+            if (ip_protocol != IPV6_HOP_BY_HOP && ip_protocol != IPV6_ROUTING &&
+                ip_protocol != IPV6_FRAGMENT && ip_protocol != IPV6_DEST_OPTIONS) {
+                break;
+            }
+            
+            if (offset + 8 > captured_length) {
+                return captured_length;
+            }
+            
+            size_t length = 8;
+            if (ip_protocol == IPV6_FRAGMENT) {
+                first_fragment = (read_be16(data + offset + 2) & 0xFFF8) == 0;
+            } else {
+                length = (static_cast<size_t>(data[offset + 1]) + 1) * 8;
+            }
+            
+            ip_protocol = data[offset];
+            offset += length;
+        }
+    } else {
+        // ARP, LLDP, STP, ...: small control traffic
+        return captured_length;
+    }
+    
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    
+    // Later fragments carry no transport header
+    if (first_fragment) {
+        if (ip_protocol == IP_PROTO_TCP) {
+            if (offset + TCP_MIN_HEADER_LEN > captured_length) {
+                return captured_length;
+            }
+            
+            size_t header_length = static_cast<size_t>(data[offset + 12] >> 4) * 4;
+            if (header_length < TCP_MIN_HEADER_LEN) {
+                return captured_length;
+            }
+            
+            src_port = read_be16(data + offset);
+            dst_port = read_be16(data + offset + 2);
+            offset += header_length;
+        } else if (ip_protocol == IP_PROTO_UDP) {
+            if (offset + UDP_HEADER_LEN > captured_length) {
+                return captured_length;
+            }
+            
+            src_port = read_be16(data + offset);
+            dst_port = read_be16(data + offset + 2);
+            offset += UDP_HEADER_LEN;
+        }
+    }
+    
+    int budget = first_fragment ? payload_budget(ip_protocol, src_port, dst_port)
+                                : fragment_budget(ip_protocol);
+    if (budget < 0 || offset >= captured_length) {
+        return captured_length;
+    }
+    
+    return std::min(captured_length, offset + static_cast<size_t>(budget));
+}
+
+int PacketSlicer::payload_budget(uint8_t ip_protocol, uint16_t src_port, uint16_t dst_port) const {
+    for (const auto& rule : m_rules) {
+        if (rule.ip_protocol != 0 && rule.ip_protocol != ip_protocol) {
+            continue;
+        }
+        
+        if (rule.port != 0 && rule.port != src_port && rule.port != dst_port) {
+            continue;
+        }
+        
+        return rule.payload_bytes;
+    }
+    
+    return m_default_payload;
+}
+
+int PacketSlicer::fragment_budget(uint8_t ip_protocol) const {
+    // The ports are in the first fragment, so any port rule up to the first
+    // catch-all for the protocol may be the one that applies
+    int budget = 0;
+    
+    for (const auto& rule : m_rules) {
+        if (rule.ip_protocol != 0 && rule.ip_protocol != ip_protocol) {
+            continue;
+        }
+        
+        if (rule.payload_bytes < 0) {
+            return -1;
+        }
+        
+        budget = std::max(budget, rule.payload_bytes);
+        
+        if (rule.port == 0) {
+            return budget;
+        }
+    }
+    
+    return m_default_payload < 0 ? -1 : std::max(budget, m_default_payload);
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wireshark_mcp {
+
+// Payload kept after the L4 header for matching traffic
+struct SliceRule {
+    uint8_t ip_protocol = 0;    // IPPROTO_TCP, IPPROTO_UDP, ... (0 = any)
+    uint16_t port = 0;          // Matches either port (0 = any)
+    int payload_bytes = 0;      // -1 keeps the whole payload
+};
+
+// Parse a rule list such as "udp/53:all, tcp/443:128, tcp:0".
+// Returns false and sets error on a malformed entry.
+bool parse_slice_rules(const std::string& spec, std::vector<SliceRule>& rules,
+                       std::string& error);
+
+// Decides how much of an Ethernet frame is worth keeping.
+//
+// L2-L4 headers (including VLAN tags and IPv6 extension headers) are always
+// kept; the payload after them is cut to the budget of the first matching
+// rule, or the default budget when none matches. Frames that are not IP are
+// kept whole, since they are small and rarely bulk data. Non-first IP
+// fragments have no ports to match, so they get the largest budget any rule
+// for their protocol could give them.
+class PacketSlicer {
+public:
+    PacketSlicer();
+
+    void set_rules(std::vector<SliceRule> rules) { m_rules = std::move(rules); }
+    void set_default_payload(int payload_bytes) { m_default_payload = payload_bytes; }
+
+    const std::vector<SliceRule>& get_rules() const { return m_rules; }
+    int get_default_payload() const { return m_default_payload; }
+
+    // Number of leading bytes to keep, at most captured_length
+    size_t slice_length(const uint8_t* data, size_t captured_length) const;
+
+private:
+    int payload_budget(uint8_t ip_protocol, uint16_t src_port, uint16_t dst_port) const;
+    int fragment_budget(uint8_t ip_protocol) const;
+
+    std::vector<SliceRule> m_rules;
+    int m_default_payload;
+};
+
+} // namespace wireshark_mcp
@@ -0,0 +1,381 @@
+#include "tpacket_ring.h"
+#include "../common/logging.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Frame slot size used for ring accounting (TPACKET_V3 packs frames
+// back to back inside a block, so this only bounds the frame count)
+constexpr size_t RING_FRAME_SIZE = 2048;
+
+} // namespace
+
+TPacketRing::TPacketRing()
+    : m_fd(-1),
+      m_map(nullptr),
+      m_map_size(0),
+      m_block_size(0),
+      m_block_count(0),
+      m_snapshot_length(0),
+      m_current_block(0),
+      m_next_frame(nullptr),
+      m_frames_left(0),
+      m_kernel_dropped(0) {
+}
+
+TPacketRing::~TPacketRing() {
+    close();
+}
+
+#ifdef __linux__
+
+bool TPacketRing::open(const std::string& device_name, const CaptureOptions& options) {
+    close();
+
+    unsigned int ifindex = if_nametoindex(device_name.c_str());
+    if (ifindex == 0) {
+        m_error_message = "Unknown network interface: " + device_name;
+        return false;
+    }
+
+    m_fd = ::socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (m_fd < 0) {
+        m_error_message = "Failed to create packet socket: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        m_error_message = "TPACKET_V3 not supported: " + std::string(std::strerror(errno));
+        close();
+        return false;
+    }
+
+    // Blocks must be a multiple of the page size
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_block_size = std::max(options.ring_block_size, page_size);
+    m_block_size = (m_block_size + page_size - 1) / page_size * page_size;
+    m_block_count = std::max<size_t>(options.ring_block_count, 2);
+    m_snapshot_length = static_cast<size_t>(options.snapshot_length);
+
+    struct tpacket_req3 req;
+    std::memset(&req, 0, sizeof(req));
+    req.tp_block_size = static_cast<unsigned int>(m_block_size);
+    req.tp_block_nr = static_cast<unsigned int>(m_block_count);
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = static_cast<unsigned int>((m_block_size / RING_FRAME_SIZE) * m_block_count);
+    req.tp_retire_blk_tov = static_cast<unsigned int>(options.ring_block_timeout_ms);
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        m_error_message = "Failed to set up receive ring: " + std::string(std::strerror(errno));
+        close();
+        return false;
+    }
+
+    m_map_size = m_block_size * m_block_count;
+    void* map = mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, m_fd, 0);
+    if (map == MAP_FAILED) {
+        m_error_message = "Failed to map receive ring: " + std::string(std::strerror(errno));
+        m_map_size = 0;
+        close();
+        return false;
+    }
+
+    m_map = static_cast<uint8_t*>(map);
+    m_blocks.resize(m_block_count);
+    for (size_t i = 0; i < m_block_count; ++i) {
+        m_blocks[i] = m_map + i * m_block_size;
+    }
+
+    if (options.promiscuous_mode) {
+        struct packet_mreq mreq;
+        std::memset(&mreq, 0, sizeof(mreq));
+        mreq.mr_ifindex = static_cast<int>(ifindex);
+        mreq.mr_type = PACKET_MR_PROMISC;
+
+        if (setsockopt(m_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            Log::warning("Failed to enable promiscuous mode on {}: {}",
+                         device_name, std::strerror(errno));
+        }
+    }
+
+    struct sockaddr_ll addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = static_cast<int>(ifindex);
+
+    if (bind(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        m_error_message = "Failed to bind packet socket: " + std::string(std::strerror(errno));
+        close();
+        return false;
+    }
+
+    if (options.timestamp_source == TimestampSource::ADAPTER) {
+        enable_hardware_timestamps(device_name);
+    }
+
+    Log::info("TPACKET_V3 ring mapped on {}: {} blocks of {} bytes",
+              device_name, m_block_count, m_block_size);
+    return true;
+}
+
+void TPacketRing::enable_hardware_timestamps(const std::string& device_name) {
+    // Have the driver stamp every received frame...
+    struct hwtstamp_config config;
+    std::memset(&config, 0, sizeof(config));
+    config.tx_type = HWTSTAMP_TX_OFF;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+    struct ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, device_name.c_str(), IFNAMSIZ - 1);
+    ifr.ifr_data = reinterpret_cast<char*>(&config);
+
+    if (ioctl(m_fd, SIOCSHWTSTAMP, &ifr) < 0) {
+        Log::warning("Adapter timestamps not supported on {}: {}, using host timestamps",
+                     device_name, std::strerror(errno));
+        return;
+    }
+
+    // ...and report that clock in the ring instead of the software one
+    int source = SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_TIMESTAMP, &source, sizeof(source)) < 0) {
+        Log::warning("Failed to select adapter timestamps on {}: {}",
+                     device_name, std::strerror(errno));
+    }
+}
+
+bool TPacketRing::join_fanout(uint16_t group_id, FanoutMode mode) {
+    if (!is_open()) {
+        m_error_message = "Receive ring not open";
+        return false;
+    }
+
+    int type = PACKET_FANOUT_HASH;
+    switch (mode) {
+        case FanoutMode::HASH:
+            // Reassemble fragments first so they hash with the rest of their flow
+            type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+            break;
+        case FanoutMode::CPU:
+            type = PACKET_FANOUT_CPU;
+            break;
+        case FanoutMode::ROUND_ROBIN:
+            type = PACKET_FANOUT_LB;
+            break;
+    }
+
+    int fanout_arg = static_cast<int>(group_id) | (type << 16);
+    if (setsockopt(m_fd, SOL_PACKET, PACKET_FANOUT, &fanout_arg, sizeof(fanout_arg)) < 0) {
+        m_error_message = "Failed to join fanout group: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool TPacketRing::attach_filter(const struct bpf_program& program) {
+    if (!is_open()) {
+        m_error_message = "Receive ring not open";
+        return false;
+    }
+
+    // struct bpf_insn and struct sock_filter share the same layout
+    struct sock_fprog fprog;
+    fprog.len = static_cast<unsigned short>(program.bf_len);
+    fprog.filter = reinterpret_cast<struct sock_filter*>(program.bf_insns);
+
+    if (setsockopt(m_fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0) {
+        m_error_message = "Failed to attach capture filter: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+void TPacketRing::close() {
+    if (m_map) {
+        munmap(m_map, m_map_size);
+        m_map = nullptr;
+        m_map_size = 0;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    m_blocks.clear();
+    m_current_block = 0;
+    m_next_frame = nullptr;
+    m_frames_left = 0;
+    m_kernel_dropped = 0;
+}
+
+bool TPacketRing::read_statistics(uint64_t& kernel_dropped) {
+    if (!is_open()) {
+        return false;
+    }
+
+    struct tpacket_stats_v3 stats;
+    socklen_t length = sizeof(stats);
+
+    if (getsockopt(m_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &length) < 0) {
+        m_error_message = "Failed to read ring statistics: " + std::string(std::strerror(errno));
+        return false;
+    }
+
+    m_kernel_dropped += stats.tp_drops;
+    kernel_dropped = m_kernel_dropped;
+    return true;
+}
+
+bool TPacketRing::block_ready(size_t index) const {
+    auto* desc = reinterpret_cast<struct tpacket_block_desc*>(m_blocks[index]);
+    uint32_t status = __atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+    return (status & TP_STATUS_USER) != 0;
+}
+
+void TPacketRing::release_block(size_t index) {
+    auto* desc = reinterpret_cast<struct tpacket_block_desc*>(m_blocks[index]);
+    __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+}
+
+int TPacketRing::dispatch(const PacketVisitor& visitor, size_t max_packets, int timeout_ms,
+                          uint64_t* bytes) {
+    if (!is_open()) {
+        m_error_message = "Receive ring not open";
+        return -1;
+    }
+
+    size_t count = 0;
+
+    while (count < max_packets) {
+        if (m_frames_left == 0) {
+            if (!block_ready(m_current_block)) {
+                // Never sleep once there is something to hand back
+                if (count > 0) {
+                    break;
+                }
+
+                struct pollfd pfd;
+                pfd.fd = m_fd;
+                pfd.events = POLLIN | POLLERR;
+                pfd.revents = 0;
+
+                if (poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR) {
+                    m_error_message = "Failed to poll receive ring: " +
+                                      std::string(std::strerror(errno));
+                    return -1;
+                }
+
+                if (!block_ready(m_current_block)) {
+                    return 0;
+                }
+            }
+
+            auto* desc = reinterpret_cast<struct tpacket_block_desc*>(m_blocks[m_current_block]);
+            m_frames_left = desc->hdr.bh1.num_pkts;
+            m_next_frame = m_blocks[m_current_block] + desc->hdr.bh1.offset_to_first_pkt;
+
+            if (m_frames_left == 0) {
+                release_block(m_current_block);
+                m_current_block = (m_current_block + 1) % m_block_count;
+                continue;
+            }
+        }
+
+        auto* hdr = reinterpret_cast<struct tpacket3_hdr*>(m_next_frame);
+
+        PacketView view;
+        view.timestamp = static_cast<uint64_t>(hdr->tp_sec) * 1000000000ULL + hdr->tp_nsec;
+        view.data = m_next_frame + hdr->tp_mac;
+        view.actual_length = hdr->tp_len;
+        view.captured_length = std::min<size_t>(hdr->tp_snaplen, m_snapshot_length);
+
+        visitor(view);
+        ++count;
+
+        if (bytes) {
+            *bytes += view.actual_length;
+        }
+
+        // Hand the block back only after its last frame has been consumed
+        if (--m_frames_left == 0) {
+            release_block(m_current_block);
+            m_current_block = (m_current_block + 1) % m_block_count;
+            m_next_frame = nullptr;
+        } else {
+            m_next_frame += hdr->tp_next_offset;
+        }
+    }
+
+    return static_cast<int>(count);
+}
+
+#else // !__linux__
+
+bool TPacketRing::open(const std::string& device_name, const CaptureOptions& options) {
+    m_error_message = "TPACKET_V3 capture is only available on Linux";
+    return false;
+}
+
+bool TPacketRing::join_fanout(uint16_t group_id, FanoutMode mode) {
+    m_error_message = "PACKET_FANOUT is only available on Linux";
+    return false;
+}
+
+bool TPacketRing::attach_filter(const struct bpf_program& program) {
+    m_error_message = "TPACKET_V3 capture is only available on Linux";
+    return false;
+}
+
+void TPacketRing::close() {
+}
+
+void TPacketRing::enable_hardware_timestamps(const std::string& device_name) {
+}
+
+bool TPacketRing::block_ready(size_t index) const {
+    return false;
+}
+
+void TPacketRing::release_block(size_t index) {
+}
+
+int TPacketRing::dispatch(const PacketVisitor& visitor, size_t max_packets, int timeout_ms,
+                          uint64_t* bytes) {
+    m_error_message = "TPACKET_V3 capture is only available on Linux";
+    return -1;
+}
+
+bool TPacketRing::read_statistics(uint64_t& kernel_dropped) {
+    return false;
+}
+
+#endif // __linux__
+
+} // namespace wireshark_mcp
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "packet_capture.h"
+
+namespace wireshark_mcp {
+
+// Linux AF_PACKET TPACKET_V3 receive ring.
+//
+// The kernel fills fixed-size blocks inside a memory-mapped ring and hands a
+// whole block to user space at once. Frames are passed to the visitor in place;
+// a block is only returned to the kernel once every frame in it has been
+// visited, so no per-packet copy or syscall is needed on the receive path.
+class TPacketRing {
+public:
+    TPacketRing();
+    ~TPacketRing();
+
+    TPacketRing(const TPacketRing&) = delete;
+    TPacketRing& operator=(const TPacketRing&) = delete;
+
+    // Create the socket, map the ring and bind it to the device
+    bool open(const std::string& device_name, const CaptureOptions& options);
+
+    // Join a PACKET_FANOUT group so the kernel spreads frames across sockets
+    bool join_fanout(uint16_t group_id, FanoutMode mode);
+
+    // Attach a compiled BPF program to the socket, replacing any previous one
+    bool attach_filter(const struct bpf_program& program);
+
+    // Unmap the ring and close the socket
+    void close();
+
+    bool is_open() const { return m_fd >= 0; }
+
+    // Visit up to max_packets frames, waiting at most timeout_ms for the
+    // kernel to retire a block. Returns the number of frames visited.
+    // Returns -1 on error. Wire bytes of the visited frames are added to
+    // *bytes when given.
+    int dispatch(const PacketVisitor& visitor, size_t max_packets, int timeout_ms,
+                 uint64_t* bytes = nullptr);
+
+    // Cumulative kernel drop count (the kernel resets its counters on every
+    // read, so they are accumulated here)
+    bool read_statistics(uint64_t& kernel_dropped);
+
+    // Socket descriptor (for filters, statistics and polling)
+    int get_fd() const { return m_fd; }
+
+    std::string get_error() const { return m_error_message; }
+
+private:
+    // Block ownership handshake with the kernel
+    bool block_ready(size_t index) const;
+    void release_block(size_t index);
+
+    // Switch the ring to NIC hardware timestamps (best effort)
+    void enable_hardware_timestamps(const std::string& device_name);
+
+    int m_fd;
+    uint8_t* m_map;
+    size_t m_map_size;
+    size_t m_block_size;
+    size_t m_block_count;
+    size_t m_snapshot_length;
+    std::vector<uint8_t*> m_blocks;
+
+    // Read position inside the current block
+    size_t m_current_block;
+    uint8_t* m_next_frame;
+    uint32_t m_frames_left;
+
+    uint64_t m_kernel_dropped;
+
+    std::string m_error_message;
+};
+
+} // namespace wireshark_mcp
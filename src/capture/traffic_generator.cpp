@@ -0,0 +1,340 @@
+#include "traffic_generator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr size_t ETHERNET_HEADER_LEN = 14;
+constexpr size_t IPV4_HEADER_LEN = 20;
+constexpr size_t IPV6_HEADER_LEN = 40;
+constexpr size_t TCP_HEADER_LEN = 20;
+constexpr size_t UDP_HEADER_LEN = 8;
+
+// Largest header (Ethernet + IPv6 + TCP) and the template stride
+constexpr size_t MAX_HEADER_LEN = ETHERNET_HEADER_LEN + IPV6_HEADER_LEN + TCP_HEADER_LEN;
+constexpr size_t TEMPLATE_STRIDE = 80;
+
+constexpr size_t MAX_FRAME_LEN = 65535;
+
+constexpr uint8_t IP_PROTO_TCP = 6;
+constexpr uint8_t IP_PROTO_UDP = 17;
+constexpr uint8_t TCP_FLAGS_PSH_ACK = 0x18;
+
+// Simple IMIX frame sizes (without FCS) and their weights out of 12
+constexpr size_t IMIX_SMALL = 60;
+constexpr size_t IMIX_MEDIUM = 590;
+constexpr size_t IMIX_LARGE = 1514;
+
+// Well-known server ports the flows are spread over
+constexpr uint16_t SERVER_PORTS[] = {80, 443, 53, 8080, 5201, 22, 123, 3306};
+
+// Locally administered client and server MAC addresses
+constexpr uint8_t CLIENT_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+constexpr uint8_t SERVER_MAC[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+
+void write_be16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+void write_be32(uint8_t* p, uint32_t value) {
+    p[0] = static_cast<uint8_t>(value >> 24);
+    p[1] = static_cast<uint8_t>(value >> 16);
+    p[2] = static_cast<uint8_t>(value >> 8);
+    p[3] = static_cast<uint8_t>(value);
+}
+
+uint16_t ipv4_header_checksum(const uint8_t* header) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < IPV4_HEADER_LEN; i += 2) {
+        sum += static_cast<uint32_t>((header[i] << 8) | header[i + 1]);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+uint64_t wall_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+TrafficGenerator::TrafficGenerator()
+    : m_size_mix(FrameSizeMix::IMIX),
+      m_min_frame(IMIX_SMALL),
+      m_max_frame(IMIX_LARGE),
+      m_snapshot_length(MAX_FRAME_LEN),
+      m_pps(0),
+      m_packet_limit(0),
+      m_seed(1),
+      m_random_state(1),
+      m_ip_id(0),
+      m_generated(0),
+      m_last_timestamp(0),
+      m_start_wall_ns(0) {
+}
+
+bool TrafficGenerator::configure(const CaptureOptions& options) {
+    if (options.generator_flows == 0) {
+        m_error_message = "Traffic generator needs at least one flow";
+        return false;
+    }
+    
+    if (options.generator_min_frame > options.generator_max_frame ||
+        options.generator_max_frame > MAX_FRAME_LEN) {
+        m_error_message = "Invalid traffic generator frame size range";
+        return false;
+    }
+    
+    m_size_mix = options.generator_size_mix;
+    m_min_frame = options.generator_min_frame;
+    m_max_frame = options.generator_max_frame;
+    m_snapshot_length = options.snapshot_length > 0 ? static_cast<size_t>(options.snapshot_length)
+                                                    : MAX_FRAME_LEN;
+    m_pps = options.generator_pps;
+    m_packet_limit = options.generator_packet_count;
+    m_seed = options.generator_seed != 0 ? options.generator_seed : 1;
+    m_random_state = m_seed;
+    
+    m_flows.assign(options.generator_flows, Flow());
+    m_templates.assign(options.generator_flows * 2 * TEMPLATE_STRIDE, 0);
+    
+    for (size_t i = 0; i < m_flows.size(); ++i) {
+        build_flow(i, options);
+    }
+    
+    // Payload bytes keep whatever pattern is left behind; only headers change
+    m_frame.assign(std::max(m_max_frame, MAX_HEADER_LEN + sizeof(uint64_t)), 0);
+    for (size_t i = 0; i < m_frame.size(); ++i) {
+        m_frame[i] = static_cast<uint8_t>(i);
+    }
+    
+    restart();
+    return true;
+}
+
+void TrafficGenerator::restart() {
+    m_generated = 0;
+    m_last_timestamp = 0;
+    m_ip_id = 0;
+    m_start = std::chrono::steady_clock::now();
+    m_start_wall_ns = wall_clock_ns();
+}
+
+uint64_t TrafficGenerator::next_random() {
+    // xorshift64*
+    m_random_state ^= m_random_state >> 12;
+    m_random_state ^= m_random_state << 25;
+    m_random_state ^= m_random_state >> 27;
+    return m_random_state * 0x2545F4914F6CDD1DULL;
+}
+
+void TrafficGenerator::build_flow(size_t index, const CaptureOptions& options) {
+    Flow& flow = m_flows[index];
+    
+    // Shares are drawn per flow, so every packet of a flow looks alike
+    double draw = static_cast<double>(next_random() >> 11) / static_cast<double>(1ULL << 53);
+    flow.ipv6 = draw < options.generator_ipv6_share;
+    draw = static_cast<double>(next_random() >> 11) / static_cast<double>(1ULL << 53);
+    flow.udp = draw < options.generator_udp_share;
+    flow.sequence[0] = static_cast<uint32_t>(next_random());
+    flow.sequence[1] = static_cast<uint32_t>(next_random());
+    
+    uint16_t client_port = static_cast<uint16_t>(1024 + next_random() % (65536 - 1024));
+    uint16_t server_port = SERVER_PORTS[next_random() % (sizeof(SERVER_PORTS) / sizeof(SERVER_PORTS[0]))];
+    uint32_t client = static_cast<uint32_t>(index);
+    uint32_t server = static_cast<uint32_t>(index % 250 + 1);
+    
+    size_t network_length = flow.ipv6 ? IPV6_HEADER_LEN : IPV4_HEADER_LEN;
+    size_t transport_length = flow.udp ? UDP_HEADER_LEN : TCP_HEADER_LEN;
+    flow.header_length = ETHERNET_HEADER_LEN + network_length + transport_length;
+    
+    // Direction 0 is client to server, direction 1 the reply
+    for (int direction = 0; direction < 2; ++direction) {
+        uint8_t* frame = &m_templates[(index * 2 + direction) * TEMPLATE_STRIDE];
+        
+        std::memcpy(frame, direction == 0 ? SERVER_MAC : CLIENT_MAC, 6);
+        std::memcpy(frame + 6, direction == 0 ? CLIENT_MAC : SERVER_MAC, 6);
+        write_be16(frame + 12, flow.ipv6 ? 0x86DD : 0x0800);
+        
+        uint8_t* ip = frame + ETHERNET_HEADER_LEN;
+        uint8_t protocol = flow.udp ? IP_PROTO_UDP : IP_PROTO_TCP;
+        
+        // Benchmarking ranges: 198.18.0.0/15 and 2001:db8::/32
+        uint8_t client_address[16] = {0};
+        uint8_t server_address[16] = {0};
+        
+        if (flow.ipv6) {
+            write_be16(client_address, 0x2001);
+            write_be16(client_address + 2, 0x0DB8);
+            write_be16(client_address + 4, 1);
+            write_be32(client_address + 12, client);
+            write_be16(server_address, 0x2001);
+            write_be16(server_address + 2, 0x0DB8);
+            write_be16(server_address + 4, 2);
+            write_be32(server_address + 12, server);
+            
+            ip[0] = 0x60;
+            ip[6] = protocol;
+            ip[7] = 64;
+            std::memcpy(ip + 8, direction == 0 ? client_address : server_address, 16);
+            std::memcpy(ip + 24, direction == 0 ? server_address : client_address, 16);
+        } else {
+            write_be32(client_address, 0xC6120000 | (client & 0xFFFF));
+            write_be32(server_address, 0xC6130000 | server);
+            
+            ip[0] = 0x45;
+            ip[6] = 0x40;   // Don't fragment
+            ip[8] = 64;
+            ip[9] = protocol;
+            std::memcpy(ip + 12, direction == 0 ? client_address : server_address, 4);
+            std::memcpy(ip + 16, direction == 0 ? server_address : client_address, 4);
+        }
+        
+        uint8_t* transport = ip + network_length;
+        write_be16(transport, direction == 0 ? client_port : server_port);
+        write_be16(transport + 2, direction == 0 ? server_port : client_port);
+        
+        if (!flow.udp) {
+            transport[12] = 0x50;   // Data offset 5 words
+            transport[13] = TCP_FLAGS_PSH_ACK;
+            write_be16(transport + 14, 0xFFFF);
+        }
+    }
+}
+
+size_t TrafficGenerator::next_frame_size() {
+    size_t size = m_min_frame;
+    
+    if (m_size_mix == FrameSizeMix::UNIFORM) {
+        size = m_min_frame + static_cast<size_t>(next_random() % (m_max_frame - m_min_frame + 1));
+    } else if (m_size_mix == FrameSizeMix::IMIX) {
+        uint64_t pick = next_random() % 12;
+        size = pick < 7 ? IMIX_SMALL : pick < 11 ? IMIX_MEDIUM : IMIX_LARGE;
+        size = std::min(std::max(size, m_min_frame), m_max_frame);
+    }
+    
+    return size;
+}
+
+size_t TrafficGenerator::build_frame(size_t index, int direction, uint64_t serial) {
+    Flow& flow = m_flows[index];
+    uint8_t* frame = m_frame.data();
+    
+    std::memcpy(frame, &m_templates[(index * 2 + direction) * TEMPLATE_STRIDE], flow.header_length);
+    
+    size_t length = std::max(next_frame_size(), flow.header_length);
+    uint8_t* ip = frame + ETHERNET_HEADER_LEN;
+    uint8_t* transport;
+    
+    if (flow.ipv6) {
+        transport = ip + IPV6_HEADER_LEN;
+        write_be16(ip + 4, static_cast<uint16_t>(length - ETHERNET_HEADER_LEN - IPV6_HEADER_LEN));
+    } else {
+        transport = ip + IPV4_HEADER_LEN;
+        write_be16(ip + 2, static_cast<uint16_t>(length - ETHERNET_HEADER_LEN));
+        write_be16(ip + 4, m_ip_id++);
+        write_be16(ip + 10, ipv4_header_checksum(ip));
+    }
+    
+    size_t payload = length - flow.header_length;
+    
+    if (flow.udp) {
+        write_be16(transport + 4, static_cast<uint16_t>(UDP_HEADER_LEN + payload));
+    } else {
+        write_be32(transport + 4, flow.sequence[direction]);
+        write_be32(transport + 8, flow.sequence[1 - direction]);
+        flow.sequence[direction] += static_cast<uint32_t>(payload);
+    }
+    
+    // A serial number keeps otherwise identical frames (e.g. IPv6 UDP) distinct
+    if (payload >= sizeof(serial)) {
+        std::memcpy(frame + flow.header_length, &serial, sizeof(serial));
+    }
+    
+    return length;
+}
+
+uint64_t TrafficGenerator::packets_due(std::chrono::steady_clock::time_point now) const {
+    double elapsed = std::chrono::duration<double>(now - m_start).count();
+    uint64_t scheduled = static_cast<uint64_t>(elapsed * static_cast<double>(m_pps));
+    
+    return scheduled > m_generated ? scheduled - m_generated : 0;
+}
+
+int TrafficGenerator::dispatch(const PacketVisitor& visitor, size_t max_packets, int timeout_ms,
+                               uint64_t* bytes) {
+    if (m_flows.empty()) {
+        m_error_message = "Traffic generator not configured";
+        return -1;
+    }
+    
+    size_t count = max_packets;
+    if (m_packet_limit > 0) {
+        uint64_t left = m_packet_limit - std::min(m_generated, m_packet_limit);
+        count = static_cast<size_t>(std::min<uint64_t>(count, left));
+    }
+    
+    if (m_pps > 0 && count > 0) {
+        auto now = std::chrono::steady_clock::now();
+        uint64_t due = packets_due(now);
+        
+        if (due == 0) {
+            // Sleep until the next frame falls due, but not past the timeout
+            double next_seconds = static_cast<double>(m_generated + 1) / static_cast<double>(m_pps);
+            auto next = m_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(next_seconds));
+            auto deadline = now + std::chrono::milliseconds(std::max(timeout_ms, 0));
+            
+            std::this_thread::sleep_until(std::min(next, deadline));
+            due = packets_due(std::chrono::steady_clock::now());
+        }
+        
+        count = static_cast<size_t>(std::min<uint64_t>(count, due));
+    }
+    
+    uint64_t now_ns = m_pps == 0 && count > 0 ? wall_clock_ns() : 0;
+    size_t delivered = 0;
+    
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t random = next_random();
+        size_t flow = static_cast<size_t>((random >> 1) % m_flows.size());
+        
+        PacketView view;
+        view.data = m_frame.data();
+        view.actual_length = build_frame(flow, static_cast<int>(random & 1), m_generated);
+        view.captured_length = std::min(view.actual_length, m_snapshot_length);
+        
+        // Paced frames carry their scheduled time, unpaced ones the wall clock
+        if (m_pps > 0) {
+            view.timestamp = m_start_wall_ns + static_cast<uint64_t>(
+                static_cast<double>(m_generated) * 1e9 / static_cast<double>(m_pps));
+        } else {
+            view.timestamp = std::max(now_ns, m_last_timestamp + 1);
+        }
+        m_last_timestamp = view.timestamp;
+        ++m_generated;
+        
+        if (m_filter && !m_filter(view)) {
+            continue;
+        }
+        
+        visitor(view);
+        ++delivered;
+        
+        if (bytes) {
+            *bytes += view.actual_length;
+        }
+    }
+    
+    return static_cast<int>(delivered);
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "packet_capture.h"
+
+namespace wireshark_mcp {
+
+// Decides whether a generated frame is delivered (e.g. a compiled BPF filter)
+using FrameFilter = std::function<bool(const PacketView&)>;
+
+// Synthetic packet source for load testing without a NIC.
+//
+// Builds a table of TCP and UDP flows over IPv4 and IPv6 up front, then
+// stamps frames out of per-flow header templates into one scratch buffer:
+// only lengths, the IPv4 id and checksum, TCP sequence numbers and a serial
+// number in the payload change per frame. Frames are handed to the visitor
+// in place, like the TPACKET_V3 ring, so generation costs little more than a
+// header copy and the analyzer and storage paths can be driven to saturation.
+// Transport checksums are left zero, as on a host with checksum offload.
+class TrafficGenerator {
+public:
+    TrafficGenerator();
+
+    TrafficGenerator(const TrafficGenerator&) = delete;
+    TrafficGenerator& operator=(const TrafficGenerator&) = delete;
+
+    // Build the flow table from the generator_* options
+    bool configure(const CaptureOptions& options);
+
+    // Restart pacing and the packet count for a new capture
+    void restart();
+
+    // Only frames the filter accepts are delivered and counted in bytes
+    void set_filter(FrameFilter filter) { m_filter = std::move(filter); }
+
+    // Generate up to max_packets frames, waiting at most timeout_ms for the
+    // next one to fall due under the target rate. Returns the number of frames
+    // delivered. Wire bytes of the delivered frames are added to *bytes when
+    // given.
+    int dispatch(const PacketVisitor& visitor, size_t max_packets, int timeout_ms,
+                 uint64_t* bytes = nullptr);
+
+    // True once generator_packet_count frames have been generated
+    bool finished() const { return m_packet_limit > 0 && m_generated >= m_packet_limit; }
+
+    // Frames generated since restart(), including filtered ones
+    uint64_t get_generated() const { return m_generated; }
+
+    size_t get_flow_count() const { return m_flows.size(); }
+
+    std::string get_error() const { return m_error_message; }
+
+private:
+    struct Flow {
+        size_t header_length;
+        bool ipv6;
+        bool udp;
+        uint32_t sequence[2];   // Next TCP sequence number per direction
+    };
+
+    void build_flow(size_t index, const CaptureOptions& options);
+
+    // Write a frame of the flow into the scratch buffer; returns its length
+    size_t build_frame(size_t flow, int direction, uint64_t serial);
+
+    size_t next_frame_size();
+    uint64_t next_random();
+
+    // Frames due under the target rate that have not been generated yet
+    uint64_t packets_due(std::chrono::steady_clock::time_point now) const;
+
+    std::vector<Flow> m_flows;
+    std::vector<uint8_t> m_templates;   // Two header templates (one per direction) per flow
+    std::vector<uint8_t> m_frame;       // Scratch frame handed to the visitor
+
+    FrameSizeMix m_size_mix;
+    size_t m_min_frame;
+    size_t m_max_frame;
+    size_t m_snapshot_length;
+    uint64_t m_pps;
+    uint64_t m_packet_limit;
+    uint64_t m_seed;
+    uint64_t m_random_state;
+    uint16_t m_ip_id;
+
+    uint64_t m_generated;
+    uint64_t m_last_timestamp;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_start_wall_ns;
+
+    FrameFilter m_filter;
+    std::string m_error_message;
+};
+
+} // namespace wireshark_mcp
@@ -0,0 +1,61 @@
+#ifndef WIRESHARK_MCP_BYTE_ORDER_H
+#define WIRESHARK_MCP_BYTE_ORDER_H
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
+namespace wireshark_mcp {
+
+// MSVC only targets little-endian machines and defines neither
+// __BYTE_ORDER__ nor the GCC byte-swap builtins
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+constexpr bool HOST_LITTLE_ENDIAN = true;
+#else
+constexpr bool HOST_LITTLE_ENDIAN = false;
+#endif
+
+inline uint16_t byte_swap16(uint16_t value) {
+#ifdef _MSC_VER
+    return _byteswap_ushort(value);
+#else
+    return __builtin_bswap16(value);
+#endif
+}
+
+inline uint32_t byte_swap32(uint32_t value) {
+#ifdef _MSC_VER
+    return _byteswap_ulong(value);
+#else
+    return __builtin_bswap32(value);
+#endif
+}
+
+// Convert between network (big-endian) and host order
+inline uint16_t big_endian16(uint16_t value) {
+    return HOST_LITTLE_ENDIAN ? byte_swap16(value) : value;
+}
+
+inline uint32_t big_endian32(uint32_t value) {
+    return HOST_LITTLE_ENDIAN ? byte_swap32(value) : value;
+}
+
+// Single unaligned loads of big-endian fields
+inline uint16_t load_be16(const uint8_t* p) {
+    uint16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return big_endian16(value);
+}
+
+inline uint32_t load_be32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return big_endian32(value);
+}
+
+} // namespace wireshark_mcp
+
+#endif // WIRESHARK_MCP_BYTE_ORDER_H
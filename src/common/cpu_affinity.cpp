@@ -0,0 +1,192 @@
+#include "cpu_affinity.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Highest node number accepted by bind_memory_to_node
+constexpr int MAX_NUMA_NODES = 1024;
+
+// MPOL_PREFERRED from <linux/mempolicy.h>: allocate on the node when it has
+// free memory, fall back to others instead of failing
+constexpr int MEMORY_POLICY_PREFERRED = 1;
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+bool parse_cpu(const std::string& text, int& cpu) {
+    if (text.empty()) {
+        return false;
+    }
+    
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || value < 0 || value > 65535) {
+        return false;
+    }
+    
+    cpu = static_cast<int>(value);
+    return true;
+}
+
+} // namespace
+
+bool parse_cpu_list(const std::string& spec, std::vector<int>& cpus, std::string& error) {
+    cpus.clear();
+    
+    std::istringstream stream(spec);
+    std::string entry;
+    
+    while (std::getline(stream, entry, ',')) {
+        entry = trim(entry);
+        if (entry.empty()) {
+            continue;
+        }
+        
+        int first;
+        int last;
+        size_t dash = entry.find('-');
+        
+        if (dash == std::string::npos) {
+            if (!parse_cpu(entry, first)) {
+                error = "Invalid CPU '" + entry + "'";
+                return false;
+            }
+            last = first;
+        } else if (!parse_cpu(trim(entry.substr(0, dash)), first) ||
+                   !parse_cpu(trim(entry.substr(dash + 1)), last) || first > last) {
+            error = "Invalid CPU range '" + entry + "'";
+            return false;
+        }
+        
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
+bool resolve_cpu_set(const std::string& spec, const std::string& device_name,
+                     std::vector<int>& cpus, std::string& error) {
+    if (trim(spec) != "numa") {
+        return parse_cpu_list(spec, cpus, error);
+    }
+    
+    int node = device_numa_node(device_name);
+    cpus = node >= 0 ? numa_node_cpus(node) : std::vector<int>();
+    
+    if (cpus.empty()) {
+        error = "NUMA node of " + device_name + " is unknown";
+        return false;
+    }
+    
+    return true;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error) {
+    if (cpus.empty()) {
+        return true;
+    }
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    
+    for (int cpu : cpus) {
+        if (cpu >= CPU_SETSIZE) {
+            error = "CPU " + std::to_string(cpu) + " is out of range";
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        error = "Failed to set thread affinity (error " + std::to_string(result) + ")";
+        return false;
+    }
+    
+    return true;
+#else
+    error = "Thread pinning is only available on Linux";
+    return false;
+#endif
+}
+
+int device_numa_node(const std::string& device_name) {
+    // Device names never contain a path separator
+    if (device_name.empty() || device_name.find('/') != std::string::npos) {
+        return -1;
+    }
+    
+    std::ifstream file("/sys/class/net/" + device_name + "/device/numa_node");
+    int node = -1;
+    
+    if (!(file >> node)) {
+        return -1;
+    }
+    
+    // The kernel reports -1 on machines without NUMA
+    return node;
+}
+
+std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+    
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    std::string error;
+    
+    if (!std::getline(file, list) || !parse_cpu_list(list, cpus, error)) {
+        cpus.clear();
+    }
+    
+    return cpus;
+}
+
+bool bind_memory_to_node(void* address, size_t length, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node < 0 || node >= MAX_NUMA_NODES) {
+        return false;
+    }
+    
+    constexpr size_t BITS_PER_WORD = sizeof(unsigned long) * 8;
+    unsigned long mask[MAX_NUMA_NODES / BITS_PER_WORD] = {};
+    mask[node / BITS_PER_WORD] = 1UL << (node % BITS_PER_WORD);
+    
+    // The kernel reads one bit less than maxnode
+    return syscall(SYS_mbind, address, length, MEMORY_POLICY_PREFERRED, mask,
+                   static_cast<unsigned long>(MAX_NUMA_NODES) + 1, 0) == 0;
+#else
+    (void)address;
+    (void)length;
+    (void)node;
+    return false;
+#endif
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,36 @@
+#ifndef WIRESHARK_MCP_CPU_AFFINITY_H
+#define WIRESHARK_MCP_CPU_AFFINITY_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace wireshark_mcp {
+
+// Parse a CPU list in the kernel's cpulist syntax, e.g. "0-3,8,10-11".
+// An empty spec gives an empty list. Returns false and sets error on a
+// malformed entry.
+bool parse_cpu_list(const std::string& spec, std::vector<int>& cpus, std::string& error);
+
+// Resolve a thread placement setting: a CPU list, "numa" for the CPUs of the
+// NUMA node the network device is attached to, or empty for no pinning.
+bool resolve_cpu_set(const std::string& spec, const std::string& device_name,
+                     std::vector<int>& cpus, std::string& error);
+
+// Restrict the calling thread to the given CPUs (nothing to do for an empty list)
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error);
+
+// NUMA node a network device is attached to, or -1 when unknown (virtual
+// devices, single-node machines, non-Linux builds)
+int device_numa_node(const std::string& device_name);
+
+// CPUs belonging to a NUMA node (empty when unknown)
+std::vector<int> numa_node_cpus(int node);
+
+// Prefer the given node for the pages of a page-aligned mapping that has not
+// been touched yet. Best effort: returns false where unsupported.
+bool bind_memory_to_node(void* address, size_t length, int node);
+
+} // namespace wireshark_mcp
+
+#endif // WIRESHARK_MCP_CPU_AFFINITY_H
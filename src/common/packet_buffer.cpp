@@ -0,0 +1,301 @@
+#include "packet_buffer.h"
+#include "config.h"
+#include "cpu_affinity.h"
+#include "logging.h"
+
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+constexpr uint32_t NO_BLOCK = 0xFFFFFFFF;
+constexpr size_t CACHE_LINE = 64;
+
+// Standard Ethernet frames fit comfortably in one buffer
+constexpr size_t DEFAULT_BUFFER_SIZE = 2048;
+constexpr size_t DEFAULT_BUFFER_COUNT = 16384;
+
+uint32_t index_of(uint64_t head) {
+    return static_cast<uint32_t>(head & 0xFFFFFFFF);
+}
+
+uint64_t make_head(uint64_t previous, uint32_t index) {
+    return (((previous >> 32) + 1) << 32) | index;
+}
+
+} // namespace
+
+// PacketBuffer implementation
+PacketBuffer::PacketBuffer(const PacketBuffer& other) noexcept
+    : m_block(other.m_block) {
+    if (m_block) {
+        m_block->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PacketBuffer::PacketBuffer(PacketBuffer&& other) noexcept
+    : m_block(other.m_block) {
+    other.m_block = nullptr;
+}
+
+PacketBuffer& PacketBuffer::operator=(const PacketBuffer& other) noexcept {
+    if (m_block != other.m_block) {
+        if (other.m_block) {
+            other.m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        m_block = other.m_block;
+    }
+    return *this;
+}
+
+PacketBuffer& PacketBuffer::operator=(PacketBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        m_block = other.m_block;
+        other.m_block = nullptr;
+    }
+    return *this;
+}
+
+PacketBuffer::~PacketBuffer() {
+    release();
+}
+
+const uint8_t* PacketBuffer::data() const {
+    return m_block ? m_block->bytes() : nullptr;
+}
+
+uint8_t* PacketBuffer::mutable_data() {
+    return m_block ? m_block->bytes() : nullptr;
+}
+
+size_t PacketBuffer::size() const {
+    return m_block ? m_block->size : 0;
+}
+
+size_t PacketBuffer::capacity() const {
+    return m_block ? m_block->capacity : 0;
+}
+
+uint32_t PacketBuffer::use_count() const {
+    return m_block ? m_block->refs.load(std::memory_order_relaxed) : 0;
+}
+
+void PacketBuffer::assign(const uint8_t* first, const uint8_t* last) {
+    size_t length = static_cast<size_t>(last - first);
+    resize(length);
+
+    if (length > 0) {
+        std::memcpy(m_block->bytes(), first, length);
+    }
+}
+
+void PacketBuffer::resize(size_t size) {
+    // Sole owner with enough room: reuse in place
+    if (m_block && m_block->capacity >= size &&
+        m_block->refs.load(std::memory_order_acquire) == 1) {
+        m_block->size = static_cast<uint32_t>(size);
+        return;
+    }
+
+    *this = PacketBufferPool::default_pool().allocate(size);
+}
+
+void PacketBuffer::clear() {
+    release();
+}
+
+void PacketBuffer::release() {
+    if (!m_block) {
+        return;
+    }
+
+    Block* block = m_block;
+    m_block = nullptr;
+
+    if (block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (block->pool) {
+        block->pool->push_free(block);
+    } else {
+        block->~Block();
+        ::operator delete(block);
+    }
+}
+
+// PacketBufferPool implementation
+PacketBufferPool::PacketBufferPool(size_t buffer_size, size_t buffer_count, int numa_node)
+    : m_buffer_size(buffer_size),
+      m_buffer_count(buffer_count),
+      m_stride((sizeof(Block) + buffer_size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE),
+      m_slab_size(0),
+      m_numa_node(numa_node),
+      m_slab(nullptr),
+      m_free_head(NO_BLOCK),
+      m_heap_fallbacks(0) {
+    if (m_buffer_count >= NO_BLOCK) {
+        m_buffer_count = NO_BLOCK - 1;
+    }
+
+#ifdef __linux__
+    // Map the slab directly so its pages can be bound to the node before the
+    // free-list setup below first touches them
+    size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    m_slab_size = (m_stride * m_buffer_count + page_size - 1) / page_size * page_size;
+
+    void* mapping = mmap(nullptr, m_slab_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    m_slab = static_cast<uint8_t*>(mapping);
+
+    if (m_numa_node >= 0 && !bind_memory_to_node(m_slab, m_slab_size, m_numa_node)) {
+        Log::warning("Could not place packet buffers on NUMA node {}", m_numa_node);
+        m_numa_node = -1;
+    }
+#else
+    m_slab_size = m_stride * m_buffer_count;
+    m_slab = static_cast<uint8_t*>(::operator new(m_slab_size, std::align_val_t(CACHE_LINE)));
+    m_numa_node = -1;
+#endif
+
+    // Thread every slot onto the free list, lowest index first
+    uint32_t next = NO_BLOCK;
+    for (size_t i = m_buffer_count; i-- > 0;) {
+        Block* block = new (m_slab + i * m_stride) Block;
+        block->refs.store(0, std::memory_order_relaxed);
+        block->size = 0;
+        block->capacity = static_cast<uint32_t>(m_buffer_size);
+        block->index = static_cast<uint32_t>(i);
+        block->next_free.store(next, std::memory_order_relaxed);
+        block->pool = this;
+        next = static_cast<uint32_t>(i);
+    }
+
+    m_free_head.store(next, std::memory_order_release);
+}
+
+PacketBufferPool::~PacketBufferPool() {
+    for (size_t i = 0; i < m_buffer_count; ++i) {
+        block_at(static_cast<uint32_t>(i))->~Block();
+    }
+
+#ifdef __linux__
+    munmap(m_slab, m_slab_size);
+#else
+    ::operator delete(m_slab, std::align_val_t(CACHE_LINE));
+#endif
+}
+
+PacketBufferPool& PacketBufferPool::default_pool() {
+    // Intentionally never destroyed: buffers may still be alive in other
+    // static objects during shutdown
+    static PacketBufferPool* pool = [] {
+        auto& config = Config::getInstance();
+        size_t buffer_size = static_cast<size_t>(config.get<int>(
+            "memory.packet_buffer_size", static_cast<int>(DEFAULT_BUFFER_SIZE)));
+        size_t buffer_count = static_cast<size_t>(config.get<int>(
+            "memory.packet_buffer_count", static_cast<int>(DEFAULT_BUFFER_COUNT)));
+
+        // "auto" follows the NIC of the (first) default capture device
+        int numa_node = -1;
+        std::string placement = config.get<std::string>("memory.numa_node", "auto");
+        if (placement == "auto") {
+            std::string device = config.get<std::string>("capture.default_device", "");
+            numa_node = device_numa_node(device.substr(0, device.find(',')));
+        } else if (placement != "none") {
+            numa_node = config.get<int>("memory.numa_node", -1);
+        }
+
+        Log::info("Packet buffer pool: {} buffers of {} bytes", buffer_count, buffer_size);
+        PacketBufferPool* result = new PacketBufferPool(buffer_size, buffer_count, numa_node);
+        if (result->get_numa_node() >= 0) {
+            Log::info("Packet buffer pool placed on NUMA node {}", result->get_numa_node());
+        }
+        return result;
+    }();
+
+    return *pool;
+}
+
+PacketBuffer PacketBufferPool::allocate(size_t size) {
+    Block* block = nullptr;
+
+    if (size <= m_buffer_size) {
+        block = pop_free();
+    }
+
+    if (!block) {
+        m_heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        block = allocate_heap(size);
+    }
+
+    block->refs.store(1, std::memory_order_relaxed);
+    block->size = static_cast<uint32_t>(size);
+    return PacketBuffer(block);
+}
+
+PacketBuffer PacketBufferPool::copy(const uint8_t* data, size_t data_len) {
+    PacketBuffer buffer = allocate(data_len);
+
+    if (data_len > 0) {
+        std::memcpy(buffer.mutable_data(), data, data_len);
+    }
+
+    return buffer;
+}
+
+PacketBufferPool::Block* PacketBufferPool::pop_free() {
+    uint64_t head = m_free_head.load(std::memory_order_acquire);
+
+    for (;;) {
+        uint32_t index = index_of(head);
+        if (index == NO_BLOCK) {
+            return nullptr;
+        }
+
+        // The link may be stale if another thread won the race; the tag
+        // makes the CAS fail in that case
+        Block* block = block_at(index);
+        uint32_t next = block->next_free.load(std::memory_order_relaxed);
+
+        if (m_free_head.compare_exchange_weak(head, make_head(head, next),
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+            return block;
+        }
+    }
+}
+
+void PacketBufferPool::push_free(Block* block) {
+    uint64_t head = m_free_head.load(std::memory_order_relaxed);
+
+    do {
+        block->next_free.store(index_of(head), std::memory_order_relaxed);
+    } while (!m_free_head.compare_exchange_weak(head, make_head(head, block->index),
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+}
+
+PacketBufferPool::Block* PacketBufferPool::allocate_heap(size_t size) {
+    void* memory = ::operator new(sizeof(Block) + size);
+    Block* block = new (memory) Block;
+    block->capacity = static_cast<uint32_t>(size);
+    block->index = NO_BLOCK;
+    block->next_free.store(NO_BLOCK, std::memory_order_relaxed);
+    block->pool = nullptr;
+    return block;
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,149 @@
+#ifndef WIRESHARK_MCP_PACKET_BUFFER_H
+#define WIRESHARK_MCP_PACKET_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wireshark_mcp {
+
+class PacketBufferPool;
+
+// Reference-counted handle to the bytes of one frame.
+//
+// Copying a handle shares the underlying buffer, so capture, analysis and
+// storage can all hold the same frame without a memcpy. Buffers come from a
+// PacketBufferPool and return to it when the last handle goes away. The
+// interface mirrors the parts of std::vector<uint8_t> the code base uses.
+class PacketBuffer {
+public:
+    PacketBuffer() noexcept : m_block(nullptr) {}
+    PacketBuffer(const PacketBuffer& other) noexcept;
+    PacketBuffer(PacketBuffer&& other) noexcept;
+    PacketBuffer& operator=(const PacketBuffer& other) noexcept;
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept;
+    ~PacketBuffer();
+
+    const uint8_t* data() const;
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const { return size() == 0; }
+
+    const uint8_t* begin() const { return data(); }
+    const uint8_t* end() const { return data() + size(); }
+    uint8_t operator[](size_t index) const { return data()[index]; }
+
+    // Writable access. Only valid while this handle is the sole owner;
+    // resize() and assign() guarantee that.
+    uint8_t* mutable_data();
+
+    // Replace the contents. Reuses the current buffer when this handle is
+    // the only owner and it is large enough, otherwise takes a new one from
+    // the default pool.
+    void assign(const uint8_t* first, const uint8_t* last);
+
+    // Make the buffer hold size bytes (contents unspecified when it has to
+    // be replaced), with the same reuse rules as assign()
+    void resize(size_t size);
+
+    // Drop this handle's reference
+    void clear();
+
+    // Number of handles sharing the buffer (0 for an empty handle)
+    uint32_t use_count() const;
+
+    std::vector<uint8_t> to_vector() const { return std::vector<uint8_t>(begin(), end()); }
+
+    void swap(PacketBuffer& other) noexcept {
+        Block* block = m_block;
+        m_block = other.m_block;
+        other.m_block = block;
+    }
+
+    // Header placed in front of every buffer
+    struct Block {
+        std::atomic<uint32_t> refs;
+        uint32_t size;
+        uint32_t capacity;
+        uint32_t index;                     // Slot in the owning pool
+        std::atomic<uint32_t> next_free;    // Pool free-list link
+        PacketBufferPool* pool;             // nullptr for oversize heap buffers
+
+        uint8_t* bytes() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+
+private:
+    friend class PacketBufferPool;
+
+    explicit PacketBuffer(Block* block) noexcept : m_block(block) {}
+
+    void release();
+
+    Block* m_block;
+};
+
+inline void swap(PacketBuffer& a, PacketBuffer& b) noexcept {
+    a.swap(b);
+}
+
+// Fixed-size slab of packet buffers with a lock-free free list.
+//
+// Frames larger than the buffer size, and requests made while the slab is
+// exhausted, fall back to individual heap allocations so callers never
+// fail. The pool must outlive every buffer taken from it. Given a NUMA
+// node, the slab pages are placed on that node (Linux only, best effort).
+class PacketBufferPool {
+public:
+    PacketBufferPool(size_t buffer_size, size_t buffer_count, int numa_node = -1);
+    ~PacketBufferPool();
+
+    PacketBufferPool(const PacketBufferPool&) = delete;
+    PacketBufferPool& operator=(const PacketBufferPool&) = delete;
+
+    // Take a buffer holding size bytes (contents unspecified)
+    PacketBuffer allocate(size_t size);
+
+    // Take a buffer and copy data_len bytes into it
+    PacketBuffer copy(const uint8_t* data, size_t data_len);
+
+    size_t get_buffer_size() const { return m_buffer_size; }
+    size_t get_buffer_count() const { return m_buffer_count; }
+    int get_numa_node() const { return m_numa_node; }
+
+    // Allocations served from the heap instead of the slab
+    uint64_t get_heap_fallbacks() const { return m_heap_fallbacks.load(std::memory_order_relaxed); }
+
+    // Process-wide pool sized from the memory.packet_buffer_* config keys and
+    // placed by memory.numa_node
+    static PacketBufferPool& default_pool();
+
+private:
+    friend class PacketBuffer;
+
+    using Block = PacketBuffer::Block;
+
+    Block* block_at(uint32_t index) const {
+        return reinterpret_cast<Block*>(m_slab + static_cast<size_t>(index) * m_stride);
+    }
+
+    Block* pop_free();
+    void push_free(Block* block);
+
+    static Block* allocate_heap(size_t size);
+
+    size_t m_buffer_size;
+    size_t m_buffer_count;
+    size_t m_stride;
+    size_t m_slab_size;
+    int m_numa_node;
+    uint8_t* m_slab;
+
+    // Free-list head: ABA tag in the upper 32 bits, slot index in the lower
+    std::atomic<uint64_t> m_free_head;
+    std::atomic<uint64_t> m_heap_fallbacks;
+};
+
+} // namespace wireshark_mcp
+
+#endif // WIRESHARK_MCP_PACKET_BUFFER_H
@@ -1,6 +1,8 @@
 #include "capture_file.h"
+#include "capture_format.h"
 #include "../common/logging.h"
 #include "../security/security_manager.h"
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <stdexcept>
@@ -10,21 +12,9 @@ namespace wireshark_mcp {
 
 // Packet structure for storage
 struct StoredPacket {
-    std::chrono::system_clock::time_point timestamp;
-    std::vector<uint8_t> data;
-};
-
-// File format constants
-constexpr uint32_t FILE_MAGIC = 0x57534D43; // "WSMC" in hex
-constexpr uint16_t FILE_VERSION = 0x0100;    // Version 1.0
-
-// File header structure
-struct FileHeader {
-    uint32_t magic;         // Magic number for file identification
-    uint16_t version;       // File format version
-    uint16_t flags;         // Flags (encrypted, compressed, etc.)
-    uint64_t packet_count;  // Number of packets in the file
-    uint64_t reserved;      // Reserved for future use
+    PacketTimestamp timestamp;
+    PacketBuffer data;
+    size_t original_length = 0;     // Wire length, at least data.size()
 };
 
 // Implementation class
@@ -37,7 +27,63 @@ struct CaptureFile::Impl {
     std::string device_name;
     std::string user_comment;
     
-    Impl() : modified(false), open(false), encrypted(false) {}
+    // Streaming mode: packets go to file_path as they arrive instead of
+    // into memory. streamed stays set once the writer is closed, since the
+    // packets then only exist on disk.
+    std::unique_ptr<CaptureWriter> writer;
+    bool streamed;
+    uint64_t streamed_packets;
+    PacketTimestamp first_streamed_time;
+    PacketTimestamp last_streamed_time;
+    
+    Impl() : modified(false), open(false), encrypted(false), streamed(false), streamed_packets(0) {}
+    
+    bool stream_packet(const uint8_t* data, size_t data_len, size_t original_length,
+                       const PacketTimestamp& timestamp) {
+        if (!writer) {
+            Log::error("Cannot add packet: capture was streamed to {}", file_path);
+            return false;
+        }
+        
+        if (!writer->append(data, data_len, original_length, timestamp.time_since_epoch().count())) {
+            Log::error("Failed to stream packet to {}: {}", file_path, writer->get_error());
+            return false;
+        }
+        
+        if (streamed_packets == 0) {
+            first_streamed_time = timestamp;
+        }
+        last_streamed_time = timestamp;
+        ++streamed_packets;
+        
+        return true;
+    }
+    
+    // Copy a streamed file to another path, encrypting it if requested
+    bool copy_streamed_file(const std::string& path, bool encrypt) {
+        if (path != file_path) {
+            if (encrypt) {
+                if (!SecurityManager::getInstance().encrypt_file(file_path, path)) {
+                    Log::error("Failed to encrypt capture file");
+                    return false;
+                }
+            } else {
+                std::error_code error;
+                std::filesystem::copy_file(file_path, path,
+                                           std::filesystem::copy_options::overwrite_existing, error);
+                if (error) {
+                    Log::error("Failed to copy capture file to {}: {}", path, error.message());
+                    return false;
+                }
+            }
+        }
+        
+        file_path = path;
+        encrypted = encrypt;
+        
+        Log::info("Capture file saved: {}", path);
+        return true;
+    }
     
     bool write_to_file(const std::string& path, bool encrypt) {
         // Create a temporary file for writing
@@ -70,14 +116,17 @@ struct CaptureFile::Impl {
         
         // Write packets
         for (const auto& packet : packets) {
-            // Write timestamp
-            auto timestamp = packet.timestamp.time_since_epoch().count();
+            // Write timestamp (nanoseconds since the epoch)
+            int64_t timestamp = packet.timestamp.time_since_epoch().count();
             file.write(reinterpret_cast<const char*>(&timestamp), sizeof(timestamp));
             
-            // Write packet data length
+            // Write packet data length and wire length
             uint32_t data_len = static_cast<uint32_t>(packet.data.size());
             file.write(reinterpret_cast<const char*>(&data_len), sizeof(data_len));
             
+            uint32_t original_len = static_cast<uint32_t>(packet.original_length);
+            file.write(reinterpret_cast<const char*>(&original_len), sizeof(original_len));
+            
             // Write packet data
             file.write(reinterpret_cast<const char*>(packet.data.data()), data_len);
         }
@@ -190,28 +239,52 @@ struct CaptureFile::Impl {
             user_comment.clear();
         }
         
-        // Read packets
+        // Read packets; a streamed file that was never closed runs to the end
+        bool count_known = header.packet_count != UNKNOWN_PACKET_COUNT;
+        
         packets.clear();
-        packets.reserve(header.packet_count);
+        if (count_known) {
+            packets.reserve(header.packet_count);
+        }
         
-        for (uint64_t i = 0; i < header.packet_count; ++i) {
+        for (uint64_t i = 0; !count_known || i < header.packet_count; ++i) {
             StoredPacket packet;
             
             // Read timestamp
             int64_t timestamp;
             file.read(reinterpret_cast<char*>(&timestamp), sizeof(timestamp));
-            packet.timestamp = std::chrono::system_clock::time_point(
-                std::chrono::system_clock::duration(timestamp));
             
-            // Read packet data length
+            if (!count_known && file.gcount() == 0) {
+                break;
+            }
+            
+            if (header.version <= FILE_VERSION_1_0) {
+                packet.timestamp = std::chrono::time_point_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::time_point(std::chrono::system_clock::duration(timestamp)));
+            } else {
+                packet.timestamp = PacketTimestamp(std::chrono::nanoseconds(timestamp));
+            }
+            
+            // Read packet data length, and the wire length where it is stored
             uint32_t data_len;
             file.read(reinterpret_cast<char*>(&data_len), sizeof(data_len));
             
+            uint32_t original_len = data_len;
+            if (header.version > FILE_VERSION_1_2) {
+                file.read(reinterpret_cast<char*>(&original_len), sizeof(original_len));
+            }
+            packet.original_length = std::max(data_len, original_len);
+            
             // Read packet data
             packet.data.resize(data_len);
-            file.read(reinterpret_cast<char*>(packet.data.data()), data_len);
+            file.read(reinterpret_cast<char*>(packet.data.mutable_data()), data_len);
             
             if (file.fail()) {
+                if (!count_known) {
+                    Log::warning("Capture file was not closed, last packet truncated: {}", path);
+                    break;
+                }
+                
                 Log::error("Error reading packet data at index {}", i);
                 return false;
             }
@@ -247,6 +320,8 @@ bool CaptureFile::create(const std::string& file_path, bool encrypt) {
     // Initialize new file
     pimpl_->file_path = file_path;
     pimpl_->packets.clear();
+    pimpl_->streamed = false;
+    pimpl_->streamed_packets = 0;
     pimpl_->modified = true;
     pimpl_->open = true;
     pimpl_->encrypted = encrypt;
@@ -260,6 +335,8 @@ bool CaptureFile::open(const std::string& file_path) {
     close();
     
     // Open the file
+    pimpl_->streamed = false;
+    pimpl_->streamed_packets = 0;
     return pimpl_->read_from_file(file_path);
 }
 
@@ -269,6 +346,11 @@ bool CaptureFile::save() {
         return false;
     }
     
+    // Streamed packets are on disk already; push out the buffered tail
+    if (pimpl_->writer) {
+        return pimpl_->writer->flush();
+    }
+    
     if (!pimpl_->modified) {
         Log::info("File not modified, skipping save");
         return true;
@@ -283,10 +365,17 @@ bool CaptureFile::save_as(const std::string& file_path, bool encrypt) {
         return false;
     }
     
+    if (pimpl_->streamed) {
+        return stop_streaming() && pimpl_->copy_streamed_file(file_path, encrypt);
+    }
+    
     return pimpl_->write_to_file(file_path, encrypt);
 }
 
 void CaptureFile::close() {
+    // Nothing is lost by closing a stream: it only completes the file
+    stop_streaming();
+    
     if (pimpl_->open && pimpl_->modified) {
         Log::warning("Closing modified capture file without saving: {}", pimpl_->file_path);
     }
@@ -295,6 +384,60 @@ void CaptureFile::close() {
     pimpl_->modified = false;
 }
 
+bool CaptureFile::start_streaming(const CaptureWriterOptions& options) {
+    if (!pimpl_->open) {
+        Log::error("Cannot stream: no file is open");
+        return false;
+    }
+    
+    if (pimpl_->streamed || pimpl_->encrypted) {
+        Log::error("Cannot stream to {}: file is already streamed or encrypted", pimpl_->file_path);
+        return false;
+    }
+    
+    auto writer = std::make_unique<CaptureWriter>();
+    if (!writer->open(pimpl_->file_path, pimpl_->device_name, pimpl_->user_comment, options)) {
+        return false;
+    }
+    
+    pimpl_->writer = std::move(writer);
+    pimpl_->streamed = true;
+    pimpl_->streamed_packets = 0;
+    
+    // Packets added before streaming started go first
+    std::vector<StoredPacket> held = std::move(pimpl_->packets);
+    pimpl_->packets.clear();
+    
+    for (const auto& packet : held) {
+        if (!pimpl_->stream_packet(packet.data.data(), packet.data.size(), packet.original_length,
+                                   packet.timestamp)) {
+            return false;
+        }
+    }
+    
+    pimpl_->modified = false;
+    return true;
+}
+
+bool CaptureFile::stop_streaming() {
+    if (!pimpl_->writer) {
+        return true;
+    }
+    
+    bool closed = pimpl_->writer->close();
+    pimpl_->writer.reset();
+    
+    return closed;
+}
+
+bool CaptureFile::is_streaming() const {
+    return pimpl_->writer != nullptr;
+}
+
+bool CaptureFile::is_streamed() const {
+    return pimpl_->streamed;
+}
+
 bool CaptureFile::add_packet(const uint8_t* data, size_t data_len,
                            const std::chrono::system_clock::time_point& timestamp) {
     if (!pimpl_->open) {
@@ -302,9 +445,38 @@ bool CaptureFile::add_packet(const uint8_t* data, size_t data_len,
         return false;
     }
     
+    if (pimpl_->streamed) {
+        return pimpl_->stream_packet(data, data_len, data_len,
+                                     std::chrono::time_point_cast<std::chrono::nanoseconds>(timestamp));
+    }
+    
+    StoredPacket packet;
+    packet.timestamp = timestamp;
+    packet.data = PacketBufferPool::default_pool().copy(data, data_len);
+    packet.original_length = data_len;
+    
+    pimpl_->packets.push_back(std::move(packet));
+    pimpl_->modified = true;
+    
+    return true;
+}
+
+bool CaptureFile::add_packet(const PacketBuffer& data, const PacketTimestamp& timestamp, size_t original_length) {
+    if (!pimpl_->open) {
+        Log::error("Cannot add packet: no file is open");
+        return false;
+    }
+    
+    original_length = std::max(original_length, data.size());
+    
+    if (pimpl_->streamed) {
+        return pimpl_->stream_packet(data.data(), data.size(), original_length, timestamp);
+    }
+    
     StoredPacket packet;
     packet.timestamp = timestamp;
-    packet.data.assign(data, data + data_len);
+    packet.data = data;
+    packet.original_length = original_length;
     
     pimpl_->packets.push_back(std::move(packet));
     pimpl_->modified = true;
@@ -313,6 +485,10 @@ bool CaptureFile::add_packet(const uint8_t* data, size_t data_len,
 }
 
 size_t CaptureFile::get_packet_count() const {
+    if (pimpl_->streamed) {
+        return static_cast<size_t>(pimpl_->streamed_packets);
+    }
+    
     return pimpl_->packets.size();
 }
 
@@ -322,9 +498,28 @@ bool CaptureFile::get_packet(size_t index, std::vector<uint8_t>& data,
         return false;
     }
     
+    const auto& packet = pimpl_->packets[index];
+    data.assign(packet.data.begin(), packet.data.end());
+    timestamp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(packet.timestamp);
+    
+    return true;
+}
+
+bool CaptureFile::get_packet(size_t index, PacketBuffer& data, PacketTimestamp& timestamp) const {
+    size_t original_length;
+    return get_packet(index, data, timestamp, original_length);
+}
+
+bool CaptureFile::get_packet(size_t index, PacketBuffer& data, PacketTimestamp& timestamp,
+                             size_t& original_length) const {
+    if (index >= pimpl_->packets.size()) {
+        return false;
+    }
+    
     const auto& packet = pimpl_->packets[index];
     data = packet.data;
     timestamp = packet.timestamp;
+    original_length = packet.original_length;
     
     return true;
 }
@@ -352,10 +547,25 @@ CaptureFileStats CaptureFile::get_stats() const {
     stats.device_name = pimpl_->device_name;
     stats.encrypted = pimpl_->encrypted;
     
+    if (pimpl_->streamed) {
+        stats.packet_count = static_cast<size_t>(pimpl_->streamed_packets);
+        stats.first_packet_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            pimpl_->first_streamed_time);
+        stats.last_packet_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            pimpl_->last_streamed_time);
+        
+        std::error_code error;
+        stats.file_size = pimpl_->writer ? static_cast<size_t>(pimpl_->writer->get_size())
+                                         : static_cast<size_t>(std::filesystem::file_size(pimpl_->file_path, error));
+        return stats;
+    }
+    
     // Calculate first and last packet times
     if (!pimpl_->packets.empty()) {
-        stats.first_packet_time = pimpl_->packets.front().timestamp;
-        stats.last_packet_time = pimpl_->packets.back().timestamp;
+        stats.first_packet_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            pimpl_->packets.front().timestamp);
+        stats.last_packet_time = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            pimpl_->packets.back().timestamp);
         
         // Calculate file size (estimate)
         for (const auto& packet : pimpl_->packets) {
@@ -6,9 +6,20 @@
 #include <chrono>
 #include <memory>
 #include <cstdint>
+#include "../common/packet_buffer.h"
+#include "capture_writer.h"
 
 namespace wireshark_mcp {
 
+// Packet time kept at nanosecond resolution whatever the platform's
+// system_clock tick is
+using PacketTimestamp = std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>;
+
+// Convert a capture timestamp (nanoseconds since the Unix epoch)
+inline PacketTimestamp packet_timestamp_from_ns(uint64_t timestamp_ns) {
+    return PacketTimestamp(std::chrono::nanoseconds(timestamp_ns));
+}
+
 struct CaptureFileStats {
     size_t packet_count;
     size_t file_size;
@@ -30,14 +41,44 @@ public:
     bool save_as(const std::string& file_path, bool encrypt = false);
     void close();
     
+    // Streaming mode: from now on packets are appended to the file on disk
+    // by a writer thread instead of being held in memory, so a capture is
+    // bounded by disk space and survives a crash up to the last flush. Set
+    // the device name and comment first; they go into the file header.
+    // Streamed packets cannot be read back through get_packet(); reopen the
+    // file once streaming has stopped.
+    bool start_streaming(const CaptureWriterOptions& options = CaptureWriterOptions());
+    
+    // Complete the file on disk (also done by close() and save_as())
+    bool stop_streaming();
+    
+    bool is_streaming() const;
+    
+    // Packets went to disk; stays set after stop_streaming() until another
+    // file is created or opened
+    bool is_streamed() const;
+    
     // Packet operations
     bool add_packet(const uint8_t* data, size_t data_len, 
                   const std::chrono::system_clock::time_point& timestamp);
     
+    // Store a captured buffer without copying it. original_length is the
+    // frame's length on the wire when the snaplen or slicing cut it short
+    // (0 = the buffer is the whole frame).
+    bool add_packet(const PacketBuffer& data, const PacketTimestamp& timestamp, size_t original_length = 0);
+    
     size_t get_packet_count() const;
     bool get_packet(size_t index, std::vector<uint8_t>& data, 
                   std::chrono::system_clock::time_point& timestamp) const;
     
+    // Share a stored buffer without copying it, with the full-resolution time
+    bool get_packet(size_t index, PacketBuffer& data, PacketTimestamp& timestamp) const;
+    
+    // Same, plus the frame's length on the wire (the stored length for files
+    // written before format 1.3)
+    bool get_packet(size_t index, PacketBuffer& data, PacketTimestamp& timestamp,
+                    size_t& original_length) const;
+    
     // File info
     bool is_open() const;
     bool is_modified() const;
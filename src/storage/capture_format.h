@@ -0,0 +1,36 @@
+#ifndef WIRESHARK_MCP_CAPTURE_FORMAT_H
+#define WIRESHARK_MCP_CAPTURE_FORMAT_H
+
+#include <cstdint>
+
+namespace wireshark_mcp {
+
+// On-disk layout of .wcap files, shared by CaptureFile and CaptureWriter.
+//
+// A file is a FileHeader, the device name and user comment (each a uint32
+// length followed by the bytes), then one record per packet: an int64
+// timestamp in nanoseconds, the uint32 stored length, the uint32 length the
+// frame had on the wire (missing before version 1.3) and the stored bytes.
+
+// File format constants
+constexpr uint32_t FILE_MAGIC = 0x57534D43; // "WSMC" in hex
+constexpr uint16_t FILE_VERSION = 0x0103;    // Version 1.3: records carry the wire length
+constexpr uint16_t FILE_VERSION_1_2 = 0x0102; // Version 1.2: packet count may be unknown
+constexpr uint16_t FILE_VERSION_1_0 = 0x0100; // Version 1.0: timestamps in system_clock ticks
+
+// Packet count of a streamed file that was never closed (e.g. after a
+// crash): records run to the end of the file, the last one possibly cut short
+constexpr uint64_t UNKNOWN_PACKET_COUNT = UINT64_MAX;
+
+// File header structure
+struct FileHeader {
+    uint32_t magic;         // Magic number for file identification
+    uint16_t version;       // File format version
+    uint16_t flags;         // Flags (encrypted, compressed, etc.)
+    uint64_t packet_count;  // Number of packets in the file
+    uint64_t reserved;      // Reserved for future use
+};
+
+} // namespace wireshark_mcp
+
+#endif // WIRESHARK_MCP_CAPTURE_FORMAT_H
@@ -0,0 +1,462 @@
+#include "capture_writer.h"
+#include "capture_format.h"
+#include "../common/config.h"
+#include "../common/cpu_affinity.h"
+#include "../common/logging.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace wireshark_mcp {
+
+namespace {
+
+// Buffer alignment, and the block size O_DIRECT transfers are rounded to
+constexpr size_t IO_ALIGNMENT = 4096;
+
+constexpr size_t MIN_BUFFER_SIZE = 16 * IO_ALIGNMENT;
+
+// Thin file layer over POSIX and the Windows CRT. The CRT has no pwrite,
+// but each descriptor is written by one thread at a time, so a seek followed
+// by a write is equivalent there.
+#ifdef _WIN32
+int open_file(const std::string& path, bool truncate, bool direct) {
+    (void)direct;
+    int flags = _O_WRONLY | _O_BINARY | _O_NOINHERIT | (truncate ? _O_CREAT | _O_TRUNC : 0);
+    return ::_open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+}
+
+long long write_at(int fd, const uint8_t* data, size_t length, uint64_t offset) {
+    if (::_lseeki64(fd, static_cast<long long>(offset), SEEK_SET) < 0) {
+        return -1;
+    }
+    return ::_write(fd, data, static_cast<unsigned int>(std::min<size_t>(length, 1u << 30)));
+}
+
+bool truncate_file(int fd, uint64_t size) {
+    return ::_chsize_s(fd, static_cast<long long>(size)) == 0;
+}
+
+bool sync_file(int fd) {
+    return ::_commit(fd) == 0;
+}
+
+void close_file(int fd) {
+    ::_close(fd);
+}
+#else
+int open_file(const std::string& path, bool truncate, bool direct) {
+    int flags = O_WRONLY | O_CLOEXEC | (truncate ? O_CREAT | O_TRUNC : 0);
+#ifdef O_DIRECT
+    if (direct) {
+        flags |= O_DIRECT;
+    }
+#else
+    (void)direct;
+#endif
+    return ::open(path.c_str(), flags, 0600);
+}
+
+long long write_at(int fd, const uint8_t* data, size_t length, uint64_t offset) {
+    return ::pwrite(fd, data, length, static_cast<off_t>(offset));
+}
+
+bool truncate_file(int fd, uint64_t size) {
+    return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+}
+
+bool sync_file(int fd) {
+    return ::fsync(fd) == 0;
+}
+
+void close_file(int fd) {
+    ::close(fd);
+}
+#endif
+
+bool write_fully(int fd, const uint8_t* data, size_t length, uint64_t offset, std::string& error) {
+    while (length > 0) {
+        long long written = write_at(fd, data, length, offset);
+        
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = std::string("Write failed: ") + std::strerror(errno);
+            return false;
+        }
+        
+        data += written;
+        length -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    
+    return true;
+}
+
+} // namespace
+
+CaptureWriterOptions capture_writer_options_from_config(const Config& config) {
+    CaptureWriterOptions options;
+    
+    options.buffer_size = static_cast<size_t>(config.get<int>(
+        "storage.writer_buffer_size", static_cast<int>(options.buffer_size)));
+    options.direct_io = config.get<bool>("storage.direct_io", options.direct_io);
+    options.flush_interval_ms = config.get<int>("storage.flush_interval_ms", options.flush_interval_ms);
+    options.cpu_affinity = config.get<std::string>("storage.writer_cpu_affinity", "");
+    
+    return options;
+}
+
+CaptureWriter::CaptureWriter()
+    : m_fd(-1),
+      m_open(false),
+      m_direct(false),
+      m_alignment(1),
+      m_buffers{nullptr, nullptr},
+      m_capacity(0),
+      m_active(0),
+      m_active_length(0),
+      m_file_offset(0),
+      m_packet_count(0),
+      m_stalls(0),
+      m_pending(-1),
+      m_pending_length(0),
+      m_pending_offset(0),
+      m_stop(false),
+      m_failed(false) {
+}
+
+CaptureWriter::~CaptureWriter() {
+    close();
+}
+
+bool CaptureWriter::open(const std::string& path, const std::string& device_name,
+                         const std::string& user_comment, const CaptureWriterOptions& options) {
+    close();
+    
+    m_path = path;
+    m_options = options;
+    m_direct = false;
+    m_error_message.clear();
+    m_failed = false;
+    m_stop = false;
+    
+    if (options.direct_io) {
+#ifdef O_DIRECT
+        m_fd = open_file(path, true, true);
+        m_direct = m_fd >= 0;
+        
+        // tmpfs and some network file systems refuse O_DIRECT
+        if (m_fd < 0 && errno == EINVAL) {
+            Log::warning("Direct I/O not supported for {}, writing through the page cache", path);
+        }
+#else
+        Log::warning("Direct I/O not available on this platform, writing through the page cache");
+#endif
+    }
+    
+    if (!m_direct) {
+        m_fd = open_file(path, true, false);
+    }
+    
+    if (m_fd < 0) {
+        m_error_message = "Failed to create capture file " + path + ": " + std::strerror(errno);
+        Log::error(m_error_message);
+        return false;
+    }
+    
+    // "numa" places the writer next to the (first) capture NIC
+    std::string placement_error;
+    if (!resolve_cpu_set(options.cpu_affinity, device_name.substr(0, device_name.find(',')),
+                         m_cpus, placement_error)) {
+        Log::warning("Capture writer thread left unpinned: {}", placement_error);
+        m_cpus.clear();
+    }
+    
+    m_alignment = m_direct ? IO_ALIGNMENT : 1;
+    m_capacity = std::max(options.buffer_size, MIN_BUFFER_SIZE);
+    m_capacity = (m_capacity + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+    
+    for (auto& buffer : m_buffers) {
+        buffer = static_cast<uint8_t*>(::operator new(m_capacity, std::align_val_t(IO_ALIGNMENT)));
+    }
+    
+    m_active = 0;
+    m_active_length = 0;
+    m_file_offset = 0;
+    m_packet_count = 0;
+    m_stalls = 0;
+    m_pending = -1;
+    m_last_hand_off = std::chrono::steady_clock::now();
+    m_open = true;
+    
+    m_thread = std::thread(&CaptureWriter::writer_thread_main, this);
+    
+    // Header with an unknown count until close() patches it
+    FileHeader header;
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.flags = 0x0000;
+    header.packet_count = UNKNOWN_PACKET_COUNT;
+    header.reserved = 0;
+    
+    uint32_t device_name_len = static_cast<uint32_t>(device_name.length());
+    uint32_t comment_len = static_cast<uint32_t>(user_comment.length());
+    
+    write_bytes(&header, sizeof(header));
+    write_bytes(&device_name_len, sizeof(device_name_len));
+    write_bytes(device_name.data(), device_name.length());
+    write_bytes(&comment_len, sizeof(comment_len));
+    write_bytes(user_comment.data(), user_comment.length());
+    
+    Log::info("Streaming capture to {} ({} byte buffers{})", path, m_capacity,
+              m_direct ? ", direct I/O" : "");
+    return true;
+}
+
+bool CaptureWriter::append(const uint8_t* data, size_t length, size_t original_length,
+                           int64_t timestamp_ns) {
+    if (!m_open) {
+        return false;
+    }
+    
+    uint32_t data_len = static_cast<uint32_t>(length);
+    uint32_t original_len = static_cast<uint32_t>(std::max(length, original_length));
+    
+    if (!write_bytes(&timestamp_ns, sizeof(timestamp_ns)) ||
+        !write_bytes(&data_len, sizeof(data_len)) ||
+        !write_bytes(&original_len, sizeof(original_len)) ||
+        !write_bytes(data, length)) {
+        return false;
+    }
+    
+    ++m_packet_count;
+    
+    // Bound what a crash can lose on a slow trickle of packets
+    if (m_options.flush_interval_ms > 0 &&
+        std::chrono::steady_clock::now() - m_last_hand_off >=
+            std::chrono::milliseconds(m_options.flush_interval_ms)) {
+        return hand_off();
+    }
+    
+    return true;
+}
+
+bool CaptureWriter::flush() {
+    if (!m_open) {
+        return false;
+    }
+    
+    if (!hand_off() || !wait_idle()) {
+        return false;
+    }
+    
+    // With direct I/O the partial last block is still in memory: write it
+    // padded and cut the file back. Later hand-offs rewrite that block.
+    if (m_active_length == 0 || m_alignment == 1) {
+        return true;
+    }
+    
+    size_t padded = (m_active_length + m_alignment - 1) / m_alignment * m_alignment;
+    std::memset(m_buffers[m_active] + m_active_length, 0, padded - m_active_length);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = m_active;
+        m_pending_length = padded;
+        m_pending_offset = m_file_offset;
+    }
+    m_work.notify_one();
+    
+    if (!wait_idle()) {
+        return false;
+    }
+    
+    if (!truncate_file(m_fd, get_size())) {
+        return set_error(std::string("Failed to truncate capture file: ") + std::strerror(errno));
+    }
+    return true;
+}
+
+bool CaptureWriter::close() {
+    if (!m_open) {
+        return true;
+    }
+    
+    // Pad the last block for direct I/O; the file is truncated back below
+    uint64_t file_size = get_size();
+    size_t padded = (m_active_length + m_alignment - 1) / m_alignment * m_alignment;
+    std::memset(m_buffers[m_active] + m_active_length, 0, padded - m_active_length);
+    m_active_length = padded;
+    
+    bool ok = hand_off() && wait_idle();
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_work.notify_one();
+    m_thread.join();
+    
+    close_file(m_fd);
+    m_fd = -1;
+    m_open = false;
+    
+    for (auto& buffer : m_buffers) {
+        ::operator delete(buffer, std::align_val_t(IO_ALIGNMENT));
+        buffer = nullptr;
+    }
+    
+    // Patch the header through the page cache: it is neither block sized
+    // nor block aligned
+    if (!ok) {
+        Log::error("Capture file {} is incomplete: {}", m_path, get_error());
+        return false;
+    }
+    
+    int fd = open_file(m_path, false, false);
+    if (fd < 0) {
+        set_error(std::string("Failed to reopen capture file: ") + std::strerror(errno));
+        Log::error("Capture file {} left without a packet count", m_path);
+        return false;
+    }
+    
+    FileHeader header;
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.flags = 0x0000;
+    header.packet_count = m_packet_count;
+    header.reserved = 0;
+    
+    std::string error;
+    ok = truncate_file(fd, file_size) &&
+         write_fully(fd, reinterpret_cast<const uint8_t*>(&header), sizeof(header), 0, error) &&
+         sync_file(fd);
+    close_file(fd);
+    
+    if (!ok) {
+        Log::error("Failed to finalize capture file {}", m_path);
+        return false;
+    }
+    
+    Log::info("Capture file closed with {} packets ({} stalls): {}", m_packet_count, m_stalls, m_path);
+    return true;
+}
+
+std::string CaptureWriter::get_error() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error_message;
+}
+
+bool CaptureWriter::write_bytes(const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    
+    while (length > 0) {
+        size_t chunk = std::min(length, m_capacity - m_active_length);
+        std::memcpy(m_buffers[m_active] + m_active_length, bytes, chunk);
+        m_active_length += chunk;
+        bytes += chunk;
+        length -= chunk;
+        
+        if (m_active_length == m_capacity && !hand_off()) {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool CaptureWriter::hand_off() {
+    m_last_hand_off = std::chrono::steady_clock::now();
+    
+    size_t aligned = m_active_length / m_alignment * m_alignment;
+    if (aligned == 0) {
+        return true;
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    if (m_pending >= 0) {
+        ++m_stalls;
+        m_idle.wait(lock, [this] { return m_pending < 0; });
+    }
+    
+    if (m_failed) {
+        return false;
+    }
+    
+    // The other buffer is free now; it starts with the unaligned tail
+    int next = 1 - m_active;
+    size_t tail = m_active_length - aligned;
+    std::memcpy(m_buffers[next], m_buffers[m_active] + aligned, tail);
+    
+    m_pending = m_active;
+    m_pending_length = aligned;
+    m_pending_offset = m_file_offset;
+    lock.unlock();
+    m_work.notify_one();
+    
+    m_file_offset += aligned;
+    m_active = next;
+    m_active_length = tail;
+    return true;
+}
+
+bool CaptureWriter::wait_idle() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_pending < 0; });
+    return !m_failed;
+}
+
+bool CaptureWriter::set_error(const std::string& message) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failed = true;
+    m_error_message = message;
+    return false;
+}
+
+void CaptureWriter::writer_thread_main() {
+    std::string error;
+    if (!pin_current_thread(m_cpus, error)) {
+        Log::warning("Capture writer thread left unpinned: {}", error);
+    }
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
+    
+    while (true) {
+        m_work.wait(lock, [this] { return m_pending >= 0 || m_stop; });
+        
+        if (m_pending < 0) {
+            break;
+        }
+        
+        const uint8_t* data = m_buffers[m_pending];
+        size_t length = m_pending_length;
+        uint64_t offset = m_pending_offset;
+        bool failed = m_failed;
+        lock.unlock();
+        
+        // After a failure the remaining buffers are dropped
+        if (!failed && !write_fully(m_fd, data, length, offset, error)) {
+            Log::error("Capture writer for {}: {}", m_path, error);
+            set_error(error);
+        }
+        
+        lock.lock();
+        m_pending = -1;
+        m_idle.notify_all();
+    }
+}
+
+} // namespace wireshark_mcp
@@ -0,0 +1,122 @@
+#ifndef WIRESHARK_MCP_CAPTURE_WRITER_H
+#define WIRESHARK_MCP_CAPTURE_WRITER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+namespace wireshark_mcp {
+
+class Config;
+
+struct CaptureWriterOptions {
+    size_t buffer_size = 4 * 1024 * 1024;   // Per buffer (two are used), rounded to 4 KiB
+    bool direct_io = false;                  // O_DIRECT: bypass the page cache where supported
+    int flush_interval_ms = 1000;            // Push a partly filled buffer to disk this often
+                                             // (whole blocks only with direct_io, see flush())
+    std::string cpu_affinity;                // Writer thread CPUs, as for capture.cpu_affinity
+};
+
+// Build writer options from the storage.* configuration keys
+CaptureWriterOptions capture_writer_options_from_config(const Config& config);
+
+// Appends packets to a .wcap file from a dedicated I/O thread.
+//
+// Records are serialized into one of two large page-aligned buffers; a full
+// buffer is handed to the writer thread while the other one fills, so the
+// caller only blocks when the disk falls a whole buffer behind. The header
+// is written with an unknown packet count and patched on close(), so a file
+// cut short by a crash still reads back up to its last complete record.
+//
+// With direct_io appends only write whole 4 KiB blocks; flush() and close()
+// pad the last partial block and truncate the file back.
+class CaptureWriter {
+public:
+    CaptureWriter();
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    // Create (or truncate) the file, write the header and start the thread
+    bool open(const std::string& path, const std::string& device_name,
+              const std::string& user_comment, const CaptureWriterOptions& options);
+
+    // Append one record; original_length is the frame's length on the wire,
+    // larger than length when the snaplen or slicing cut it
+    bool append(const uint8_t* data, size_t length, size_t original_length, int64_t timestamp_ns);
+
+    // Write everything appended so far and wait until it has reached the
+    // file. The interval check in append() only hands off whole blocks with
+    // direct_io; flush() also writes the partial last block.
+    bool flush();
+
+    // Write the rest, patch the header and close the file
+    bool close();
+
+    bool is_open() const { return m_open; }
+    std::string get_path() const { return m_path; }
+
+    uint64_t get_packet_count() const { return m_packet_count; }
+
+    // Size the file has once closed
+    uint64_t get_size() const { return m_file_offset + m_active_length; }
+
+    // Times the caller had to wait for the disk
+    uint64_t get_stalls() const { return m_stalls; }
+
+    std::string get_error() const;
+
+private:
+    // Copy bytes into the active buffer, handing it off whenever it fills
+    bool write_bytes(const void* data, size_t length);
+
+    // Pass the aligned part of the active buffer to the writer thread and
+    // carry the rest over into the other buffer
+    bool hand_off();
+
+    // Block until the writer thread has no buffer in flight
+    bool wait_idle();
+
+    bool set_error(const std::string& message);
+
+    void writer_thread_main();
+
+    std::string m_path;
+    CaptureWriterOptions m_options;
+    std::vector<int> m_cpus;    // Writer thread placement
+    int m_fd;
+    bool m_open;
+    bool m_direct;
+    size_t m_alignment;         // Write granularity: 4 KiB with direct_io, else 1
+
+    uint8_t* m_buffers[2];
+    size_t m_capacity;
+    int m_active;
+    size_t m_active_length;
+    uint64_t m_file_offset;     // File position of the active buffer
+
+    uint64_t m_packet_count;
+    uint64_t m_stalls;
+    std::chrono::steady_clock::time_point m_last_hand_off;
+
+    // Hand-off to the writer thread
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work;
+    std::condition_variable m_idle;
+    int m_pending;              // Buffer being written, -1 for none
+    size_t m_pending_length;
+    uint64_t m_pending_offset;
+    bool m_stop;
+    bool m_failed;
+    std::string m_error_message;
+    std::thread m_thread;
+};
+
+} // namespace wireshark_mcp
+
+#endif // WIRESHARK_MCP_CAPTURE_WRITER_H
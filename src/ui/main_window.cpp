@@ -1,7 +1,10 @@
 #include "main_window.h"
 #include "../capture/packet_capture.h"
+#include "../capture/multi_capture.h"
 #include "../security/auth_manager.h"
 #include "../storage/capture_file.h"
+#include "../analysis/parallel_analyzer.h"
+#include "../analysis/flow_table.h"
 #include "../common/logging.h"
 #include "../common/config.h"
 
@@ -25,12 +28,46 @@
 #include <QHBoxLayout>
 #include <QSplitter>
 #include <QDateTime>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <map>
+#include <algorithm>
 
 namespace wireshark_mcp {
 
+namespace {
+
+// Packets moved into the capture file per read while draining
+constexpr size_t CAPTURE_DRAIN_BATCH = 1024;
+
+// Drain interval when the engine has no selectable descriptor
+constexpr int CAPTURE_POLL_INTERVAL_MS = 20;
+
+// Conversations shown in the conversation list, largest first
+constexpr size_t CONVERSATION_LIST_LIMIT = 100;
+
+constexpr uint8_t TCP_FLAG_SYN = 0x02;
+constexpr uint8_t TCP_FLAG_ACK = 0x10;
+
+QString transportName(uint8_t ip_protocol) {
+    switch (ip_protocol) {
+        case 1: return "ICMP";
+        case 6: return "TCP";
+        case 17: return "UDP";
+        case 58: return "ICMPv6";
+        case 132: return "SCTP";
+        default: return QString("IP protocol %1").arg(static_cast<int>(ip_protocol));
+    }
+}
+
+} // namespace
+
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
       isCapturing(false),
+      isMultiDeviceCapture(false),
       hasUnsavedChanges(false) {
     
     // Initialize auth manager
@@ -58,9 +95,14 @@ MainWindow::MainWindow(QWidget* parent)
 }
 
 MainWindow::~MainWindow() {
-    // Clean up
+    // Clean up without going through onCaptureStopped, which prompts
+    captureEngine->setStopCallback(nullptr);
     if (isCapturing) {
-        captureEngine->stop_capture();
+        if (isMultiDeviceCapture) {
+            multiCaptureEngine->stop_capture();
+        } else {
+            captureEngine->stop_capture();
+        }
     }
 }
 
@@ -125,6 +167,12 @@ void MainWindow::setupUi() {
 void MainWindow::initialize_components() {
     // Create capture engine
     captureEngine = std::make_shared<PacketCapture>();
+    multiCaptureEngine = std::make_shared<MultiCapture>();
+    
+    captureNotifier = nullptr;
+    capturePollTimer = new QTimer(this);
+    capturePollTimer->setInterval(CAPTURE_POLL_INTERVAL_MS);
+    connect(capturePollTimer, &QTimer::timeout, this, &MainWindow::drainCapturedPackets);
     
     // Connect capture signals (would use signals/slots in real Qt implementation)
     captureEngine->setStartCallback([this]() { onCaptureStarted(); });
@@ -244,13 +292,20 @@ void MainWindow::createToolBars() {
 void MainWindow::createStatusBar() {
     // Create status bar labels
     QLabel* captureStatusLabel = new QLabel("Ready");
-    QLabel* packetCountLabel = new QLabel("Packets: 0");
-    QLabel* deviceLabel = new QLabel("No device selected");
+    packetCountLabel = new QLabel("Packets: 0");
+    captureStatsLabel = new QLabel();
+    deviceLabel = new QLabel("No device selected");
     
     // Add to status bar
     statusBar()->addWidget(captureStatusLabel, 1);
     statusBar()->addPermanentWidget(packetCountLabel);
+    statusBar()->addPermanentWidget(captureStatsLabel);
     statusBar()->addPermanentWidget(deviceLabel);
+    
+    // Capture statistics are polled while a capture is running
+    captureStatsTimer = new QTimer(this);
+    captureStatsTimer->setInterval(1000);
+    connect(captureStatsTimer, &QTimer::timeout, this, &MainWindow::updateCaptureStats);
 }
 
 // Slot implementations
@@ -272,15 +327,27 @@ void MainWindow::on_startCapture_clicked() {
     }
     
     // In a real implementation, show a device selection dialog
-    // For demo, we'll just use a predefined device
-    std::string device = "eth0";
+    // For demo, we'll use the configured device list (e.g. "eth0, eth1")
+    std::vector<std::string> devices = parse_device_list(
+        Config::getInstance().get<std::string>("capture.default_device", "eth0"));
+    if (devices.empty()) {
+        devices.push_back("eth0");
+    }
     
-    CaptureOptions options;
-    options.promiscuous_mode = true;
-    options.buffer_size = 1024 * 1024; // 1MB
+    std::string device = devices.front();
+    for (size_t i = 1; i < devices.size(); ++i) {
+        device += "," + devices[i];
+    }
+    
+    CaptureOptions options = capture_options_from_config(Config::getInstance());
+    
+    // Several devices are captured together and merged into one stream
+    isMultiDeviceCapture = devices.size() > 1;
     
     // Initialize device
-    if (!captureEngine->initialize_device(device, options)) {
+    bool initialized = isMultiDeviceCapture ? multiCaptureEngine->initialize(devices, options)
+                                            : captureEngine->initialize_device(device, options);
+    if (!initialized) {
         QMessageBox::critical(this, "Error", 
                              QString("Failed to initialize capture device: %1").arg(device.c_str()));
         return;
@@ -310,16 +377,44 @@ void MainWindow::on_startCapture_clicked() {
     currentCaptureFile->create(temp_file);
     currentCaptureFile->set_device_name(device);
     
+    // Long captures go straight to disk instead of being held in memory
+    auto& config = Config::getInstance();
+    if (config.get<bool>("storage.streaming", false) &&
+        !currentCaptureFile->start_streaming(capture_writer_options_from_config(config))) {
+        Log::warning("Could not stream capture to {}, keeping packets in memory", temp_file);
+    }
+    
     // Start the capture
-    if (!captureEngine->start_capture()) {
+    bool started = isMultiDeviceCapture ? multiCaptureEngine->start_capture()
+                                        : captureEngine->start_capture();
+    if (!started) {
         QMessageBox::critical(this, "Error", "Failed to start packet capture");
         return;
     }
+    
+    // The single-device engine reports the start through its callback
+    if (isMultiDeviceCapture) {
+        onCaptureStarted();
+    }
 }
 
 void MainWindow::on_stopCapture_clicked() {
     if (isCapturing) {
+        stopActiveCapture();
+    }
+}
+
+void MainWindow::stopActiveCapture() {
+    if (isMultiDeviceCapture) {
+        multiCaptureEngine->stop_capture();
+        onCaptureStopped();
+    } else {
         captureEngine->stop_capture();
+        
+        // A file source that reached its end has no capture left to stop
+        if (isCapturing) {
+            onCaptureStopped();
+        }
     }
 }
 
@@ -331,6 +426,24 @@ void MainWindow::onCaptureStarted() {
     startCaptureAction->setEnabled(false);
     stopCaptureAction->setEnabled(true);
     
+    // Reset the rate baseline and start polling statistics
+    if (isMultiDeviceCapture) {
+        multiCaptureEngine->get_stats();
+    } else {
+        captureEngine->get_stats();
+    }
+    captureStatsLabel->clear();
+    captureStatsTimer->start();
+    
+    // Sleep until packets arrive instead of polling on a timer
+    int fd = isMultiDeviceCapture ? -1 : captureEngine->get_selectable_fd();
+    if (fd >= 0) {
+        captureNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(captureNotifier, &QSocketNotifier::activated, this, &MainWindow::drainCapturedPackets);
+    } else {
+        capturePollTimer->start();
+    }
+    
     // Create a new packet list tab
     QTableView* packetListView = new QTableView();
     // In a real implementation, set up the table model here
@@ -346,6 +459,26 @@ void MainWindow::onCaptureStopped() {
     isCapturing = false;
     statusBar()->showMessage("Capture stopped");
     
+    // The descriptor is closed once the engine has stopped
+    if (captureNotifier) {
+        captureNotifier->setEnabled(false);
+        captureNotifier->deleteLater();
+        captureNotifier = nullptr;
+    }
+    capturePollTimer->stop();
+    
+    // Pick up whatever was still queued
+    drainCapturedPackets();
+    
+    // Leave the final figures on display
+    captureStatsTimer->stop();
+    updateCaptureStats();
+    
+    // Complete a streamed file before it can be saved elsewhere
+    if (currentCaptureFile->is_streaming() && !currentCaptureFile->stop_streaming()) {
+        QMessageBox::warning(this, "Warning", "The streamed capture file could not be completed");
+    }
+    
     // Update UI state
     startCaptureAction->setEnabled(true);
     stopCaptureAction->setEnabled(false);
@@ -367,10 +500,7 @@ void MainWindow::onCaptureStopped() {
 void MainWindow::onPacketCaptured() {
     // Update packet count in status bar
     size_t count = currentCaptureFile->get_packet_count();
-    QLabel* packetCountLabel = qobject_cast<QLabel*>(statusBar()->children().at(1));
-    if (packetCountLabel) {
-        packetCountLabel->setText(QString("Packets: %1").arg(count));
-    }
+    packetCountLabel->setText(QString("Packets: %1").arg(count));
     
     // Update the current packet list view
     // In a real implementation, update the table model here
@@ -378,6 +508,71 @@ void MainWindow::onPacketCaptured() {
     hasUnsavedChanges = true;
 }
 
+void MainWindow::drainCapturedPackets() {
+    size_t count = 0;
+    size_t total = 0;
+    
+    // Read everything that is waiting; the engine wakes us again for more
+    do {
+        count = isMultiDeviceCapture ? multiCaptureEngine->get_next_packets(captureBatch, CAPTURE_DRAIN_BATCH)
+                                     : captureEngine->get_next_packets(captureBatch, CAPTURE_DRAIN_BATCH);
+        
+        for (size_t i = 0; i < count; ++i) {
+            currentCaptureFile->add_packet(captureBatch[i].data,
+                                           packet_timestamp_from_ns(captureBatch[i].timestamp),
+                                           captureBatch[i].actual_length);
+        }
+        
+        total += count;
+    } while (count == CAPTURE_DRAIN_BATCH);
+    
+    // The single-device engine reports packets through its callback
+    if (isMultiDeviceCapture && total > 0) {
+        onPacketCaptured();
+    }
+    
+    // The source can end by itself, e.g. a replayed file
+    bool active = isMultiDeviceCapture ? multiCaptureEngine->is_capturing()
+                                       : captureEngine->is_capturing();
+    if (isCapturing && !active) {
+        stopActiveCapture();
+    }
+}
+
+void MainWindow::updateCaptureStats() {
+    CaptureStats stats = isMultiDeviceCapture ? multiCaptureEngine->get_stats()
+                                              : captureEngine->get_stats();
+    
+    QString text = QString("Dropped: %1 | %2 pkt/s | %3 Mbit/s")
+                       .arg(stats.kernel_dropped + stats.interface_dropped + stats.queue_dropped)
+                       .arg(stats.packets_per_second, 0, 'f', 0)
+                       .arg(stats.bytes_per_second * 8.0 / 1e6, 0, 'f', 2);
+    
+    if (isMultiDeviceCapture || captureEngine->get_options().use_capture_thread) {
+        text += QString(" | Queue: %1 (max %2)").arg(stats.queue_depth).arg(stats.queue_high_water);
+    }
+    
+    if (stats.duplicates_dropped > 0) {
+        text += QString(" | Duplicates: %1").arg(stats.duplicates_dropped);
+    }
+    
+    // Sampling keeps the capture unbiased but incomplete, so say so
+    if (stats.sampling_rate > 1) {
+        text += QString(" | Sampling 1/%1").arg(stats.sampling_rate);
+    }
+    
+    captureStatsLabel->setText(text);
+    
+    // Make losses stand out
+    bool dropping = stats.kernel_dropped + stats.interface_dropped + stats.queue_dropped > 0;
+    captureStatsLabel->setStyleSheet(dropping ? "color: red;" : "");
+    
+    // Appends only flush when packets arrive, so cover quiet periods here
+    if (currentCaptureFile->is_streaming() && !currentCaptureFile->save()) {
+        Log::warning("Periodic flush of the capture file failed");
+    }
+}
+
 void MainWindow::on_newCapture_triggered() {
     on_startCapture_clicked();
 }
@@ -385,7 +580,7 @@ void MainWindow::on_newCapture_triggered() {
 void MainWindow::on_openCapture_triggered() {
     QString fileName = QFileDialog::getOpenFileName(
         this, "Open Capture File", "",
-        "Wireshark MCP Captures (*.wcap);;All Files (*)"
+        "Wireshark MCP Captures (*.wcap);;Packet Captures (*.pcap *.pcapng);;All Files (*)"
     );
     
     if (fileName.isEmpty()) {
@@ -407,8 +602,15 @@ void MainWindow::on_openCapture_triggered() {
         }
     }
     
-    // Open the selected file
-    if (!currentCaptureFile->open(fileName.toStdString())) {
+    // Open the selected file; pcap/pcapng files are replayed into a new capture
+    bool opened = false;
+    if (fileName.endsWith(".pcap") || fileName.endsWith(".pcapng")) {
+        opened = importPacketCapture(fileName.toStdString());
+    } else {
+        opened = currentCaptureFile->open(fileName.toStdString());
+    }
+    
+    if (!opened) {
         QMessageBox::critical(this, "Error", "Failed to open capture file");
         return;
     }
@@ -428,21 +630,131 @@ void MainWindow::on_openCapture_triggered() {
     
     // Update packet count in status bar
     size_t count = currentCaptureFile->get_packet_count();
-    QLabel* packetCountLabel = qobject_cast<QLabel*>(statusBar()->children().at(1));
-    if (packetCountLabel) {
-        packetCountLabel->setText(QString("Packets: %1").arg(count));
-    }
+    packetCountLabel->setText(QString("Packets: %1").arg(count));
+    captureStatsLabel->clear();
     
     // Update device label in status bar
     std::string device = currentCaptureFile->get_device_name();
-    QLabel* deviceLabel = qobject_cast<QLabel*>(statusBar()->children().at(2));
-    if (deviceLabel) {
-        deviceLabel->setText(QString("Device: %1").arg(device.c_str()));
-    }
+    deviceLabel->setText(QString("Device: %1").arg(device.c_str()));
     
     Log::info("Opened capture file: {}", fileName.toStdString());
 }
 
+bool MainWindow::importPacketCapture(const std::string& file_path) {
+    PacketCapture reader;
+    CaptureOptions options;  // Replays as fast as possible
+    
+    if (!reader.initialize_file(file_path, options) || !reader.start_capture()) {
+        Log::error("Failed to import packet capture: {}", reader.get_error());
+        return false;
+    }
+    
+    currentCaptureFile->create(file_path + ".wcap");
+    currentCaptureFile->set_device_name(file_path);
+    
+    // The capture file shares each buffer with the reader, no copy is made
+    std::vector<Packet> batch;
+    while (reader.is_capturing()) {
+        size_t count = reader.get_next_packets(batch, 1024);
+        
+        for (size_t i = 0; i < count; ++i) {
+            currentCaptureFile->add_packet(batch[i].data, packet_timestamp_from_ns(batch[i].timestamp),
+                                           batch[i].actual_length);
+        }
+    }
+    
+    Log::info("Imported {} packets from {}", currentCaptureFile->get_packet_count(), file_path);
+    return true;
+}
+
+bool MainWindow::canAnalyzeCaptureFile() {
+    if (!currentCaptureFile->is_open() || currentCaptureFile->get_packet_count() == 0) {
+        QMessageBox::information(this, "Information", "No packets to analyze");
+        return false;
+    }
+    
+    if (currentCaptureFile->is_streaming()) {
+        QMessageBox::information(this, "Information",
+                                 "Packets streamed to disk can be analyzed once the capture has stopped");
+        return false;
+    }
+    
+    // A finished stream is complete on disk; read it back to dissect it
+    if (currentCaptureFile->is_streamed()) {
+        std::string file_path = currentCaptureFile->get_file_path();
+        if (!currentCaptureFile->open(file_path)) {
+            QMessageBox::critical(this, "Error",
+                                  QString("Failed to reopen capture file: %1").arg(file_path.c_str()));
+            return false;
+        }
+        Log::info("Reopened streamed capture file {} with {} packets", file_path,
+                  currentCaptureFile->get_packet_count());
+    }
+    
+    return true;
+}
+
+bool MainWindow::dissectCaptureFile(const std::function<void(const DecodedPacket&)>& handler) {
+    if (!canAnalyzeCaptureFile()) {
+        return false;
+    }
+    
+    ParallelAnalyzer analyzer;
+    if (!analyzer.start(parallel_analyzer_options_from_config(Config::getInstance()),
+                        [&handler](uint64_t, const DecodedPacket& decoded) { handler(decoded); })) {
+        QMessageBox::critical(this, "Error", QString("Failed to start analysis: %1").arg(analyzer.get_error().c_str()));
+        return false;
+    }
+    
+    // Packets share their buffers with the capture file
+    size_t count = currentCaptureFile->get_packet_count();
+    Packet packet;
+    PacketTimestamp timestamp;
+    for (size_t i = 0; i < count; ++i) {
+        if (!currentCaptureFile->get_packet(i, packet.data, timestamp, packet.actual_length)) {
+            continue;
+        }
+        packet.timestamp = static_cast<uint64_t>(timestamp.time_since_epoch().count());
+        packet.captured_length = packet.data.size();
+        analyzer.submit(packet);
+    }
+    
+    analyzer.stop();
+    return true;
+}
+
+bool MainWindow::collectConversations(std::vector<FlowStats>& flows) {
+    if (!canAnalyzeCaptureFile()) {
+        return false;
+    }
+    
+    Config& config = Config::getInstance();
+    FlowTable table;
+    table.configure(static_cast<size_t>(std::max(1, config.get<int>("analysis.flow_table_size", 262144))),
+                    static_cast<uint64_t>(std::max(0, config.get<int>("analysis.flow_idle_timeout_s", 300))) *
+                        1000000000ULL);
+    table.set_expired_handler([&flows](const FlowStats& flow) { flows.push_back(flow); });
+    
+    size_t count = currentCaptureFile->get_packet_count();
+    PacketBuffer data;
+    PacketTimestamp timestamp;
+    size_t original_length;
+    for (size_t i = 0; i < count; ++i) {
+        if (currentCaptureFile->get_packet(i, data, timestamp, original_length)) {
+            table.update_frame(data.data(), data.size(), original_length,
+                               static_cast<uint64_t>(timestamp.time_since_epoch().count()));
+        }
+    }
+    
+    table.for_each([&flows](const FlowStats& flow) { flows.push_back(flow); });
+    
+    if (table.get_overflows() > 0) {
+        Log::warning("Flow table full: {} packets of new conversations were not counted",
+                     table.get_overflows());
+    }
+    return true;
+}
+
 void MainWindow::on_saveCapture_triggered() {
     if (!currentCaptureFile->is_open()) {
         QMessageBox::warning(this, "Warning", "No capture file is open");
@@ -542,7 +854,7 @@ void MainWindow::on_exit_triggered() {
     
     // Stop any active capture
     if (isCapturing) {
-        captureEngine->stop_capture();
+        stopActiveCapture();
     }
     
     // Close application
@@ -555,8 +867,37 @@ void MainWindow::on_captureOptions_triggered() {
 }
 
 void MainWindow::on_captureFilters_triggered() {
-    // Placeholder for filters dialog
-    QMessageBox::information(this, "Information", "Capture filters dialog not implemented in this demo");
+    bool ok = false;
+    QString current = QString::fromStdString(captureEngine->get_options().capture_filter);
+    QString filter = QInputDialog::getText(
+        this, "Capture Filter", "BPF capture filter (empty captures everything):",
+        QLineEdit::Normal, current, &ok
+    );
+    
+    if (!ok) {
+        return;
+    }
+    
+    if (!isCapturing) {
+        // Applied by the next capture
+        Config::getInstance().set<std::string>("capture.default_filter", filter.toStdString());
+        return;
+    }
+    
+    // Swap the kernel filter on the running capture
+    if (isMultiDeviceCapture) {
+        if (!multiCaptureEngine->set_capture_filter(filter.toStdString())) {
+            QMessageBox::critical(this, "Error",
+                                 QString("Invalid capture filter: %1").arg(multiCaptureEngine->get_error().c_str()));
+            return;
+        }
+    } else if (!captureEngine->set_capture_filter(filter.toStdString())) {
+        QMessageBox::critical(this, "Error",
+                             QString("Invalid capture filter: %1").arg(captureEngine->get_error().c_str()));
+        return;
+    }
+    
+    statusBar()->showMessage(QString("Capture filter applied: %1").arg(filter), 5000);
 }
 
 void MainWindow::on_timeFormat_triggered() {
@@ -585,8 +926,45 @@ void MainWindow::on_displayFilters_triggered() {
 }
 
 void MainWindow::on_conversations_triggered() {
-    // Placeholder for conversations dialog
-    QMessageBox::information(this, "Information", "Conversations dialog not implemented in this demo");
+    std::vector<FlowStats> flows;
+    if (!collectConversations(flows)) {
+        return;
+    }
+    
+    // Totals per transport protocol
+    struct Totals {
+        size_t conversations = 0;
+        size_t handshakes = 0;
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+    };
+    std::map<uint8_t, Totals> transports;
+    
+    for (const auto& flow : flows) {
+        Totals& totals = transports[flow.key.ip_protocol];
+        ++totals.conversations;
+        totals.packets += flow.packets();
+        totals.bytes += flow.bytes();
+        
+        if ((flow.tcp_flags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == (TCP_FLAG_SYN | TCP_FLAG_ACK)) {
+            ++totals.handshakes;
+        }
+    }
+    
+    QString text = QString("%1 conversations\n\n").arg(flows.size());
+    for (const auto& entry : transports) {
+        text += QString("%1: %2 conversations, %3 packets, %4 bytes")
+                    .arg(transportName(entry.first))
+                    .arg(entry.second.conversations)
+                    .arg(entry.second.packets)
+                    .arg(entry.second.bytes);
+        if (entry.first == 6) {
+            text += QString(" (%1 with SYN and ACK seen)").arg(entry.second.handshakes);
+        }
+        text += "\n";
+    }
+    
+    QMessageBox::information(this, "Conversations", text);
 }
 
 void MainWindow::on_endpoints_triggered() {
@@ -600,13 +978,71 @@ void MainWindow::on_flowGraph_triggered() {
 }
 
 void MainWindow::on_protocolHierarchy_triggered() {
-    // Placeholder for protocol hierarchy dialog
-    QMessageBox::information(this, "Information", "Protocol hierarchy dialog not implemented in this demo");
+    // Packets and bytes per protocol path; std::map keeps each path right
+    // after its parent
+    struct Totals {
+        size_t packets = 0;
+        size_t bytes = 0;
+    };
+    std::map<std::vector<std::string>, Totals> hierarchy;
+    size_t total = 0;
+    
+    bool dissected = dissectCaptureFile([&hierarchy, &total](const DecodedPacket& decoded) {
+        std::vector<std::string> path;
+        for (const auto& protocol : decoded.protocol_stack) {
+            path.push_back(protocol);
+            Totals& totals = hierarchy[path];
+            ++totals.packets;
+            totals.bytes += decoded.raw_packet.actual_length;
+        }
+        ++total;
+    });
+    
+    if (!dissected) {
+        return;
+    }
+    
+    QString text = QString("%1 packets\n\n").arg(total);
+    for (const auto& entry : hierarchy) {
+        double share = total > 0 ? 100.0 * entry.second.packets / total : 0.0;
+        text += QString("%1%2: %3 packets (%4%), %5 bytes\n")
+                    .arg(QString(static_cast<int>(entry.first.size() - 1) * 2, ' '))
+                    .arg(QString::fromStdString(entry.first.back()))
+                    .arg(entry.second.packets)
+                    .arg(share, 0, 'f', 1)
+                    .arg(entry.second.bytes);
+    }
+    
+    QMessageBox::information(this, "Protocol Hierarchy", text);
 }
 
 void MainWindow::on_conversationList_triggered() {
-    // Placeholder for conversation list dialog
-    QMessageBox::information(this, "Information", "Conversation list dialog not implemented in this demo");
+    std::vector<FlowStats> flows;
+    if (!collectConversations(flows)) {
+        return;
+    }
+    
+    size_t shown = std::min(flows.size(), CONVERSATION_LIST_LIMIT);
+    std::partial_sort(flows.begin(), flows.begin() + shown, flows.end(),
+                      [](const FlowStats& a, const FlowStats& b) { return a.bytes() > b.bytes(); });
+    
+    QString text = QString("%1 conversations, largest %2:\n\n").arg(flows.size()).arg(shown);
+    for (size_t i = 0; i < shown; ++i) {
+        const FlowStats& flow = flows[i];
+        double duration = static_cast<double>(flow.last_seen - flow.first_seen) / 1e9;
+        
+        text += QString("%1 %2 <-> %3: %4 / %5 packets, %6 / %7 bytes, %8 s\n")
+                    .arg(transportName(flow.key.ip_protocol))
+                    .arg(QString::fromStdString(format_flow_endpoint(flow.key, false)))
+                    .arg(QString::fromStdString(format_flow_endpoint(flow.key, true)))
+                    .arg(flow.packets_a_to_b)
+                    .arg(flow.packets_b_to_a)
+                    .arg(flow.bytes_a_to_b)
+                    .arg(flow.bytes_b_to_a)
+                    .arg(duration, 0, 'f', 3);
+    }
+    
+    QMessageBox::information(this, "Conversation List", text);
 }
 
 void MainWindow::on_endpointList_triggered() {
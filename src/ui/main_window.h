@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <memory>
+#include <string>
+#include <functional>
 
 class QAction;
 class QMenu;
@@ -10,10 +12,17 @@ class QToolBar;
 class QDockWidget;
 class QTabWidget;
 class QStatusBar;
+class QLabel;
+class QTimer;
+class QSocketNotifier;
 
 namespace wireshark_mcp {
 
 class PacketCapture;
+class MultiCapture;
+struct Packet;
+struct DecodedPacket;
+struct FlowStats;
 class AuthManager;
 class CaptureFile;
 
@@ -69,6 +78,8 @@ private slots:
     void onCaptureStarted();
     void onCaptureStopped();
     void onPacketCaptured();
+    void updateCaptureStats();
+    void drainCapturedPackets();
 
 private:
     void setupUi();
@@ -80,7 +91,16 @@ private:
     void createDockWidgets();
     
     void showPermissionDeniedDialog();
+    bool importPacketCapture(const std::string& file_path);
+    bool canAnalyzeCaptureFile();
+    // Dissect every packet of the current capture file on the analysis
+    // workers; the handler sees them in file order
+    bool dissectCaptureFile(const std::function<void(const DecodedPacket&)>& handler);
+    // Conversations of the current capture file, including those that went
+    // idle and were evicted from the flow table
+    bool collectConversations(std::vector<FlowStats>& flows);
     void updateUIState();
+    void stopActiveCapture();
     
     // Action groups
     QMenu* fileMenu;
@@ -106,9 +126,20 @@ private:
     QDockWidget* packetDetailsDock;
     QDockWidget* packetBytesDock;
     QStatusBar* statusBar;
+    QLabel* packetCountLabel;
+    QLabel* captureStatsLabel;
+    QLabel* deviceLabel;
+    QTimer* captureStatsTimer;
     
     // Application components
     std::shared_ptr<PacketCapture> captureEngine;
+    std::shared_ptr<MultiCapture> multiCaptureEngine;   // Used when several devices are configured
+    
+    // Wakes the GUI when captured packets are waiting; the poll timer is the
+    // fallback for engines without a selectable descriptor
+    QSocketNotifier* captureNotifier;
+    QTimer* capturePollTimer;
+    std::vector<Packet> captureBatch;
     std::shared_ptr<CaptureFile> currentCaptureFile;
     
     // Manager instances
@@ -116,6 +147,7 @@ private:
     
     // State
     bool isCapturing;
+    bool isMultiDeviceCapture;
     bool hasUnsavedChanges;
 };
 
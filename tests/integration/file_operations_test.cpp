@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "storage/capture_file.h"
+#include "storage/capture_writer.h"
 #include "security/security_manager.h"
 #include <filesystem>
 #include <random>
@@ -305,5 +306,109 @@ TEST_F(FileOperationsTest, SecurityManagerTempFiles) {
     EXPECT_FALSE(std::filesystem::exists(temp_file));
 }
 
+TEST_F(FileOperationsTest, NanosecondTimestampsRoundTrip) {
+    // 1 ns apart: any microsecond rounding would collapse them
+    const uint64_t base_ns = 1700000000123456789ULL;
+    
+    {
+        auto capture_file = create_capture_file();
+        ASSERT_TRUE(capture_file->create(test_file_path_));
+        
+        for (uint64_t i = 0; i < 3; ++i) {
+            PacketBuffer buffer = PacketBufferPool::default_pool().copy(
+                test_packets_[i].data(), test_packets_[i].size());
+            ASSERT_TRUE(capture_file->add_packet(buffer, packet_timestamp_from_ns(base_ns + i)));
+        }
+        
+        ASSERT_TRUE(capture_file->save());
+        capture_file->close();
+    }
+    
+    auto capture_file = create_capture_file();
+    ASSERT_TRUE(capture_file->open(test_file_path_));
+    ASSERT_EQ(3u, capture_file->get_packet_count());
+    
+    for (uint64_t i = 0; i < 3; ++i) {
+        PacketBuffer buffer;
+        PacketTimestamp timestamp;
+        
+        ASSERT_TRUE(capture_file->get_packet(i, buffer, timestamp));
+        EXPECT_EQ(static_cast<int64_t>(base_ns + i), timestamp.time_since_epoch().count());
+    }
+}
+
+TEST_F(FileOperationsTest, StreamingWritesThroughToDisk) {
+    // Small buffers so the capture spans many hand-offs to the writer thread
+    CaptureWriterOptions options;
+    options.buffer_size = 64 * 1024;
+    options.direct_io = true;   // Falls back to the page cache where refused
+    
+    generateRandomPackets(500);
+    
+    {
+        auto capture_file = create_capture_file();
+        ASSERT_TRUE(capture_file->create(test_file_path_));
+        capture_file->set_device_name("test_device");
+        
+        ASSERT_TRUE(capture_file->start_streaming(options));
+        EXPECT_TRUE(capture_file->is_streaming());
+        
+        for (size_t i = 0; i < test_packets_.size(); ++i) {
+            const auto& packet = test_packets_[i];
+            ASSERT_TRUE(capture_file->add_packet(packet.data(), packet.size(), packet_timestamps_[i]));
+        }
+        
+        EXPECT_EQ(test_packets_.size(), capture_file->get_packet_count());
+        EXPECT_FALSE(capture_file->is_modified());
+        
+        ASSERT_TRUE(capture_file->stop_streaming());
+        EXPECT_EQ(capture_file->get_stats().file_size, std::filesystem::file_size(test_file_path_));
+        capture_file->close();
+    }
+    
+    auto capture_file = create_capture_file();
+    ASSERT_TRUE(capture_file->open(test_file_path_));
+    EXPECT_EQ("test_device", capture_file->get_device_name());
+    ASSERT_EQ(test_packets_.size(), capture_file->get_packet_count());
+    
+    for (size_t i = 0; i < test_packets_.size(); ++i) {
+        std::vector<uint8_t> read_packet;
+        std::chrono::system_clock::time_point read_timestamp;
+        
+        ASSERT_TRUE(capture_file->get_packet(i, read_packet, read_timestamp));
+        EXPECT_EQ(test_packets_[i], read_packet);
+    }
+}
+
+TEST_F(FileOperationsTest, UnclosedStreamReadsToLastCompletePacket) {
+    std::string crashed_path = test_dir_ + "/crashed.wcap";
+    
+    // Flushed but never closed, as after a crash
+    CaptureWriter writer;
+    ASSERT_TRUE(writer.open(test_file_path_, "test_device", "", CaptureWriterOptions()));
+    
+    for (size_t i = 0; i < test_packets_.size(); ++i) {
+        ASSERT_TRUE(writer.append(test_packets_[i].data(), test_packets_[i].size(),
+                                  static_cast<int64_t>(i)));
+    }
+    ASSERT_TRUE(writer.flush());
+    
+    // Cut the last record short
+    std::filesystem::copy_file(test_file_path_, crashed_path);
+    std::filesystem::resize_file(crashed_path, std::filesystem::file_size(crashed_path) - 1);
+    
+    auto capture_file = create_capture_file();
+    ASSERT_TRUE(capture_file->open(test_file_path_));
+    EXPECT_EQ(test_packets_.size(), capture_file->get_packet_count());
+    
+    ASSERT_TRUE(capture_file->open(crashed_path));
+    EXPECT_EQ(test_packets_.size() - 1, capture_file->get_packet_count());
+    
+    std::vector<uint8_t> read_packet;
+    std::chrono::system_clock::time_point read_timestamp;
+    ASSERT_TRUE(capture_file->get_packet(0, read_packet, read_timestamp));
+    EXPECT_EQ(test_packets_[0], read_packet);
+}
+
 } // namespace integration_test
 } // namespace wireshark_mcp
\ No newline at end of file
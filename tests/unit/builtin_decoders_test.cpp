@@ -0,0 +1,212 @@
+#include "gtest/gtest.h"
+#include "analysis/protocol_analyzer.h"
+#include "analysis/checksum.h"
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+class BuiltinDecodersTest : public ::testing::Test {
+protected:
+    bool analyze(const std::vector<uint8_t>& bytes) {
+        packet.timestamp = 0;
+        packet.data.assign(bytes.data(), bytes.data() + bytes.size());
+        packet.actual_length = bytes.size();
+        packet.captured_length = bytes.size();
+        return analyzer.analyze_packet(packet, decoded);
+    }
+    
+    uint64_t value_of(const char* name) {
+        const PacketField* field = decoded.find_field(FieldRegistry::instance().find(name));
+        EXPECT_NE(nullptr, field) << name;
+        return field ? field->value : 0;
+    }
+    
+    std::string render(const char* name) {
+        const PacketField* field = decoded.find_field(FieldRegistry::instance().find(name));
+        EXPECT_NE(nullptr, field) << name;
+        return field ? field_value(*field, decoded) : "";
+    }
+    
+    static void append(std::vector<uint8_t>& bytes, std::initializer_list<uint8_t> values) {
+        bytes.insert(bytes.end(), values);
+    }
+    
+    static std::vector<uint8_t> ethernet(uint16_t type) {
+        return {0x00, 0x1b, 0x21, 0xaa, 0xbb, 0x0c, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01,
+                static_cast<uint8_t>(type >> 8), static_cast<uint8_t>(type)};
+    }
+    
+    ProtocolAnalyzer analyzer;
+    Packet packet;
+    DecodedPacket decoded;
+};
+
+TEST_F(BuiltinDecodersTest, StackedVlanIpv4Tcp) {
+    // QinQ outer tag, 802.1Q inner tag
+    std::vector<uint8_t> bytes = ethernet(0x88A8);
+    append(bytes, {0x00, 0x64, 0x81, 0x00});
+    append(bytes, {0xA0, 0x0A, 0x08, 0x00});
+    
+    // IPv4, 20 byte header, total length 20 + 24 + 4
+    append(bytes, {0x45, 0x00, 0x00, 0x30, 0x12, 0x34, 0x40, 0x00, 0x40, 0x06, 0xbe, 0xef,
+                   192, 0, 2, 1, 198, 51, 100, 7});
+    
+    // TCP with one 4 byte option, PSH|ACK, then 4 bytes of payload
+    append(bytes, {0xc3, 0x50, 0x01, 0xbb, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02,
+                   0x60, 0x18, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00});
+    append(bytes, {'d', 'a', 't', 'a'});
+    
+    // Ethernet padding past the IP total length
+    bytes.resize(bytes.size() + 6, 0);
+    
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ((std::vector<std::string>{"eth", "vlan", "vlan", "ip", "tcp"}), decoded.protocol_stack);
+    
+    EXPECT_EQ("00:1b:21:aa:bb:0c", render("eth.dst"));
+    EXPECT_EQ(100u, value_of("vlan.id"));       // Outer tag first
+    EXPECT_EQ("192.0.2.1", render("ip.src"));
+    EXPECT_EQ("198.51.100.7", render("ip.dst"));
+    EXPECT_EQ(6u, value_of("ip.proto"));
+    EXPECT_EQ(50000u, value_of("tcp.srcport"));
+    EXPECT_EQ(443u, value_of("tcp.dstport"));
+    EXPECT_EQ(24u, value_of("tcp.hdr_len"));
+    EXPECT_EQ(0x018u, value_of("tcp.flags"));
+    
+    ASSERT_EQ(5u, decoded.layers.size());
+    EXPECT_EQ(22u, decoded.layers[3].offset);
+    EXPECT_EQ(42u, decoded.layers[4].offset);
+    EXPECT_EQ(24u, decoded.layers[4].length);
+}
+
+TEST_F(BuiltinDecodersTest, Ipv6ExtensionHeadersAndUdp) {
+    std::vector<uint8_t> bytes = ethernet(0x86DD);
+    
+    // IPv6: payload is an 8 byte hop-by-hop header and 12 bytes of UDP
+    append(bytes, {0x60, 0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x40});
+    append(bytes, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    append(bytes, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2});
+    append(bytes, {0x11, 0x00, 0x01, 0x04, 0x00, 0x00, 0x00, 0x00});
+    append(bytes, {0x9c, 0x40, 0x00, 0x35, 0x00, 0x0c, 0x00, 0x00, 0xab, 0xcd, 0x01, 0x00});
+    
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ((std::vector<std::string>{"eth", "ipv6", "udp"}), decoded.protocol_stack);
+    
+    EXPECT_EQ("2001:db8:0:0:0:0:0:2", render("ipv6.dst"));
+    EXPECT_EQ(0u, value_of("ipv6.nxt"));
+    EXPECT_EQ(40000u, value_of("udp.srcport"));
+    EXPECT_EQ(53u, value_of("udp.dstport"));
+    
+    // The extension header belongs to the IPv6 layer
+    ASSERT_EQ(3u, decoded.layers.size());
+    EXPECT_EQ(48u, decoded.layers[1].length);
+    EXPECT_EQ(62u, decoded.layers[2].offset);
+}
+
+TEST_F(BuiltinDecodersTest, ArpAndIcmpEcho) {
+    std::vector<uint8_t> arp = ethernet(0x0806);
+    append(arp, {0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01,
+                 0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 192, 0, 2, 1,
+                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 192, 0, 2, 254});
+    
+    ASSERT_TRUE(analyze(arp));
+    EXPECT_EQ("arp", decoded.highest_protocol);
+    EXPECT_EQ(1u, value_of("arp.opcode"));
+    EXPECT_EQ("192.0.2.254", render("arp.dst.proto_ipv4"));
+    
+    std::vector<uint8_t> ping = ethernet(0x0800);
+    append(ping, {0x45, 0x00, 0x00, 0x1c, 0x00, 0x01, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00,
+                  192, 0, 2, 1, 192, 0, 2, 2});
+    append(ping, {0x08, 0x00, 0xf7, 0xfe, 0x00, 0x01, 0x00, 0x07});
+    
+    ASSERT_TRUE(analyze(ping));
+    EXPECT_EQ((std::vector<std::string>{"eth", "ip", "icmp"}), decoded.protocol_stack);
+    EXPECT_EQ(8u, value_of("icmp.type"));
+    EXPECT_EQ(7u, value_of("icmp.echo.seq"));
+}
+
+TEST_F(BuiltinDecodersTest, FragmentsAndTruncatedHeadersStopTheChain) {
+    // A non-first IPv4 fragment carries no transport header
+    std::vector<uint8_t> fragment = ethernet(0x0800);
+    append(fragment, {0x45, 0x00, 0x00, 0x1c, 0x00, 0x01, 0x00, 0xb9, 0x40, 0x11, 0x00, 0x00,
+                      192, 0, 2, 1, 192, 0, 2, 2});
+    append(fragment, {0x00, 0x35, 0x00, 0x35, 0x00, 0x08, 0x00, 0x00});
+    
+    ASSERT_TRUE(analyze(fragment));
+    EXPECT_EQ((std::vector<std::string>{"eth", "ip"}), decoded.protocol_stack);
+    EXPECT_EQ(185u * 8, value_of("ip.frag_offset"));
+    
+    // A TCP header cut off by the snapshot length is not decoded
+    std::vector<uint8_t> truncated = ethernet(0x0800);
+    append(truncated, {0x45, 0x00, 0x00, 0x28, 0x00, 0x01, 0x00, 0x00, 0x40, 0x06, 0x00, 0x00,
+                       192, 0, 2, 1, 192, 0, 2, 2});
+    append(truncated, {0x00, 0x50, 0xc3, 0x50, 0x00, 0x00});
+    
+    ASSERT_TRUE(analyze(truncated));
+    EXPECT_EQ("ip", decoded.highest_protocol);
+    EXPECT_EQ(nullptr, decoded.find_field(FieldRegistry::instance().find("tcp.srcport")));
+}
+
+TEST_F(BuiltinDecodersTest, ChecksumsAreVerifiedWhenEnabled) {
+    std::vector<uint8_t> bytes = ethernet(0x0800);
+    append(bytes, {0x45, 0x00, 0x00, 0x2b, 0x00, 0x01, 0x00, 0x00, 0x40, 0x06, 0x00, 0x00,
+                   192, 0, 2, 1, 192, 0, 2, 2});
+    append(bytes, {0xc3, 0x50, 0x00, 0x50, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+                   0x50, 0x02, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 'a', 'b', 'c'});
+    
+    // Fill in both checksums, the TCP one over the pseudo-header
+    uint8_t* ip = bytes.data() + 14;
+    uint16_t ip_checksum = static_cast<uint16_t>(~checksum_sum(ip, 20));
+    ip[10] = static_cast<uint8_t>(ip_checksum >> 8);
+    ip[11] = static_cast<uint8_t>(ip_checksum);
+    
+    uint8_t* tcp = ip + 20;
+    uint16_t tcp_checksum = static_cast<uint16_t>(~checksum_sum(tcp, 23, checksum_sum(ip + 12, 8, 6 + 23)));
+    tcp[16] = static_cast<uint8_t>(tcp_checksum >> 8);
+    tcp[17] = static_cast<uint8_t>(tcp_checksum);
+    
+    // Off by default
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ(nullptr, decoded.find_field(FieldRegistry::instance().find("tcp.checksum.status")));
+    
+    analyzer.set_checksum_verification(true);
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ("good", render("ip.checksum.status"));
+    EXPECT_EQ("good", render("tcp.checksum.status"));
+    
+    // A corrupted payload byte only fails the TCP checksum
+    bytes.back() ^= 0x01;
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ("good", render("ip.checksum.status"));
+    EXPECT_EQ("bad", render("tcp.checksum.status"));
+    
+    // Cut short by the snapshot length
+    bytes.pop_back();
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ("unverified", render("tcp.checksum.status"));
+}
+
+TEST_F(BuiltinDecodersTest, UdpChecksumOverIpv6) {
+    std::vector<uint8_t> bytes = ethernet(0x86DD);
+    append(bytes, {0x60, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x11, 0x40});
+    append(bytes, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    append(bytes, {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2});
+    append(bytes, {0x9c, 0x40, 0x00, 0x35, 0x00, 0x0a, 0x00, 0x00, 0x12, 0x34});
+    
+    uint8_t* ipv6 = bytes.data() + 14;
+    uint8_t* udp = ipv6 + 40;
+    uint16_t checksum = static_cast<uint16_t>(~checksum_sum(udp, 10, checksum_sum(ipv6 + 8, 32, 17 + 10)));
+    udp[6] = static_cast<uint8_t>(checksum >> 8);
+    udp[7] = static_cast<uint8_t>(checksum);
+    
+    analyzer.set_checksum_verification(true);
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ("good", render("udp.checksum.status"));
+    
+    udp[9] ^= 0x80;
+    ASSERT_TRUE(analyze(bytes));
+    EXPECT_EQ("bad", render("udp.checksum.status"));
+}
+
+} // namespace test
+} // namespace wireshark_mcp
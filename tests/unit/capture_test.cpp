@@ -1,26 +1,39 @@
 #include "gtest/gtest.h"
 #include "capture/packet_capture.h"
 #include "security/security_manager.h"
+#include "test_helpers.h"
+#include <chrono>
+#include <fstream>
 
 namespace wireshark_mcp {
 namespace test {
 
-class MockSecurityManager : public SecurityManager {
-public:
-    static bool validateCaptureMock(const std::string& device_name) {
-        // Always return true for testing
-        return true;
+// Write a little-endian classic pcap file with count 60-byte Ethernet frames
+// spaced gap_us microseconds apart
+static void writeTestPcap(const std::string& path, uint32_t count, uint32_t gap_us) {
+    std::ofstream file(path, std::ios::binary);
+    
+    const uint32_t global_header[] = {0xa1b2c3d4, 0x00040002, 0, 0, 65535, 1};
+    file.write(reinterpret_cast<const char*>(global_header), 24);
+    
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t ts = 1000000ULL + static_cast<uint64_t>(i) * gap_us;
+        const uint32_t record[] = {
+            static_cast<uint32_t>(ts / 1000000), static_cast<uint32_t>(ts % 1000000), 60, 60
+        };
+        file.write(reinterpret_cast<const char*>(record), sizeof(record));
+        
+        std::vector<char> frame(60, static_cast<char>(i));
+        file.write(frame.data(), frame.size());
     }
-};
+}
 
 // Test fixture for PacketCapture
 class PacketCaptureTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        // Redirect validate_capture_permissions to our mock
-        SecurityManager::validate_capture_permissions = 
-            MockSecurityManager::validateCaptureMock;
-        
+        // With no allowed devices configured, every device passes the
+        // permission check
         capture = std::make_unique<PacketCapture>();
     }
     
@@ -75,7 +88,7 @@ TEST_F(PacketCaptureTest, StartStopCapture) {
     EXPECT_TRUE(capture->is_capturing());
     
     // Stop capture
-    EXPECT_TRUE(capture->stop_capture());
+    capture->stop_capture();
     EXPECT_FALSE(capture->is_capturing());
 }
 
@@ -98,7 +111,8 @@ TEST_F(PacketCaptureTest, StartTwice) {
     EXPECT_FALSE(capture->start_capture());
     
     // Clean up
-    EXPECT_TRUE(capture->stop_capture());
+    capture->stop_capture();
+    EXPECT_FALSE(capture->is_capturing());
 }
 
 TEST_F(PacketCaptureTest, StopTwice) {
@@ -108,11 +122,12 @@ TEST_F(PacketCaptureTest, StopTwice) {
     
     // Start and stop capture
     EXPECT_TRUE(capture->start_capture());
-    EXPECT_TRUE(capture->stop_capture());
+    capture->stop_capture();
     EXPECT_FALSE(capture->is_capturing());
     
-    // Try to stop again (should not fail but return false)
-    EXPECT_FALSE(capture->stop_capture());
+    // Stopping again is harmless
+    capture->stop_capture();
+    EXPECT_FALSE(capture->is_capturing());
 }
 
 TEST_F(PacketCaptureTest, FilterSettings) {
@@ -132,6 +147,221 @@ TEST_F(PacketCaptureTest, FilterSettings) {
     EXPECT_FALSE(capture->set_capture_filter("invalid ~!@ filter"));
 }
 
+TEST_F(PacketCaptureTest, RingBackendUnknownDevice) {
+    CaptureOptions options;
+    options.backend = CaptureBackend::TPACKET_V3;
+    
+    // Ring setup must fail cleanly and report why
+    EXPECT_FALSE(capture->initialize_device("no_such_device0", options));
+    EXPECT_FALSE(capture->get_error().empty());
+    EXPECT_FALSE(capture->start_capture());
+}
+
+TEST_F(PacketCaptureTest, OfflineReplayReadsWholeFile) {
+    TempFile pcap("offline_replay_test.pcap");
+    const std::string& path = pcap.path();
+    writeTestPcap(path, 10, 1000);
+    
+    CaptureOptions options;
+    ASSERT_TRUE(capture->initialize_file(path, options));
+    EXPECT_TRUE(capture->is_offline());
+    ASSERT_TRUE(capture->start_capture());
+    
+    std::vector<Packet> packets;
+    size_t total = 0;
+    while (capture->is_capturing()) {
+        total += capture->get_next_packets(packets, 4);
+    }
+    
+    // End of file stops the capture on its own
+    EXPECT_EQ(10u, total);
+    EXPECT_FALSE(capture->is_capturing());
+}
+
+TEST_F(PacketCaptureTest, OfflineReplayIgnoresEventDrivenWithoutThread) {
+    TempFile pcap("offline_event_test.pcap");
+    writeTestPcap(pcap.path(), 6, 1000);
+    
+    // A savefile descriptor cannot be waited on, so this must not fail start
+    CaptureOptions options;
+    options.event_driven = true;
+    ASSERT_TRUE(capture->initialize_file(pcap.path(), options));
+    EXPECT_FALSE(capture->get_options().event_driven);
+    ASSERT_TRUE(capture->start_capture());
+    EXPECT_EQ(-1, capture->get_selectable_fd());
+    
+    std::vector<Packet> packets;
+    size_t total = 0;
+    while (capture->is_capturing()) {
+        total += capture->get_next_packets(packets, 4);
+    }
+    EXPECT_EQ(6u, total);
+}
+
+TEST_F(PacketCaptureTest, StatsCountReceivedPackets) {
+    TempFile pcap("capture_stats_test.pcap");
+    const std::string& path = pcap.path();
+    writeTestPcap(path, 8, 1000);
+    
+    CaptureOptions options;
+    ASSERT_TRUE(capture->initialize_file(path, options));
+    ASSERT_TRUE(capture->start_capture());
+    
+    Packet packet;
+    while (capture->is_capturing()) {
+        capture->get_next_packet(packet);
+    }
+    
+    CaptureStats stats = capture->get_stats();
+    EXPECT_EQ(8u, stats.packets_received);
+    EXPECT_EQ(8u * 60u, stats.bytes_received);
+    EXPECT_EQ(0u, stats.kernel_dropped);
+    EXPECT_EQ(0u, stats.queue_dropped);
+}
+
+TEST_F(PacketCaptureTest, OfflineScaledReplayPacing) {
+    TempFile pcap("offline_scaled_test.pcap");
+    const std::string& path = pcap.path();
+    writeTestPcap(path, 5, 1000000);  // 4 s of recorded traffic
+    
+    CaptureOptions options;
+    options.replay_mode = ReplayMode::SCALED;
+    options.replay_speed = 40.0;
+    ASSERT_TRUE(capture->initialize_file(path, options));
+    ASSERT_TRUE(capture->start_capture());
+    
+    auto start = std::chrono::steady_clock::now();
+    Packet packet;
+    size_t total = 0;
+    while (capture->is_capturing()) {
+        if (capture->get_next_packet(packet)) {
+            ++total;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    
+    EXPECT_EQ(5u, total);
+    
+    // 100 ms when scaled; the upper bound only has to tell it apart from
+    // real time, with room for a loaded machine
+    EXPECT_GE(elapsed, std::chrono::milliseconds(90));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+}
+
+TEST_F(PacketCaptureTest, GeneratorBackendNeedsNoInterface) {
+    CaptureOptions options;
+    options.backend = CaptureBackend::GENERATOR;
+    options.use_capture_thread = true;
+    options.overflow_policy = OverflowPolicy::BLOCK;
+    options.generator_packet_count = 10000;
+    options.generator_flows = 128;
+    
+    ASSERT_TRUE(capture->initialize_device("", options));
+    EXPECT_EQ("generator", capture->get_device_name());
+    ASSERT_TRUE(capture->start_capture());
+    
+    std::vector<Packet> packets;
+    size_t total = 0;
+    size_t count = 0;
+    bool running = true;
+    while (running || count > 0) {
+        // Sampled before draining: the thread may end right after our last pop
+        running = capture->is_capturing();
+        count = capture->get_next_packets(packets, 256);
+        total += count;
+    }
+    
+    // The packet count ends the capture like the end of a file
+    EXPECT_EQ(10000u, total);
+    EXPECT_EQ(10000u, capture->get_stats().packets_received);
+}
+
+TEST_F(PacketCaptureTest, RestartWithoutCaptureThreadReadsDevice) {
+    CaptureOptions options;
+    options.backend = CaptureBackend::GENERATOR;
+    options.use_capture_thread = true;
+    options.overflow_policy = OverflowPolicy::BLOCK;
+    options.generator_packet_count = 100;
+    
+    ASSERT_TRUE(capture->initialize_device("generator", options));
+    ASSERT_TRUE(capture->start_capture());
+    
+    std::vector<Packet> packets;
+    size_t total = 0;
+    size_t count = 0;
+    bool running = true;
+    while (running || count > 0) {
+        // Sampled before draining: the thread may end right after our last pop
+        running = capture->is_capturing();
+        count = capture->get_next_packets(packets, 64);
+        total += count;
+    }
+    EXPECT_EQ(100u, total);
+    capture->stop_capture();
+    
+    // Same engine, now read directly on the caller's thread
+    options.use_capture_thread = false;
+    ASSERT_TRUE(capture->initialize_device("generator", options));
+    ASSERT_TRUE(capture->start_capture());
+    
+    total = 0;
+    for (int attempts = 0; capture->is_capturing() && attempts < 10000; ++attempts) {
+        total += capture->get_next_packets(packets, 64);
+    }
+    EXPECT_EQ(100u, total);
+    EXPECT_FALSE(capture->is_capturing());
+}
+
+TEST_F(PacketCaptureTest, EventDrivenConsumerWakesForPackets) {
+    CaptureOptions options;
+    options.backend = CaptureBackend::GENERATOR;
+    options.use_capture_thread = true;
+    options.event_driven = true;
+    options.overflow_policy = OverflowPolicy::BLOCK;
+    options.generator_packet_count = 5000;
+    
+    ASSERT_TRUE(capture->initialize_device("generator", options));
+    ASSERT_TRUE(capture->start_capture());
+    EXPECT_GE(capture->get_selectable_fd(), 0);
+    
+    // Sleep until woken, then read until nothing is left
+    std::vector<Packet> packets;
+    size_t total = 0;
+    while (total < 5000 && capture->wait_for_packets(1000)) {
+        size_t count = 0;
+        while ((count = capture->get_next_packets(packets, 256)) > 0) {
+            total += count;
+        }
+    }
+    
+    // A lost wakeup would leave packets queued and time the wait out
+    EXPECT_EQ(5000u, total);
+    
+    capture->stop_capture();
+    EXPECT_EQ(-1, capture->get_selectable_fd());
+}
+
+TEST_F(PacketCaptureTest, GeneratorBackendAppliesCaptureFilter) {
+    CaptureOptions options;
+    options.backend = CaptureBackend::GENERATOR;
+    options.generator_packet_count = 2000;
+    options.generator_udp_share = 0.5;
+    options.capture_filter = "udp";
+    
+    ASSERT_TRUE(capture->initialize_device("generator", options));
+    ASSERT_TRUE(capture->start_capture());
+    
+    size_t total = 0;
+    while (capture->is_capturing()) {
+        total += capture->dispatch_packets([](const PacketView& view) {
+            EXPECT_EQ(17, view.data[14 + 9]);
+        }, 256);
+    }
+    
+    EXPECT_GT(total, 0u);
+    EXPECT_LT(total, 2000u);
+}
+
 TEST_F(PacketCaptureTest, CallbackRegistration) {
     // Set callbacks
     bool start_called = false;
@@ -142,16 +372,20 @@ TEST_F(PacketCaptureTest, CallbackRegistration) {
     capture->setStopCallback([&stop_called]() { stop_called = true; });
     capture->setPacketCallback([&packet_called]() { packet_called = true; });
     
-    // Initialize and start/stop
+    // Initialize and start/stop; the generator needs no interface
     CaptureOptions options;
-    ASSERT_TRUE(capture->initialize_device("test_device", options));
+    options.backend = CaptureBackend::GENERATOR;
+    options.generator_packet_count = 10;
+    ASSERT_TRUE(capture->initialize_device("generator", options));
     ASSERT_TRUE(capture->start_capture());
     
-    // In a real implementation, we'd process some packets here
-    // For testing, we'll manually call the packet callback
-    capture->onPacketCaptured();
+    // A non-empty read reports packets
+    Packet packet;
+    while (!packet_called && capture->is_capturing()) {
+        capture->get_next_packet(packet);
+    }
     
-    ASSERT_TRUE(capture->stop_capture());
+    capture->stop_capture();
     
     // Check that callbacks were called
     EXPECT_TRUE(start_called);
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "analysis/checksum.h"
+#include <random>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+class ChecksumTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        original = active_checksum_kernel();
+    }
+    
+    void TearDown() override {
+        set_checksum_kernel(original);
+    }
+    
+    ChecksumKernel original;
+};
+
+TEST_F(ChecksumTest, Rfc1071Example) {
+    const uint8_t data[] = {0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7};
+    
+    EXPECT_EQ(0xddf2, checksum_sum(data, sizeof(data)));
+    
+    // Odd lengths pad the last byte with zero; initial carries around
+    EXPECT_EQ(0xf201, checksum_sum(data, 3));
+    EXPECT_EQ(0x0001, checksum_sum(data, 2, 0xffff));
+}
+
+TEST_F(ChecksumTest, KernelsAgreeWithScalar) {
+    std::mt19937 random(1071);
+    std::vector<uint8_t> data(70000 + 64);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    
+    // All 0xFF words push the vector lanes toward overflow
+    std::vector<uint8_t> ones(300000, 0xff);
+    
+    const size_t lengths[] = {0, 1, 2, 15, 16, 17, 31, 33, 63, 64, 65, 1499, 1500, 9000, 70000};
+    const ChecksumKernel kernels[] = {ChecksumKernel::SSE2, ChecksumKernel::AVX2};
+    
+    for (size_t length : lengths) {
+        for (size_t misalignment = 0; misalignment < 4; ++misalignment) {
+            const uint8_t* start = data.data() + misalignment;
+            
+            ASSERT_TRUE(set_checksum_kernel(ChecksumKernel::SCALAR));
+            uint16_t expected = checksum_sum(start, length, 0x1234);
+            
+            for (ChecksumKernel kernel : kernels) {
+                if (!set_checksum_kernel(kernel)) {
+                    continue;
+                }
+                EXPECT_EQ(expected, checksum_sum(start, length, 0x1234))
+                    << checksum_kernel_name(kernel) << " length " << length << " offset " << misalignment;
+            }
+        }
+    }
+    
+    for (ChecksumKernel kernel : kernels) {
+        if (set_checksum_kernel(kernel)) {
+            EXPECT_EQ(0xffff, checksum_sum(ones.data(), ones.size())) << checksum_kernel_name(kernel);
+        }
+    }
+}
+
+TEST_F(ChecksumTest, UnsupportedKernelIsRefused) {
+    EXPECT_TRUE(checksum_kernel_supported(ChecksumKernel::SCALAR));
+    
+    ChecksumKernel active = active_checksum_kernel();
+    EXPECT_TRUE(checksum_kernel_supported(active));
+    
+    if (!checksum_kernel_supported(ChecksumKernel::AVX2)) {
+        EXPECT_FALSE(set_checksum_kernel(ChecksumKernel::AVX2));
+        EXPECT_EQ(active, active_checksum_kernel());
+    }
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,64 @@
+#include "gtest/gtest.h"
+#include "common/cpu_affinity.h"
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace wireshark_mcp {
+namespace test {
+
+TEST(CpuAffinityTest, ParsesListsAndRanges) {
+    std::vector<int> cpus;
+    std::string error;
+    
+    ASSERT_TRUE(parse_cpu_list("8, 0-3,2", cpus, error));
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 8}), cpus);
+    
+    ASSERT_TRUE(parse_cpu_list("", cpus, error));
+    EXPECT_TRUE(cpus.empty());
+}
+
+TEST(CpuAffinityTest, RejectsMalformedLists) {
+    std::vector<int> cpus;
+    std::string error;
+    
+    EXPECT_FALSE(parse_cpu_list("3-1", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("a", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("1-", cpus, error));
+    EXPECT_FALSE(parse_cpu_list("-2", cpus, error));
+    EXPECT_FALSE(error.empty());
+}
+
+TEST(CpuAffinityTest, UnknownDeviceHasNoNumaNode) {
+    std::vector<int> cpus;
+    std::string error;
+    
+    EXPECT_EQ(-1, device_numa_node("no-such-device0"));
+    EXPECT_EQ(-1, device_numa_node("../../../etc"));
+    EXPECT_FALSE(resolve_cpu_set("numa", "no-such-device0", cpus, error));
+}
+
+#ifdef __linux__
+TEST(CpuAffinityTest, PinsCurrentThread) {
+    // Pin a scratch thread so the rest of the suite keeps its placement
+    std::thread thread([] {
+        int cpu = sched_getcpu();
+        ASSERT_GE(cpu, 0);
+        
+        std::string error;
+        ASSERT_TRUE(pin_current_thread({cpu}, error)) << error;
+        
+        cpu_set_t set;
+        ASSERT_EQ(0, sched_getaffinity(0, sizeof(set), &set));
+        EXPECT_EQ(1, CPU_COUNT(&set));
+        EXPECT_TRUE(CPU_ISSET(cpu, &set));
+    });
+    thread.join();
+}
+#endif
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,162 @@
+#include "gtest/gtest.h"
+#include "analysis/flow_table.h"
+#include "test_helpers.h"
+#include <random>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+// Distinct IPv4 UDP key for a number
+static FlowKey makeKey(uint32_t number) {
+    FlowKey key;
+    key.ip_version = 4;
+    key.ip_protocol = 17;
+    key.address_a = {10, 0, static_cast<uint8_t>(number >> 8), static_cast<uint8_t>(number)};
+    key.address_b = {10, 1, static_cast<uint8_t>(number >> 24), static_cast<uint8_t>(number >> 16)};
+    key.port_a = 1000;
+    key.port_b = 2000;
+    key.normalize();
+    return key;
+}
+
+TEST(FlowTableTest, CountsBothDirectionsOfAConversation) {
+    FlowTable table;
+    table.configure(16, 0);
+    
+    auto syn = makeTcpFrame(0xC0A80114, 51000, 0xC0A8010A, 443, 0x02);
+    auto syn_ack = makeTcpFrame(0xC0A8010A, 443, 0xC0A80114, 51000, 0x12);
+    auto ack = makeTcpFrame(0xC0A80114, 51000, 0xC0A8010A, 443, 0x10);
+    
+    ASSERT_TRUE(table.update_frame(syn.data(), syn.size(), 60, 1000));
+    ASSERT_TRUE(table.update_frame(syn_ack.data(), syn_ack.size(), 60, 2000));
+    ASSERT_TRUE(table.update_frame(ack.data(), ack.size(), 1514, 3000));
+    EXPECT_EQ(1u, table.size());
+    
+    FlowKey key;
+    ASSERT_TRUE(extract_flow_key(syn.data(), syn.size(), key));
+    const FlowStats* flow = table.find(key);
+    ASSERT_NE(nullptr, flow);
+    
+    // Endpoint A is the lower address, the server here
+    EXPECT_EQ("192.168.1.10:443", format_flow_endpoint(flow->key, false));
+    EXPECT_EQ("192.168.1.20:51000", format_flow_endpoint(flow->key, true));
+    EXPECT_EQ(1u, flow->packets_a_to_b);
+    EXPECT_EQ(2u, flow->packets_b_to_a);
+    EXPECT_EQ(60u, flow->bytes_a_to_b);
+    EXPECT_EQ(1574u, flow->bytes_b_to_a);
+    EXPECT_EQ(1000u, flow->first_seen);
+    EXPECT_EQ(3000u, flow->last_seen);
+    EXPECT_EQ(0x12, flow->tcp_flags);
+    
+    // Non-IP frames have no flow
+    std::vector<uint8_t> arp(42, 0);
+    arp[12] = 0x08;
+    arp[13] = 0x06;
+    EXPECT_FALSE(table.update_frame(arp.data(), arp.size(), arp.size(), 4000));
+}
+
+TEST(FlowTableTest, FormatsEndpoints) {
+    FlowKey key;
+    key.ip_version = 6;
+    key.ip_protocol = 6;
+    key.address_a = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    key.address_b = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2};
+    key.port_a = 443;
+    key.port_b = 51000;
+    
+    EXPECT_EQ("[2001:db8:0:0:0:0:0:1]:443", format_flow_endpoint(key, false));
+    EXPECT_EQ("[2001:db8:0:0:0:0:0:2]:51000", format_flow_endpoint(key, true));
+    
+    // ICMP and other port-less protocols show the address alone
+    key.ip_version = 4;
+    key.ip_protocol = 1;
+    key.address_a = {10, 0, 0, 1};
+    key.port_a = 0;
+    key.port_b = 0;
+    EXPECT_EQ("10.0.0.1", format_flow_endpoint(key, false));
+}
+
+TEST(FlowTableTest, FillsToCapacityWithoutGrowing) {
+    const size_t max_flows = 100000;
+    FlowTable table;
+    table.configure(max_flows, 0);
+    
+    for (uint32_t i = 0; i < max_flows; ++i) {
+        ASSERT_NE(nullptr, table.update(makeKey(i), false, i, 100, 0));
+    }
+    EXPECT_EQ(max_flows, table.size());
+    
+    // Known flows still update, new ones overflow
+    EXPECT_NE(nullptr, table.update(makeKey(7), true, max_flows, 100, 0));
+    EXPECT_EQ(nullptr, table.update(makeKey(max_flows), false, max_flows, 100, 0));
+    EXPECT_EQ(1u, table.get_overflows());
+    
+    for (uint32_t i = 0; i < max_flows; ++i) {
+        const FlowStats* flow = table.find(makeKey(i));
+        ASSERT_NE(nullptr, flow);
+        EXPECT_EQ(i == 7 ? 2u : 1u, flow->packets());
+    }
+    EXPECT_EQ(nullptr, table.find(makeKey(max_flows + 1)));
+}
+
+TEST(FlowTableTest, EvictsIdleFlowsIncrementally) {
+    const uint64_t second = 1000000000ULL;
+    std::vector<FlowStats> expired;
+    
+    FlowTable table;
+    table.configure(1000, 10 * second);
+    table.set_expired_handler([&expired](const FlowStats& flow) { expired.push_back(flow); });
+    
+    for (uint32_t i = 0; i < 1000; ++i) {
+        table.update(makeKey(i), false, i, 100, 0);
+    }
+    
+    // Each update sweeps a few slots; a full pass over the table takes a while
+    uint64_t now = 20 * second;
+    table.update(makeKey(0), false, now, 100, 0);
+    EXPECT_LT(expired.size(), 100u);
+    
+    for (int i = 0; i < 1000; ++i) {
+        table.update(makeKey(0), false, now, 100, 0);
+    }
+    
+    // Flow 0 was idle too, so it was restarted by its own packet
+    EXPECT_EQ(1000u, expired.size());
+    EXPECT_EQ(1000u, table.get_expired());
+    EXPECT_EQ(1u, table.size());
+    
+    const FlowStats* flow = table.find(makeKey(0));
+    ASSERT_NE(nullptr, flow);
+    EXPECT_EQ(now, flow->first_seen);
+    EXPECT_EQ(1001u, flow->packets());
+    
+    // An explicit sweep covers quiet periods
+    EXPECT_EQ(1u, table.expire(now + 11 * second, 1 << 20));
+    EXPECT_EQ(0u, table.size());
+}
+
+TEST(FlowTableTest, ChurnKeepsEveryFlowReachable) {
+    const uint64_t millisecond = 1000000ULL;
+    std::mt19937 random(25);
+    
+    FlowTable table;
+    table.configure(4096, 50 * millisecond);
+    
+    // Flows come and go as time advances, so removals shift runs around
+    for (uint64_t i = 0; i < 200000; ++i) {
+        uint32_t number = static_cast<uint32_t>(random() % 8192);
+        table.update(makeKey(number), (i & 1) != 0, i * millisecond / 50, 64, 0);
+    }
+    
+    size_t visited = 0;
+    table.for_each([&](const FlowStats& flow) {
+        ++visited;
+        EXPECT_EQ(&flow, table.find(flow.key));
+    });
+    EXPECT_EQ(table.size(), visited);
+    EXPECT_GT(table.get_expired(), 0u);
+}
+
+} // namespace test
+} // namespace wireshark_mcp
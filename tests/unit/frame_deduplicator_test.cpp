@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include "capture/frame_deduplicator.h"
+#include "test_helpers.h"
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+// UDP frame with a recognizable payload
+static std::vector<uint8_t> makeFrame(uint8_t ttl, uint16_t ip_id, uint8_t payload_byte) {
+    TestFrame frame;
+    frame.ttl = ttl;
+    frame.ip_id = ip_id;
+    frame.payload_length = 64;
+    frame.payload_byte = payload_byte;
+    return frame.build();
+}
+
+static const uint64_t MICROSECOND = 1000;
+
+TEST(FrameDeduplicatorTest, DropsCopyWithinWindow) {
+    FrameDeduplicator dedup;
+    dedup.configure(100, 1024, true);
+    
+    auto frame = makeFrame(64, 1, 0xAA);
+    uint64_t t = 1700000000ULL * 1000000000ULL;
+    
+    EXPECT_FALSE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t));
+    EXPECT_TRUE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t + 20 * MICROSECOND));
+    EXPECT_EQ(1u, dedup.get_duplicates());
+    
+    // A different frame is not a duplicate
+    auto other = makeFrame(64, 2, 0xAA);
+    EXPECT_FALSE(dedup.is_duplicate(other.data(), other.size(), other.size(), t + 30 * MICROSECOND));
+    EXPECT_EQ(1u, dedup.get_duplicates());
+}
+
+TEST(FrameDeduplicatorTest, RepeatAfterWindowIsKept) {
+    FrameDeduplicator dedup;
+    dedup.configure(100, 1024, true);
+    
+    auto frame = makeFrame(64, 1, 0xAA);
+    uint64_t t = 5000 * MICROSECOND;
+    
+    EXPECT_FALSE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t));
+    EXPECT_FALSE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t + 500 * MICROSECOND));
+    EXPECT_EQ(0u, dedup.get_duplicates());
+}
+
+TEST(FrameDeduplicatorTest, IgnoresRoutingChanges) {
+    // Same datagram seen before and after a router: new MACs, a VLAN tag,
+    // a lower TTL and a new header checksum
+    auto before = makeFrame(64, 7, 0x55);
+    auto after = makeFrame(63, 7, 0x55);
+    for (int i = 0; i < 12; ++i) {
+        after[i] = static_cast<uint8_t>(0xF0 + i);
+    }
+    const uint8_t tag[] = {0x81, 0x00, 0x00, 0x0A};
+    after.insert(after.begin() + 12, tag, tag + 4);
+    
+    EXPECT_EQ(frame_fingerprint(before.data(), before.size(), before.size(), true),
+              frame_fingerprint(after.data(), after.size(), after.size(), true));
+    
+    // The payload still counts
+    auto changed = makeFrame(64, 7, 0x56);
+    EXPECT_NE(frame_fingerprint(before.data(), before.size(), before.size(), true),
+              frame_fingerprint(changed.data(), changed.size(), changed.size(), true));
+}
+
+TEST(FrameDeduplicatorTest, ReorderedCopiesMatch) {
+    FrameDeduplicator dedup;
+    dedup.configure(100, 1024, true);
+    
+    // The copy from a second interface can carry an earlier timestamp
+    auto frame = makeFrame(64, 3, 0x11);
+    uint64_t t = 9000 * MICROSECOND;
+    
+    EXPECT_FALSE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t));
+    EXPECT_TRUE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t - 40 * MICROSECOND));
+}
+
+TEST(FrameDeduplicatorTest, FullTableOverwritesOldest) {
+    FrameDeduplicator dedup;
+    dedup.configure(1000000, 64, true);
+    
+    // Far more live fingerprints than slots: old ones are overwritten
+    uint64_t t = 1000 * MICROSECOND;
+    for (uint16_t id = 0; id < 4096; ++id) {
+        auto frame = makeFrame(64, id, 0x22);
+        EXPECT_FALSE(dedup.is_duplicate(frame.data(), frame.size(), frame.size(), t + id));
+    }
+    EXPECT_EQ(0u, dedup.get_duplicates());
+    
+    // The most recent frame is still remembered
+    auto last = makeFrame(64, 4095, 0x22);
+    EXPECT_TRUE(dedup.is_duplicate(last.data(), last.size(), last.size(), t + 5000));
+}
+
+} // namespace test
+} // namespace wireshark_mcp
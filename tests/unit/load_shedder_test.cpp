@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+#include "capture/load_shedder.h"
+#include "capture/flow_key.h"
+#include "test_helpers.h"
+#include <set>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+TEST(FlowKeyTest, BothDirectionsShareKey) {
+    auto request = makeUdpFrame(0x0A000001, 51000, 0x0A000002, 53);
+    auto response = makeUdpFrame(0x0A000002, 53, 0x0A000001, 51000);
+    
+    FlowKey forward;
+    FlowKey reverse;
+    ASSERT_TRUE(extract_flow_key(request.data(), request.size(), forward));
+    ASSERT_TRUE(extract_flow_key(response.data(), response.size(), reverse));
+    
+    EXPECT_EQ(forward, reverse);
+    EXPECT_EQ(forward.hash(), reverse.hash());
+    EXPECT_EQ(17, forward.ip_protocol);
+    EXPECT_EQ(4, forward.ip_version);
+    
+    auto other = makeUdpFrame(0x0A000001, 51001, 0x0A000002, 53);
+    FlowKey different;
+    ASSERT_TRUE(extract_flow_key(other.data(), other.size(), different));
+    EXPECT_NE(forward, different);
+}
+
+TEST(FlowKeyTest, NonIpFrameHasNoKey) {
+    std::vector<uint8_t> arp(60, 0);
+    arp[12] = 0x08;
+    arp[13] = 0x06;
+    
+    FlowKey key;
+    EXPECT_FALSE(extract_flow_key(arp.data(), arp.size(), key));
+}
+
+TEST(LoadShedderTest, AdmitsEverythingUntilLoaded) {
+    LoadShedder shedder;
+    shedder.configure(SheddingMode::FLOW, 0.75, 0.25, 64);
+    
+    auto frame = makeUdpFrame(0x0A000001, 1234, 0x0A000002, 80);
+    auto now = std::chrono::steady_clock::now();
+    
+    shedder.update(10, 100, now);
+    EXPECT_EQ(1u, shedder.get_rate());
+    EXPECT_EQ(1u, shedder.admit(frame.data(), frame.size()));
+}
+
+TEST(LoadShedderTest, RateFollowsQueueDepth) {
+    LoadShedder shedder;
+    shedder.configure(SheddingMode::PACKET, 0.75, 0.25, 4);
+    
+    auto now = std::chrono::steady_clock::now();
+    
+    // Escalation is rate limited and capped at the maximum
+    shedder.update(90, 100, now);
+    EXPECT_EQ(2u, shedder.get_rate());
+    shedder.update(90, 100, now);
+    EXPECT_EQ(2u, shedder.get_rate());
+    shedder.update(90, 100, now + std::chrono::milliseconds(20));
+    shedder.update(90, 100, now + std::chrono::milliseconds(40));
+    EXPECT_EQ(4u, shedder.get_rate());
+    
+    // Between the watermarks nothing changes; below the low one it backs off slowly
+    shedder.update(50, 100, now + std::chrono::seconds(5));
+    EXPECT_EQ(4u, shedder.get_rate());
+    shedder.update(10, 100, now + std::chrono::seconds(5));
+    EXPECT_EQ(2u, shedder.get_rate());
+    shedder.update(10, 100, now + std::chrono::milliseconds(5500));
+    EXPECT_EQ(2u, shedder.get_rate());
+    shedder.update(10, 100, now + std::chrono::seconds(7));
+    EXPECT_EQ(1u, shedder.get_rate());
+}
+
+TEST(LoadShedderTest, PacketSamplingKeepsOneInN) {
+    LoadShedder shedder;
+    shedder.configure(SheddingMode::PACKET, 0.5, 0.1, 4);
+    
+    auto now = std::chrono::steady_clock::now();
+    shedder.update(100, 100, now);
+    shedder.update(100, 100, now + std::chrono::seconds(1));
+    ASSERT_EQ(4u, shedder.get_rate());
+    
+    auto frame = makeUdpFrame(0x0A000001, 1234, 0x0A000002, 80);
+    size_t kept = 0;
+    for (int i = 0; i < 400; ++i) {
+        uint32_t rate = shedder.admit(frame.data(), frame.size());
+        if (rate != 0) {
+            EXPECT_EQ(4u, rate);
+            ++kept;
+        }
+    }
+    
+    EXPECT_EQ(100u, kept);
+    EXPECT_EQ(300u, shedder.get_shed_packets());
+}
+
+TEST(LoadShedderTest, FlowSamplingIsConsistent) {
+    LoadShedder shedder;
+    shedder.configure(SheddingMode::FLOW, 0.5, 0.1, 8);
+    
+    auto now = std::chrono::steady_clock::now();
+    shedder.update(100, 100, now);
+    shedder.update(100, 100, now + std::chrono::seconds(1));
+    ASSERT_EQ(4u, shedder.get_rate());
+    
+    // Every packet of a flow, in either direction, gets the same verdict
+    std::set<uint16_t> kept_at_4;
+    for (uint16_t port = 10000; port < 10400; ++port) {
+        auto forward = makeUdpFrame(0x0A000001, port, 0x0A000002, 443);
+        auto reverse = makeUdpFrame(0x0A000002, 443, 0x0A000001, port);
+        
+        uint32_t verdict = shedder.admit(forward.data(), forward.size());
+        for (int i = 0; i < 3; ++i) {
+            EXPECT_EQ(verdict, shedder.admit(forward.data(), forward.size()));
+            EXPECT_EQ(verdict, shedder.admit(reverse.data(), reverse.size()));
+        }
+        
+        if (verdict != 0) {
+            kept_at_4.insert(port);
+        }
+    }
+    
+    // Roughly a quarter of the flows survive
+    EXPECT_GT(kept_at_4.size(), 60u);
+    EXPECT_LT(kept_at_4.size(), 140u);
+    
+    // Shedding more only drops flows, it never picks up new ones
+    shedder.update(100, 100, now + std::chrono::seconds(2));
+    ASSERT_EQ(8u, shedder.get_rate());
+    
+    for (uint16_t port = 10000; port < 10400; ++port) {
+        auto frame = makeUdpFrame(0x0A000001, port, 0x0A000002, 443);
+        if (shedder.admit(frame.data(), frame.size()) != 0) {
+            EXPECT_TRUE(kept_at_4.count(port) > 0);
+        }
+    }
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "capture/multi_capture.h"
+#include "test_helpers.h"
+#include <algorithm>
+#include <fstream>
+
+namespace wireshark_mcp {
+namespace test {
+
+// Write a classic pcap file of 60-byte frames at the given microsecond
+// timestamps; the first payload byte records the file id
+static void writeTimedPcap(const std::string& path, uint8_t id, const std::vector<uint64_t>& times_us) {
+    std::ofstream file(path, std::ios::binary);
+    
+    const uint32_t global_header[] = {0xa1b2c3d4, 0x00040002, 0, 0, 65535, 1};
+    file.write(reinterpret_cast<const char*>(global_header), 24);
+    
+    for (uint64_t ts : times_us) {
+        const uint32_t record[] = {
+            static_cast<uint32_t>(ts / 1000000), static_cast<uint32_t>(ts % 1000000), 60, 60
+        };
+        file.write(reinterpret_cast<const char*>(record), sizeof(record));
+        
+        std::vector<char> frame(60, static_cast<char>(id));
+        file.write(frame.data(), frame.size());
+    }
+}
+
+TEST(MultiCaptureTest, ParseDeviceList) {
+    auto devices = parse_device_list(" eth0, eth1 ,,eth2");
+    ASSERT_EQ(3u, devices.size());
+    EXPECT_EQ("eth0", devices[0]);
+    EXPECT_EQ("eth1", devices[1]);
+    EXPECT_EQ("eth2", devices[2]);
+    
+    EXPECT_TRUE(parse_device_list("").empty());
+}
+
+TEST(MultiCaptureTest, MergesFilesInTimestampOrder) {
+    TempFile first("multi_capture_a.pcap");
+    TempFile second("multi_capture_b.pcap");
+    writeTimedPcap(first.path(), 1, {1000000, 1000300, 1000600, 1000900});
+    writeTimedPcap(second.path(), 2, {1000100, 1000200, 1000700, 1001000, 1001100});
+    
+    MultiCapture capture;
+    ASSERT_TRUE(capture.initialize_files({first.path(), second.path()}, CaptureOptions()));
+    ASSERT_TRUE(capture.start_capture());
+    
+    std::vector<uint64_t> timestamps;
+    std::vector<size_t> sources;
+    Packet packet;
+    size_t source = 0;
+    
+    while (capture.is_capturing()) {
+        if (capture.get_next_packet(packet, &source)) {
+            timestamps.push_back(packet.timestamp);
+            sources.push_back(source);
+            EXPECT_EQ(static_cast<uint8_t>(source + 1), packet.data[0]);
+        }
+    }
+    
+    ASSERT_EQ(9u, timestamps.size());
+    EXPECT_TRUE(std::is_sorted(timestamps.begin(), timestamps.end()));
+    EXPECT_EQ(0u, capture.get_late_packets());
+    EXPECT_EQ(9u, capture.get_stats().packets_received);
+}
+
+TEST(MultiCaptureTest, RejectsEmptySourceList) {
+    MultiCapture capture;
+    EXPECT_FALSE(capture.initialize({}, CaptureOptions()));
+    EXPECT_FALSE(capture.get_error().empty());
+    EXPECT_FALSE(capture.start_capture());
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,115 @@
+#include "gtest/gtest.h"
+#include "common/packet_buffer.h"
+#include <thread>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+TEST(PacketBufferTest, CopySharesBuffer) {
+    PacketBufferPool pool(256, 4);
+    const uint8_t bytes[] = {0x01, 0x02, 0x03, 0x04};
+    
+    PacketBuffer first = pool.copy(bytes, sizeof(bytes));
+    PacketBuffer second = first;
+    
+    EXPECT_EQ(first.data(), second.data());
+    EXPECT_EQ(2u, first.use_count());
+    EXPECT_EQ(4u, second.size());
+    EXPECT_EQ(0x03, second[2]);
+    
+    second.clear();
+    EXPECT_EQ(1u, first.use_count());
+    EXPECT_TRUE(second.empty());
+}
+
+TEST(PacketBufferTest, BuffersReturnToPool) {
+    PacketBufferPool pool(256, 2);
+    
+    const uint8_t* address = nullptr;
+    {
+        PacketBuffer buffer = pool.allocate(100);
+        address = buffer.data();
+    }
+    
+    // The released slot is handed out again; nothing spilled to the heap
+    PacketBuffer again = pool.allocate(100);
+    EXPECT_EQ(address, again.data());
+    EXPECT_EQ(0u, pool.get_heap_fallbacks());
+}
+
+TEST(PacketBufferTest, OversizeAndExhaustionFallBackToHeap) {
+    PacketBufferPool pool(64, 1);
+    
+    PacketBuffer big = pool.allocate(1500);
+    EXPECT_EQ(1500u, big.size());
+    EXPECT_EQ(1u, pool.get_heap_fallbacks());
+    
+    PacketBuffer slot = pool.allocate(10);
+    PacketBuffer extra = pool.allocate(10);
+    EXPECT_NE(slot.data(), extra.data());
+    EXPECT_EQ(2u, pool.get_heap_fallbacks());
+}
+
+TEST(PacketBufferTest, AssignReusesUniqueBuffer) {
+    PacketBufferPool pool(256, 4);
+    const uint8_t first[] = {1, 2, 3};
+    const uint8_t second[] = {9, 8};
+    
+    PacketBuffer buffer = pool.copy(first, sizeof(first));
+    const uint8_t* address = buffer.data();
+    
+    buffer.assign(second, second + sizeof(second));
+    EXPECT_EQ(address, buffer.data());
+    EXPECT_EQ(std::vector<uint8_t>({9, 8}), buffer.to_vector());
+    
+    // A shared buffer must not be overwritten
+    PacketBuffer shared = buffer;
+    buffer.assign(first, first + sizeof(first));
+    EXPECT_NE(address, buffer.data());
+    EXPECT_EQ(std::vector<uint8_t>({9, 8}), shared.to_vector());
+}
+
+TEST(PacketBufferTest, ConcurrentAllocateRelease) {
+    PacketBufferPool pool(128, 64);
+    
+    auto churn = [&pool]() {
+        std::vector<PacketBuffer> held;
+        for (int i = 0; i < 20000; ++i) {
+            held.push_back(pool.allocate(64));
+            if (held.size() > 8) {
+                held.erase(held.begin(), held.begin() + 4);
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back(churn);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    // Every slot is back on the free list
+    std::vector<PacketBuffer> all;
+    for (int i = 0; i < 64; ++i) {
+        all.push_back(pool.allocate(64));
+    }
+    EXPECT_EQ(0u, pool.get_heap_fallbacks());
+}
+
+TEST(PacketBufferTest, NumaPlacedPoolServesBuffers) {
+    // Placement is best effort: on a machine without node 0 support the pool
+    // reports no node but must work the same
+    PacketBufferPool pool(256, 8, 0);
+    EXPECT_TRUE(pool.get_numa_node() == 0 || pool.get_numa_node() == -1);
+    
+    const uint8_t bytes[] = {0x0a, 0x0b};
+    PacketBuffer buffer = pool.copy(bytes, sizeof(bytes));
+    EXPECT_EQ(0x0b, buffer[1]);
+    EXPECT_EQ(0u, pool.get_heap_fallbacks());
+}
+
+} // namespace test
+} // namespace wireshark_mcp
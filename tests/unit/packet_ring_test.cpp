@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+#include "capture/packet_ring.h"
+#include <thread>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+TEST(PacketRingTest, CapacityRoundsUpToPowerOfTwo) {
+    PacketRing<int> ring(100);
+    EXPECT_EQ(128u, ring.capacity());
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(PacketRingTest, PushPopInOrder) {
+    PacketRing<int> ring(4);
+    
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.try_push([i](int& slot) { slot = i; }));
+    }
+    
+    // Full ring rejects further pushes
+    EXPECT_FALSE(ring.try_push([](int& slot) { slot = 99; }));
+    EXPECT_EQ(4u, ring.size());
+    
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.try_pop(value));
+        EXPECT_EQ(i, value);
+    }
+    
+    EXPECT_FALSE(ring.try_pop(value));
+}
+
+TEST(PacketRingTest, DiscardDropsOldest) {
+    PacketRing<int> ring(2);
+    ASSERT_TRUE(ring.try_push([](int& slot) { slot = 1; }));
+    ASSERT_TRUE(ring.try_push([](int& slot) { slot = 2; }));
+    
+    EXPECT_TRUE(ring.try_discard());
+    ASSERT_TRUE(ring.try_push([](int& slot) { slot = 3; }));
+    
+    int value = 0;
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(2, value);
+    ASSERT_TRUE(ring.try_pop(value));
+    EXPECT_EQ(3, value);
+}
+
+TEST(PacketRingTest, PopRecyclesBuffers) {
+    PacketRing<std::vector<uint8_t>> ring(2);
+    
+    std::vector<uint8_t> consumer_buffer;
+    consumer_buffer.reserve(1500);
+    const uint8_t* original = consumer_buffer.data();
+    
+    ASSERT_TRUE(ring.try_push([](std::vector<uint8_t>& slot) { slot.assign(64, 0xAB); }));
+    ASSERT_TRUE(ring.try_pop(consumer_buffer));
+    EXPECT_EQ(64u, consumer_buffer.size());
+    
+    // The consumer's previous allocation now lives in the ring
+    ASSERT_TRUE(ring.try_push([](std::vector<uint8_t>&) {}));
+    ASSERT_TRUE(ring.try_push([original](std::vector<uint8_t>& slot) {
+        EXPECT_EQ(original, slot.data());
+    }));
+}
+
+TEST(PacketRingTest, ProducerConsumerThreads) {
+    constexpr uint64_t COUNT = 200000;
+    PacketRing<uint64_t> ring(1024);
+    
+    std::thread producer([&ring]() {
+        for (uint64_t i = 0; i < COUNT; ++i) {
+            while (!ring.try_push([i](uint64_t& slot) { slot = i; })) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    
+    uint64_t expected = 0;
+    uint64_t value = 0;
+    while (expected < COUNT) {
+        if (ring.try_pop(value)) {
+            ASSERT_EQ(expected, value);
+            ++expected;
+        }
+    }
+    
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "capture/packet_slicer.h"
+#include "test_helpers.h"
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+TEST(PacketSlicerTest, DefaultKeepsWholeFrame) {
+    PacketSlicer slicer;
+    auto frame = makeIpv4Frame(6, 40000, 80, 1000);
+    
+    EXPECT_EQ(frame.size(), slicer.slice_length(frame.data(), frame.size()));
+}
+
+TEST(PacketSlicerTest, HeadersOnlyForBulkTcp) {
+    PacketSlicer slicer;
+    slicer.set_default_payload(0);
+    
+    auto frame = makeIpv4Frame(6, 40000, 80, 1400);
+    EXPECT_EQ(14u + 20u + 20u, slicer.slice_length(frame.data(), frame.size()));
+}
+
+TEST(PacketSlicerTest, RulesMatchEitherPort) {
+    std::vector<SliceRule> rules;
+    std::string error;
+    ASSERT_TRUE(parse_slice_rules("udp/53:all, tcp/443:128", rules, error));
+    
+    PacketSlicer slicer;
+    slicer.set_rules(rules);
+    slicer.set_default_payload(0);
+    
+    // DNS response: source port matches, kept whole
+    auto dns = makeIpv4Frame(17, 53, 51000, 300);
+    EXPECT_EQ(dns.size(), slicer.slice_length(dns.data(), dns.size()));
+    
+    // TLS: headers plus 128 payload bytes
+    auto tls = makeIpv4Frame(6, 51000, 443, 1400);
+    EXPECT_EQ(14u + 20u + 20u + 128u, slicer.slice_length(tls.data(), tls.size()));
+    
+    // Short TLS record is not padded
+    auto short_tls = makeIpv4Frame(6, 443, 51000, 50);
+    EXPECT_EQ(short_tls.size(), slicer.slice_length(short_tls.data(), short_tls.size()));
+}
+
+TEST(PacketSlicerTest, LaterFragmentsGetTheLargestBudget) {
+    std::vector<SliceRule> rules;
+    std::string error;
+    ASSERT_TRUE(parse_slice_rules("udp/53:all, tcp/443:128", rules, error));
+    
+    PacketSlicer slicer;
+    slicer.set_rules(rules);
+    slicer.set_default_payload(0);
+    
+    // Second fragment of a large DNS response: no UDP header, kept whole
+    auto dns = makeIpv4Frame(17, 0, 0, 1400);
+    dns[14 + 7] = 0xB9;     // Fragment offset 1480 bytes
+    EXPECT_EQ(dns.size(), slicer.slice_length(dns.data(), dns.size()));
+    
+    // TCP fragments get the 443 budget, counted from the end of the IP header
+    auto tcp = makeIpv4Frame(6, 0, 0, 1400);
+    tcp[14 + 7] = 0xB9;
+    EXPECT_EQ(14u + 20u + 128u, slicer.slice_length(tcp.data(), tcp.size()));
+    
+    // A catch-all ahead of the port rules decides for every fragment
+    ASSERT_TRUE(parse_slice_rules("udp:16, udp/53:all", rules, error));
+    slicer.set_rules(rules);
+    EXPECT_EQ(14u + 20u + 16u, slicer.slice_length(dns.data(), dns.size()));
+}
+
+TEST(PacketSlicerTest, VlanTaggedFrame) {
+    PacketSlicer slicer;
+    slicer.set_default_payload(0);
+    
+    // Insert an 802.1Q tag in front of the IPv4 ethertype
+    auto frame = makeIpv4Frame(17, 1234, 5678, 500);
+    const uint8_t tag[] = {0x81, 0x00, 0x00, 0x64};
+    frame.insert(frame.begin() + 12, tag, tag + 4);
+    
+    EXPECT_EQ(14u + 4u + 20u + 8u, slicer.slice_length(frame.data(), frame.size()));
+}
+
+TEST(PacketSlicerTest, NonIpAndTruncatedFramesKept) {
+    PacketSlicer slicer;
+    slicer.set_default_payload(0);
+    
+    // ARP
+    std::vector<uint8_t> arp(60, 0);
+    arp[12] = 0x08;
+    arp[13] = 0x06;
+    EXPECT_EQ(arp.size(), slicer.slice_length(arp.data(), arp.size()));
+    
+    // Snaplen cut inside the IP header
+    auto frame = makeIpv4Frame(6, 1, 2, 100);
+    EXPECT_EQ(20u, slicer.slice_length(frame.data(), 20));
+}
+
+TEST(PacketSlicerTest, RejectsMalformedRules) {
+    std::vector<SliceRule> rules;
+    std::string error;
+    
+    EXPECT_FALSE(parse_slice_rules("tcp/443", rules, error));
+    EXPECT_FALSE(error.empty());
+    EXPECT_FALSE(parse_slice_rules("bogus:10", rules, error));
+    EXPECT_FALSE(parse_slice_rules("tcp/70000:10", rules, error));
+    EXPECT_FALSE(parse_slice_rules("udp:-5", rules, error));
+    
+    EXPECT_TRUE(parse_slice_rules("", rules, error));
+    EXPECT_TRUE(rules.empty());
+}
+
+} // namespace test
+} // namespace wireshark_mcp
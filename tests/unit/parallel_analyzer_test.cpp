@@ -0,0 +1,184 @@
+#include "gtest/gtest.h"
+#include "analysis/parallel_analyzer.h"
+#include "capture/load_shedder.h"
+#include "test_helpers.h"
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+// Ethernet/IPv4/UDP frame between two hosts of 10.0.0.0/24
+static Packet makeUdpPacket(uint64_t timestamp, uint8_t host_a, uint16_t port_a,
+                            uint8_t host_b, uint16_t port_b) {
+    std::vector<uint8_t> frame = makeUdpFrame(0x0A000000 | host_a, port_a, 0x0A000000 | host_b, port_b, 4);
+    
+    Packet packet;
+    packet.timestamp = timestamp;
+    packet.data.assign(frame.data(), frame.data() + frame.size());
+    packet.actual_length = frame.size();
+    packet.captured_length = frame.size();
+    return packet;
+}
+
+// Records which thread dissected each UDP port pair
+class ThreadProbe : public ProtocolDecoder {
+public:
+    ThreadProbe(std::mutex& mutex, std::map<std::pair<uint16_t, uint16_t>, std::thread::id>& threads,
+                bool& mixed)
+        : m_mutex(mutex), m_threads(threads), m_mixed(mixed) {}
+    
+    std::string get_protocol_name() const override { return "probe"; }
+    std::vector<DispatchTable> get_heuristic_tables() const override { return {DispatchTable::UDP_PORT}; }
+    bool can_decode(const LayerSpan&, const DecodedPacket&) const override { return true; }
+    
+    bool decode(LayerSpan& span, DecodedPacket&) override {
+        const uint8_t* udp = span.data - 8;
+        uint16_t a = static_cast<uint16_t>((udp[0] << 8) | udp[1]);
+        uint16_t b = static_cast<uint16_t>((udp[2] << 8) | udp[3]);
+        auto ports = std::make_pair(std::min(a, b), std::max(a, b));
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto inserted = m_threads.emplace(ports, std::this_thread::get_id());
+        if (inserted.first->second != std::this_thread::get_id()) {
+            m_mixed = true;
+        }
+        return true;
+    }
+
+private:
+    std::mutex& m_mutex;
+    std::map<std::pair<uint16_t, uint16_t>, std::thread::id>& m_threads;
+    bool& m_mixed;
+};
+
+TEST(ParallelAnalyzerTest, DeliversInSubmissionOrder) {
+    ParallelAnalyzerOptions options;
+    options.workers = 4;
+    options.reorder_window = 64;    // Small enough for submit() to block
+    
+    uint64_t expected = 0;
+    bool in_order = true;
+    bool decoded_all = true;
+    
+    ParallelAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.start(options, [&](uint64_t sequence, const DecodedPacket& decoded) {
+        in_order = in_order && sequence == expected && decoded.raw_packet.timestamp == expected;
+        decoded_all = decoded_all && decoded.highest_protocol == "udp";
+        ++expected;
+    }));
+    EXPECT_EQ(4u, analyzer.get_worker_count());
+    
+    const uint64_t count = 20000;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint16_t flow = static_cast<uint16_t>(i % 97);
+        EXPECT_EQ(i, analyzer.submit(makeUdpPacket(i, 1, 1024 + flow, 2, 53)));
+    }
+    
+    analyzer.flush();
+    EXPECT_EQ(count, analyzer.get_delivered());
+    EXPECT_EQ(count, expected);
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(decoded_all);
+    
+    // Every worker got a share of the 97 flows
+    uint64_t total = 0;
+    for (size_t i = 0; i < analyzer.get_worker_count(); ++i) {
+        EXPECT_GT(analyzer.get_worker_packets(i), 0u);
+        total += analyzer.get_worker_packets(i);
+    }
+    EXPECT_EQ(count, total);
+    
+    analyzer.stop();
+    EXPECT_FALSE(analyzer.is_running());
+}
+
+TEST(ParallelAnalyzerTest, BothDirectionsOfAFlowShareAWorker) {
+    std::mutex mutex;
+    std::map<std::pair<uint16_t, uint16_t>, std::thread::id> threads;
+    bool mixed = false;
+    
+    ParallelAnalyzerOptions options;
+    options.workers = 3;
+    
+    ParallelAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.start(options, [](uint64_t, const DecodedPacket&) {}, [&]() {
+        auto worker_analyzer = std::make_unique<ProtocolAnalyzer>();
+        worker_analyzer->register_decoder(std::make_shared<ThreadProbe>(mutex, threads, mixed));
+        return worker_analyzer;
+    }));
+    
+    for (uint64_t i = 0; i < 6000; ++i) {
+        uint16_t client_port = static_cast<uint16_t>(40000 + i % 200);
+        if (i % 2 == 0) {
+            analyzer.submit(makeUdpPacket(i, 1, client_port, 2, 5000));
+        } else {
+            analyzer.submit(makeUdpPacket(i, 2, 5000, 1, client_port));
+        }
+    }
+    
+    analyzer.stop();
+    EXPECT_EQ(200u, threads.size());
+    EXPECT_FALSE(mixed);
+}
+
+TEST(ParallelAnalyzerTest, StopDeliversPendingPackets) {
+    uint64_t delivered = 0;
+    
+    ParallelAnalyzerOptions options;
+    options.workers = 2;
+    
+    ParallelAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.start(options, [&](uint64_t, const DecodedPacket&) { ++delivered; }));
+    
+    for (uint64_t i = 0; i < 1000; ++i) {
+        analyzer.submit(makeUdpPacket(i, 1, 1000, 2, 2000));
+    }
+    
+    analyzer.stop();
+    EXPECT_EQ(1000u, delivered);
+    
+    // Restartable, with the sequence starting over
+    ASSERT_TRUE(analyzer.start(options, [](uint64_t, const DecodedPacket&) {}));
+    EXPECT_EQ(0u, analyzer.submit(makeUdpPacket(0, 1, 1000, 2, 2000)));
+}
+
+TEST(ParallelAnalyzerTest, ShedStreamStillSpreadsOverWorkers) {
+    LoadShedder shedder;
+    shedder.configure(SheddingMode::FLOW, 0.5, 0.1, 8);
+    
+    auto now = std::chrono::steady_clock::now();
+    for (int i = 0; i < 3; ++i) {
+        shedder.update(100, 100, now + std::chrono::seconds(i));
+    }
+    ASSERT_EQ(8u, shedder.get_rate());
+    
+    ParallelAnalyzerOptions options;
+    options.workers = 4;
+    
+    ParallelAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.start(options, [](uint64_t, const DecodedPacket&) {}));
+    
+    uint64_t kept = 0;
+    for (uint64_t i = 0; i < 8000; ++i) {
+        Packet packet = makeUdpPacket(i, 1, static_cast<uint16_t>(20000 + i % 1000), 2, 53);
+        if (shedder.admit(packet.data.data(), packet.data.size()) != 0) {
+            analyzer.submit(packet);
+            ++kept;
+        }
+    }
+    analyzer.flush();
+    
+    // Sampling must not pick flows that all hash to the same worker
+    ASSERT_GT(kept, 0u);
+    for (size_t i = 0; i < analyzer.get_worker_count(); ++i) {
+        EXPECT_GT(analyzer.get_worker_packets(i), kept / 8) << "worker " << i;
+    }
+    
+    analyzer.stop();
+}
+
+} // namespace test
+} // namespace wireshark_mcp
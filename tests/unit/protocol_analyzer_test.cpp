@@ -0,0 +1,291 @@
+#include "gtest/gtest.h"
+#include "analysis/protocol_analyzer.h"
+#include <memory>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+// Decoder that claims fixed keys, consumes a fixed header and names a
+// fixed payload
+class StubDecoder : public ProtocolDecoder {
+public:
+    StubDecoder(std::string name, std::vector<DispatchKey> keys, std::vector<DispatchKey> next,
+                std::vector<DispatchTable> heuristic_tables = {}, size_t header_length = 0)
+        : m_name(std::move(name)), m_keys(std::move(keys)), m_next(std::move(next)),
+          m_heuristic_tables(std::move(heuristic_tables)), m_header_length(header_length) {}
+    
+    std::string get_protocol_name() const override { return m_name; }
+    std::vector<DispatchKey> get_dispatch_keys() const override { return m_keys; }
+    std::vector<DispatchTable> get_heuristic_tables() const override { return m_heuristic_tables; }
+    
+    bool can_decode(const LayerSpan&, const DecodedPacket&) const override {
+        ++probes;
+        return accept_heuristic;
+    }
+    
+    bool decode(LayerSpan& span, DecodedPacket& decoded) override {
+        ++decodes;
+        if (span.length < m_header_length) {
+            return false;
+        }
+        
+        if (field_id != INVALID_FIELD_ID) {
+            decoded.add_field(field_id, span.offset, m_header_length, span.length);
+        }
+        
+        first_byte = span.length > 0 ? span.data[0] : -1;
+        seen_length = span.length;
+        span.consume(m_header_length);
+        if (payload_length > 0) {
+            span.truncate(payload_length);
+        }
+        
+        decoded.next_protocols = m_next;
+        return true;
+    }
+    
+    bool accept_heuristic = true;
+    FieldId field_id = INVALID_FIELD_ID;   // Recorded over the header when set
+    size_t payload_length = 0;
+    mutable int probes = 0;
+    int decodes = 0;
+    int first_byte = -1;
+    size_t seen_length = 0;
+
+private:
+    std::string m_name;
+    std::vector<DispatchKey> m_keys;
+    std::vector<DispatchKey> m_next;
+    std::vector<DispatchTable> m_heuristic_tables;
+    size_t m_header_length;
+};
+
+class ProtocolAnalyzerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        analyzer.register_decoder(std::make_shared<StubDecoder>(
+            "eth", std::vector<DispatchKey>{{DispatchTable::LINK_TYPE, DLT_EN10MB}},
+            std::vector<DispatchKey>{{DispatchTable::ETHERTYPE, 0x0800}}));
+        analyzer.register_decoder(std::make_shared<StubDecoder>(
+            "ip", std::vector<DispatchKey>{{DispatchTable::ETHERTYPE, 0x0800}},
+            std::vector<DispatchKey>{{DispatchTable::IP_PROTOCOL, 17}}));
+        analyzer.register_decoder(std::make_shared<StubDecoder>(
+            "udp", std::vector<DispatchKey>{{DispatchTable::IP_PROTOCOL, 17}},
+            std::vector<DispatchKey>{{DispatchTable::UDP_PORT, 53}, {DispatchTable::UDP_PORT, 40000}}));
+        
+        packet.timestamp = 0;
+        packet.actual_length = 0;
+        packet.captured_length = 0;
+    }
+    
+    ProtocolAnalyzer analyzer;
+    Packet packet;
+    DecodedPacket decoded;
+};
+
+TEST_F(ProtocolAnalyzerTest, ChainsLayersByKey) {
+    auto dns = std::make_shared<StubDecoder>(
+        "dns", std::vector<DispatchKey>{{DispatchTable::UDP_PORT, 53}}, std::vector<DispatchKey>{});
+    analyzer.register_decoder(dns);
+    
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ((std::vector<std::string>{"eth", "ip", "udp", "dns"}), decoded.protocol_stack);
+    EXPECT_EQ("dns", decoded.highest_protocol);
+    EXPECT_EQ(1, dns->decodes);
+    EXPECT_EQ(0, dns->probes);
+}
+
+TEST_F(ProtocolAnalyzerTest, UnrelatedDecodersAreNeverConsulted) {
+    auto arp = std::make_shared<StubDecoder>(
+        "arp", std::vector<DispatchKey>{{DispatchTable::ETHERTYPE, 0x0806}}, std::vector<DispatchKey>{});
+    analyzer.register_decoder(arp);
+    
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ("udp", decoded.highest_protocol);
+    EXPECT_EQ(0, arp->decodes);
+    EXPECT_EQ(0, arp->probes);
+}
+
+TEST_F(ProtocolAnalyzerTest, HeuristicsRunWhenNoKeyMatches) {
+    auto quic = std::make_shared<StubDecoder>(
+        "quic", std::vector<DispatchKey>{}, std::vector<DispatchKey>{},
+        std::vector<DispatchTable>{DispatchTable::UDP_PORT});
+    analyzer.register_decoder(quic);
+    
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ("quic", decoded.highest_protocol);
+    EXPECT_EQ(1, quic->probes);
+    
+    // A rejecting heuristic leaves the stack at the transport layer
+    quic->accept_heuristic = false;
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ("udp", decoded.highest_protocol);
+}
+
+TEST_F(ProtocolAnalyzerTest, DisabledDecodersAreSkipped) {
+    auto dns = std::make_shared<StubDecoder>(
+        "dns", std::vector<DispatchKey>{{DispatchTable::UDP_PORT, 53}}, std::vector<DispatchKey>{});
+    auto other = std::make_shared<StubDecoder>(
+        "other", std::vector<DispatchKey>{{DispatchTable::UDP_PORT, 40000}}, std::vector<DispatchKey>{});
+    analyzer.register_decoder(dns);
+    analyzer.register_decoder(other);
+    
+    analyzer.set_decoder_enabled("dns", false);
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ("other", decoded.highest_protocol);
+    
+    analyzer.set_decoder_enabled("ip", false);
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ((std::vector<std::string>{"eth"}), decoded.protocol_stack);
+}
+
+TEST(ProtocolAnalyzerLayerTest, LayersConsumeHeadersInOnePass) {
+    ProtocolAnalyzer analyzer;
+    
+    auto eth = std::make_shared<StubDecoder>(
+        "eth", std::vector<DispatchKey>{{DispatchTable::LINK_TYPE, DLT_EN10MB}},
+        std::vector<DispatchKey>{{DispatchTable::ETHERTYPE, 0x0800}}, std::vector<DispatchTable>{}, 14);
+    auto ip = std::make_shared<StubDecoder>(
+        "ip", std::vector<DispatchKey>{{DispatchTable::ETHERTYPE, 0x0800}},
+        std::vector<DispatchKey>{{DispatchTable::IP_PROTOCOL, 6}}, std::vector<DispatchTable>{}, 20);
+    auto tcp = std::make_shared<StubDecoder>(
+        "tcp", std::vector<DispatchKey>{{DispatchTable::IP_PROTOCOL, 6}},
+        std::vector<DispatchKey>{{DispatchTable::TCP_PORT, 80}}, std::vector<DispatchTable>{}, 20);
+    auto http = std::make_shared<StubDecoder>(
+        "http", std::vector<DispatchKey>{{DispatchTable::TCP_PORT, 80}},
+        std::vector<DispatchKey>{}, std::vector<DispatchTable>{}, 0);
+    
+    // The IP layer trims the 6 bytes of Ethernet padding off its payload
+    ip->payload_length = 20 + 10;
+    
+    analyzer.register_decoder(eth);
+    analyzer.register_decoder(ip);
+    analyzer.register_decoder(tcp);
+    analyzer.register_decoder(http);
+    
+    std::vector<uint8_t> bytes(14 + 20 + 20 + 10 + 6);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(i);
+    }
+    
+    Packet packet;
+    packet.timestamp = 0;
+    packet.data.assign(bytes.data(), bytes.data() + bytes.size());
+    packet.actual_length = bytes.size();
+    packet.captured_length = bytes.size();
+    
+    DecodedPacket decoded;
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    ASSERT_EQ(4u, decoded.layers.size());
+    
+    EXPECT_EQ("tcp", decoded.layers[2].protocol);
+    EXPECT_EQ(34u, decoded.layers[2].offset);
+    EXPECT_EQ(20u, decoded.layers[2].length);
+    
+    // Each layer saw the packet from its own offset, with no copy in between
+    EXPECT_EQ(0, eth->first_byte);
+    EXPECT_EQ(14, ip->first_byte);
+    EXPECT_EQ(54, http->first_byte);
+    EXPECT_EQ(10u, http->seen_length);
+    EXPECT_EQ(0u, decoded.layers[3].length);
+    EXPECT_EQ("http", decoded.highest_protocol);
+}
+
+TEST(FieldRegistryTest, InternsNamesOnce) {
+    auto& registry = FieldRegistry::instance();
+    
+    FieldId id = registry.intern("test.intern", FieldType::UNSIGNED, "Interned field");
+    EXPECT_NE(INVALID_FIELD_ID, id);
+    EXPECT_EQ(id, registry.intern("test.intern", FieldType::HEX));
+    EXPECT_EQ(id, registry.find("test.intern"));
+    EXPECT_EQ(INVALID_FIELD_ID, registry.find("test.never_registered"));
+    
+    EXPECT_EQ("Interned field", registry.get(id).description);
+    EXPECT_EQ(FieldType::UNSIGNED, registry.get(id).type);
+}
+
+TEST(FieldRegistryTest, FormatsValuesByType) {
+    const uint8_t mac[] = {0x00, 0x1b, 0x21, 0xaa, 0xbb, 0x0c};
+    const uint8_t ipv4[] = {192, 0, 2, 17};
+    const uint8_t ipv6[] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    const uint8_t text[] = {'G', 'E', 'T', 0x0d};
+    
+    EXPECT_EQ("443", format_field_value(FieldType::UNSIGNED, nullptr, 0, 443));
+    EXPECT_EQ("0x800", format_field_value(FieldType::HEX, nullptr, 0, 0x0800));
+    EXPECT_EQ("true", format_field_value(FieldType::BOOLEAN, nullptr, 0, 1));
+    EXPECT_EQ("00:1b:21:aa:bb:0c", format_field_value(FieldType::MAC, mac, 6, 0));
+    EXPECT_EQ("192.0.2.17", format_field_value(FieldType::IPV4, ipv4, 4, 0));
+    EXPECT_EQ("2001:db8:0:0:0:0:0:1", format_field_value(FieldType::IPV6, ipv6, 16, 0));
+    EXPECT_EQ("GET.", format_field_value(FieldType::TEXT, text, 4, 0));
+    EXPECT_EQ("c0000211", format_field_value(FieldType::BYTES, ipv4, 4, 0));
+    
+    // Truncated fixed-size values fall back to raw bytes
+    EXPECT_EQ("c00002", format_field_value(FieldType::IPV4, ipv4, 3, 0));
+}
+
+TEST_F(ProtocolAnalyzerTest, FieldsAreRenderedOnDemand) {
+    auto dns = std::make_shared<StubDecoder>(
+        "dns", std::vector<DispatchKey>{{DispatchTable::UDP_PORT, 53}}, std::vector<DispatchKey>{},
+        std::vector<DispatchTable>{}, 4);
+    dns->field_id = FieldRegistry::instance().intern("test.dns_header", FieldType::BYTES, "DNS header");
+    analyzer.register_decoder(dns);
+    
+    const uint8_t bytes[] = {0xab, 0xcd, 0x01, 0x00, 0x00};
+    packet.data.assign(bytes, bytes + sizeof(bytes));
+    
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    const PacketField* field = decoded.find_field(dns->field_id);
+    ASSERT_NE(nullptr, field);
+    
+    EXPECT_EQ(0u, field->offset);
+    EXPECT_EQ(4u, field->length);
+    EXPECT_EQ("test.dns_header", field_name(*field));
+    EXPECT_EQ("DNS header", field_description(*field));
+    EXPECT_EQ("abcd0100", field_value(*field, decoded));
+    
+    // A reused DecodedPacket keeps its field storage
+    const PacketField* storage = decoded.fields.data();
+    ASSERT_TRUE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_EQ(storage, decoded.fields.data());
+}
+
+TEST(ProtocolAnalyzerBatchTest, CountsDecodedPacketsAndClampsCount) {
+    ProtocolAnalyzer analyzer;
+    analyzer.register_decoder(std::make_shared<StubDecoder>(
+        "eth", std::vector<DispatchKey>{{DispatchTable::LINK_TYPE, DLT_EN10MB}},
+        std::vector<DispatchKey>{}, std::vector<DispatchTable>{}, 14));
+    
+    // Frames shorter than the Ethernet header fail to decode
+    std::vector<Packet> packets(3);
+    const size_t lengths[] = {60, 4, 14};
+    for (size_t i = 0; i < packets.size(); ++i) {
+        std::vector<uint8_t> frame(lengths[i], 0);
+        packets[i].timestamp = i;
+        packets[i].data.assign(frame.data(), frame.data() + frame.size());
+        packets[i].actual_length = frame.size();
+        packets[i].captured_length = frame.size();
+    }
+    
+    std::vector<DecodedPacket> decoded;
+    EXPECT_EQ(1u, analyzer.analyze_packets(packets, 2, decoded));
+    ASSERT_EQ(2u, decoded.size());
+    EXPECT_EQ("eth", decoded[0].highest_protocol);
+    EXPECT_TRUE(decoded[1].protocol_stack.empty());
+    
+    // A count past the end of the batch is clamped to its size
+    EXPECT_EQ(2u, analyzer.analyze_packets(packets, 10, decoded));
+    ASSERT_EQ(3u, decoded.size());
+    EXPECT_EQ("eth", decoded[2].highest_protocol);
+    
+    EXPECT_EQ(0u, analyzer.analyze_packets(packets, 0, decoded));
+}
+
+TEST_F(ProtocolAnalyzerTest, UnknownLinkTypeDecodesNothing) {
+    analyzer.set_link_type(DLT_RAW);
+    EXPECT_FALSE(analyzer.analyze_packet(packet, decoded));
+    EXPECT_TRUE(decoded.protocol_stack.empty());
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace wireshark_mcp {
+namespace test {
+
+// Path of a scratch file in the system temp directory, removed when the
+// object goes out of scope, so a failed assertion does not leak it
+class TempFile {
+public:
+    explicit TempFile(const std::string& name)
+        : m_path((std::filesystem::temp_directory_path() / name).string()) {}
+    
+    ~TempFile() {
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+    
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    
+    const std::string& path() const { return m_path; }
+
+private:
+    std::string m_path;
+};
+
+// Ethernet/IPv4 frame for tests: a 14-byte Ethernet header, a 20-byte IPv4
+// header with its lengths and checksum filled in, a 20-byte TCP header
+// (ip_protocol 6) or an 8-byte UDP-style header, then the payload
+struct TestFrame {
+    uint8_t ip_protocol = 17;
+    uint32_t src_ip = 0x0A000001;       // 10.0.0.1
+    uint32_t dst_ip = 0x0A000002;       // 10.0.0.2
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t tcp_flags = 0;
+    uint8_t ttl = 64;
+    uint16_t ip_id = 0;
+    size_t payload_length = 0;
+    uint8_t payload_byte = 0;
+    
+    static constexpr size_t ETHERNET = 14;     // Offset of the IPv4 header
+    static constexpr size_t TRANSPORT = 34;    // Offset of the TCP/UDP header
+    
+    std::vector<uint8_t> build() const {
+        size_t l4_length = ip_protocol == 6 ? 20 : 8;
+        std::vector<uint8_t> frame(TRANSPORT + l4_length, 0);
+        frame.resize(frame.size() + payload_length, payload_byte);
+        
+        // Locally administered MACs 02:00:00:00:00:02 <- 02:00:00:00:00:01
+        frame[0] = 0x02;
+        frame[5] = 0x02;
+        frame[6] = 0x02;
+        frame[11] = 0x01;
+        frame[12] = 0x08;
+        
+        uint8_t* ip = frame.data() + ETHERNET;
+        ip[0] = 0x45;
+        put16(ip + 2, static_cast<uint16_t>(frame.size() - ETHERNET));
+        put16(ip + 4, ip_id);
+        ip[8] = ttl;
+        ip[9] = ip_protocol;
+        put32(ip + 12, src_ip);
+        put32(ip + 16, dst_ip);
+        
+        uint32_t sum = 0;
+        for (size_t i = 0; i < 20; i += 2) {
+            sum += static_cast<uint32_t>((ip[i] << 8) | ip[i + 1]);
+        }
+        sum = (sum & 0xFFFF) + (sum >> 16);
+        sum = (sum & 0xFFFF) + (sum >> 16);
+        put16(ip + 10, static_cast<uint16_t>(~sum));
+        
+        uint8_t* l4 = frame.data() + TRANSPORT;
+        put16(l4, src_port);
+        put16(l4 + 2, dst_port);
+        if (ip_protocol == 6) {
+            l4[12] = 0x50;      // Data offset 5 words
+            l4[13] = tcp_flags;
+        } else {
+            put16(l4 + 4, static_cast<uint16_t>(8 + payload_length));
+        }
+        
+        return frame;
+    }
+
+private:
+    static void put16(uint8_t* p, uint16_t value) {
+        p[0] = static_cast<uint8_t>(value >> 8);
+        p[1] = static_cast<uint8_t>(value);
+    }
+    
+    static void put32(uint8_t* p, uint32_t value) {
+        put16(p, static_cast<uint16_t>(value >> 16));
+        put16(p + 2, static_cast<uint16_t>(value));
+    }
+};
+
+// 10.0.0.1 -> 10.0.0.2 with the given transport ports and payload size
+inline std::vector<uint8_t> makeIpv4Frame(uint8_t ip_protocol, uint16_t src_port, uint16_t dst_port,
+                                          size_t payload_length) {
+    TestFrame frame;
+    frame.ip_protocol = ip_protocol;
+    frame.src_port = src_port;
+    frame.dst_port = dst_port;
+    frame.payload_length = payload_length;
+    return frame.build();
+}
+
+inline std::vector<uint8_t> makeUdpFrame(uint32_t src_ip, uint16_t src_port, uint32_t dst_ip,
+                                         uint16_t dst_port, size_t payload_length = 32) {
+    TestFrame frame;
+    frame.src_ip = src_ip;
+    frame.dst_ip = dst_ip;
+    frame.src_port = src_port;
+    frame.dst_port = dst_port;
+    frame.payload_length = payload_length;
+    return frame.build();
+}
+
+inline std::vector<uint8_t> makeTcpFrame(uint32_t src_ip, uint16_t src_port, uint32_t dst_ip,
+                                         uint16_t dst_port, uint8_t tcp_flags) {
+    TestFrame frame;
+    frame.ip_protocol = 6;
+    frame.src_ip = src_ip;
+    frame.dst_ip = dst_ip;
+    frame.src_port = src_port;
+    frame.dst_port = dst_port;
+    frame.tcp_flags = tcp_flags;
+    return frame.build();
+}
+
+} // namespace test
+} // namespace wireshark_mcp
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include "capture/traffic_generator.h"
+#include "capture/flow_key.h"
+#include <chrono>
+#include <unordered_set>
+
+namespace wireshark_mcp {
+namespace test {
+
+static uint16_t readBe16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+// Drive the generator until it has produced count frames
+static size_t generate(TrafficGenerator& generator, size_t count, const PacketVisitor& visitor) {
+    size_t total = 0;
+    while (total < count && !generator.finished()) {
+        total += static_cast<size_t>(generator.dispatch(visitor, std::min<size_t>(256, count - total), 10));
+    }
+    return total;
+}
+
+TEST(TrafficGeneratorTest, FramesAreWellFormed) {
+    CaptureOptions options;
+    options.generator_flows = 64;
+    options.generator_ipv6_share = 0.5;
+    options.generator_udp_share = 0.5;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    size_t ipv4 = 0;
+    size_t ipv6 = 0;
+    size_t udp = 0;
+    size_t tcp = 0;
+    
+    generate(generator, 2000, [&](const PacketView& view) {
+        FlowKey key;
+        ASSERT_TRUE(extract_flow_key(view.data, view.captured_length, key));
+        EXPECT_EQ(view.actual_length, view.captured_length);
+        
+        const uint8_t* ip = view.data + 14;
+        if (key.ip_version == 4) {
+            ++ipv4;
+            EXPECT_EQ(view.actual_length - 14, readBe16(ip + 2));
+            
+            // Header checksum verifies to zero
+            uint32_t sum = 0;
+            for (int i = 0; i < 20; i += 2) {
+                sum += readBe16(ip + i);
+            }
+            while (sum >> 16) {
+                sum = (sum & 0xFFFF) + (sum >> 16);
+            }
+            EXPECT_EQ(0xFFFFu, sum);
+        } else {
+            ++ipv6;
+            EXPECT_EQ(view.actual_length - 54, readBe16(ip + 4));
+        }
+        
+        if (key.ip_protocol == 17) {
+            ++udp;
+        } else {
+            EXPECT_EQ(6, key.ip_protocol);
+            ++tcp;
+        }
+    });
+    
+    EXPECT_GT(ipv4, 0u);
+    EXPECT_GT(ipv6, 0u);
+    EXPECT_GT(udp, 0u);
+    EXPECT_GT(tcp, 0u);
+}
+
+TEST(TrafficGeneratorTest, FlowCountIsRespected) {
+    CaptureOptions options;
+    options.generator_flows = 32;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    std::unordered_set<FlowKey, FlowKeyHash> flows;
+    generate(generator, 5000, [&flows](const PacketView& view) {
+        FlowKey key;
+        if (extract_flow_key(view.data, view.captured_length, key)) {
+            flows.insert(key);
+        }
+    });
+    
+    EXPECT_EQ(32u, flows.size());
+}
+
+TEST(TrafficGeneratorTest, FixedSizeAndSnapshotLength) {
+    CaptureOptions options;
+    options.generator_size_mix = FrameSizeMix::FIXED;
+    options.generator_min_frame = 256;
+    options.snapshot_length = 96;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    uint64_t bytes = 0;
+    int count = generator.dispatch([](const PacketView& view) {
+        EXPECT_EQ(256u, view.actual_length);
+        EXPECT_EQ(96u, view.captured_length);
+    }, 100, 10, &bytes);
+    
+    EXPECT_EQ(100, count);
+    EXPECT_EQ(100u * 256u, bytes);
+}
+
+TEST(TrafficGeneratorTest, StopsAfterPacketCount) {
+    CaptureOptions options;
+    options.generator_packet_count = 1000;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    size_t total = generate(generator, 5000, [](const PacketView&) {});
+    
+    EXPECT_EQ(1000u, total);
+    EXPECT_TRUE(generator.finished());
+    EXPECT_EQ(0, generator.dispatch([](const PacketView&) {}, 10, 10));
+}
+
+TEST(TrafficGeneratorTest, HoldsTargetRate) {
+    CaptureOptions options;
+    options.generator_pps = 20000;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    uint64_t first = 0;
+    uint64_t last = 0;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200)) {
+        total += static_cast<size_t>(generator.dispatch([&](const PacketView& view) {
+            if (first == 0) {
+                first = view.timestamp;
+            }
+            EXPECT_GT(view.timestamp, last);
+            last = view.timestamp;
+        }, 256, 10));
+    }
+    
+    // 200 ms at 20 kpps, with slack for a loaded machine
+    EXPECT_GT(total, 3000u);
+    EXPECT_LT(total, 4500u);
+    
+    // Timestamps follow the schedule: 50 us apart
+    EXPECT_NEAR(50000.0, static_cast<double>(last - first) / static_cast<double>(total - 1), 1.0);
+}
+
+TEST(TrafficGeneratorTest, FilterDropsFrames) {
+    CaptureOptions options;
+    options.generator_udp_share = 0.5;
+    
+    TrafficGenerator generator;
+    ASSERT_TRUE(generator.configure(options));
+    
+    // Keep UDP only
+    generator.set_filter([](const PacketView& view) { return view.data[14 + 9] == 17; });
+    
+    size_t delivered = 0;
+    generate(generator, 1000, [&delivered](const PacketView& view) {
+        EXPECT_EQ(17, view.data[14 + 9]);
+        ++delivered;
+    });
+    
+    EXPECT_EQ(1000u, delivered);
+    EXPECT_GT(generator.get_generated(), delivered);
+}
+
+TEST(TrafficGeneratorTest, RejectsBadOptions) {
+    TrafficGenerator generator;
+    CaptureOptions options;
+    
+    options.generator_flows = 0;
+    EXPECT_FALSE(generator.configure(options));
+    EXPECT_FALSE(generator.get_error().empty());
+    
+    options.generator_flows = 16;
+    options.generator_min_frame = 2000;
+    options.generator_max_frame = 1000;
+    EXPECT_FALSE(generator.configure(options));
+}
+
+} // namespace test
+} // namespace wireshark_mcp